@@ -0,0 +1,191 @@
+#include "ANF.h"
+#include "Transform.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+void initANF(ANF *anf) {
+    anf->monomials = NULL;
+    anf->size = 0;
+    anf->capacity = 0;
+}
+
+void freeANF(ANF *anf) {
+    free(anf->monomials);
+    initANF(anf);
+}
+
+int addMonomialANF(ANF *anf, uint64_t monomial) {
+    for (uint64_t i = 0; i < anf->size; ++i)
+        if (anf->monomials[i] == monomial) {
+            anf->monomials[i] = anf->monomials[--anf->size];
+            return 0;
+        }
+    if (anf->size == anf->capacity) {
+        uint64_t capacity = anf->capacity ? anf->capacity * 2 : 8;
+        uint64_t *monomials = realloc(anf->monomials, capacity * sizeof(uint64_t));
+        if (!monomials) return -1;
+        anf->monomials = monomials;
+        anf->capacity = capacity;
+    }
+    anf->monomials[anf->size++] = monomial;
+    return 0;
+}
+
+int initANFFromTruthTable(ANF *anf, uint64_t *table, uint8_t num_of_variables, uint64_t max_size) {
+    initANF(anf);
+    mobiusTransform(table, num_of_variables, 1);
+    const uint64_t num_of_points = (uint64_t)1 << num_of_variables;
+    const uint64_t last = num_of_points < 64 ? ((uint64_t)1 << num_of_points) - 1 : ~(uint64_t)0;
+    uint64_t size = 0;
+    for (uint64_t w = 0; w < (num_of_points + 63) / 64; ++w)
+        size += __builtin_popcountll(table[w] & last);
+    if (size > max_size) return -2;
+    if (size && !(anf->monomials = malloc(size * sizeof(uint64_t)))) return -1;
+    anf->capacity = size;
+    for (uint64_t w = 0; w < (num_of_points + 63) / 64; ++w)
+        for (uint64_t bits = table[w] & last; bits; bits &= bits - 1)
+            anf->monomials[anf->size++] = w * 64 + __builtin_ctzll(bits);
+    return 0;
+}
+
+uint8_t evaluateANF(const ANF *anf, uint64_t x) {
+    uint8_t value = 0;
+    for (uint64_t i = 0; i < anf->size; ++i)
+        value ^= (x & anf->monomials[i]) == anf->monomials[i];
+    return value;
+}
+
+uint64_t evaluateANFBitsliced(const ANF *anf, const uint64_t *planes) {
+    uint64_t value = 0;
+    for (uint64_t i = 0; i < anf->size; ++i) {
+        uint64_t product = ~(uint64_t)0;
+        for (uint64_t m = anf->monomials[i]; m; m &= m - 1)
+            product &= planes[__builtin_ctzll(m)];
+        value ^= product;
+    }
+    return value;
+}
+
+uint8_t getANFDegree(const ANF *anf) {
+    uint8_t degree = 0;
+    for (uint64_t i = 0; i < anf->size; ++i)
+        if (__builtin_popcountll(anf->monomials[i]) > degree)
+            degree = (uint8_t)__builtin_popcountll(anf->monomials[i]);
+    return degree;
+}
+
+static const char *skipSpaces(const char *p) {
+    while (*p && isspace((unsigned char)*p)) ++p;
+    return p;
+}
+
+// Разбирает один множитель. Возвращает указатель за ним или NULL при ошибке.
+static const char *parseFactor(
+    const char *p, const char **variables, uint8_t num_of_variables, const char *selector,
+    uint64_t *monomial, uint8_t *zero, uint8_t *selected
+) {
+    if (*p == '1' && !isalnum((unsigned char)p[1])) return p + 1;
+    if (*p == '0' && !isalnum((unsigned char)p[1])) {
+        *zero = 1;
+        return p + 1;
+    }
+    size_t best = 0;
+    int variable = -1;
+    for (uint8_t i = 0; i < num_of_variables; ++i) {
+        size_t length = strlen(variables[i]);
+        if (length > best && !strncmp(p, variables[i], length) && !isalnum((unsigned char)p[length])) {
+            best = length;
+            variable = i;
+        }
+    }
+    if (selector) {
+        size_t length = strlen(selector);
+        if (length > best && !strncmp(p, selector, length) && !isalnum((unsigned char)p[length])) {
+            best = length;
+            variable = -1;
+        }
+    }
+    if (!best) return NULL;
+    if (variable < 0) *selected = 1;
+    else *monomial |= (uint64_t)1 << variable;
+    return p + best;
+}
+
+int parseANF(
+    ANF *anf, ANF *selected, const char *text,
+    const char **variables, uint8_t num_of_variables, const char *selector
+) {
+    int return_code = 0;
+    initANF(anf);
+    if (selector) initANF(selected);
+    const char *p = skipSpaces(text);
+    if (!*p) return 0;
+    while (1) {
+        uint64_t monomial = 0;
+        uint8_t zero = 0, with_selector = 0;
+        while (1) {
+            const char *next = parseFactor(
+                p, variables, num_of_variables, selector,
+                &monomial, &zero, &with_selector
+            );
+            if (!next) {
+                printf("Ошибка при разборе многочлена: %.20s\n", p);
+                return_code = -1;
+                goto end;
+            }
+            p = skipSpaces(next);
+            if (*p != '*') break;
+            p = skipSpaces(p + 1);
+        }
+        if (!zero && addMonomialANF(with_selector ? selected : anf, monomial)) {
+            return_code = -2;
+            goto end;
+        }
+        if (!*p) return 0;
+        if (*p != '+') {
+            printf("Ошибка при разборе многочлена: %.20s\n", p);
+            return_code = -3;
+            goto end;
+        }
+        p = skipSpaces(p + 1);
+    }
+end:
+    freeANF(anf);
+    if (selector) freeANF(selected);
+    return return_code;
+}
+
+static void printMonomial(
+    uint64_t monomial, const char **variables, uint8_t num_of_variables,
+    const char *selector, FILE *fp
+) {
+    uint8_t first = 1;
+    if (selector) {
+        fprintf(fp, "%s", selector);
+        first = 0;
+    }
+    for (uint8_t v = 0; v < num_of_variables; ++v)
+        if ((monomial >> v) & 1) {
+            fprintf(fp, first ? "%s" : "*%s", variables[v]);
+            first = 0;
+        }
+    if (first) fprintf(fp, "1");
+}
+
+void printANF(
+    const ANF *anf, const ANF *selected,
+    const char **variables, uint8_t num_of_variables, const char *selector, FILE *fp
+) {
+    uint64_t printed = 0;
+    for (uint64_t i = 0; i < anf->size; ++i, ++printed) {
+        if (printed) fprintf(fp, " + ");
+        printMonomial(anf->monomials[i], variables, num_of_variables, NULL, fp);
+    }
+    if (selector)
+        for (uint64_t i = 0; i < selected->size; ++i, ++printed) {
+            if (printed) fprintf(fp, " + ");
+            printMonomial(selected->monomials[i], variables, num_of_variables, selector, fp);
+        }
+    if (!printed) fprintf(fp, "0");
+}
@@ -0,0 +1,39 @@
+#ifndef ANF_H
+#define ANF_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Многочлен Жегалкина от переменных v0..v63. Моном задаётся маской входящих
+// в него переменных, нулевая маска - константа 1. Мономы хранятся без повторов.
+typedef struct {
+    uint64_t *monomials;
+    uint64_t size;
+    uint64_t capacity;
+} ANF;
+
+void initANF(ANF *anf);
+void freeANF(ANF *anf);
+// Прибавляет моном по модулю 2 (повторное прибавление его убирает).
+int addMonomialANF(ANF *anf, uint64_t monomial);
+uint8_t evaluateANF(const ANF *anf, uint64_t x);
+// Значение многочлена в 64 точках сразу: бит lane планки planes[i] - значение
+// переменной v_i в точке lane.
+uint64_t evaluateANFBitsliced(const ANF *anf, const uint64_t *planes);
+uint8_t getANFDegree(const ANF *anf);
+// Многочлен функции по её таблице истинности (формат как у mobiusTransform, таблица
+// портится). Если мономов больше max_size, возвращает -2 и оставляет anf пустым.
+int initANFFromTruthTable(ANF *anf, uint64_t *table, uint8_t num_of_variables, uint64_t max_size);
+// Разбирает запись вида "s0*s3 + x + 1", где имя variables[i] обозначает v_i.
+// Если задан selector, многочлен раскладывается как anf + selector*selected,
+// что позволяет иметь 65 переменных. Пустая строка и "0" - нулевой многочлен.
+int parseANF(
+    ANF *anf, ANF *selected, const char *text,
+    const char **variables, uint8_t num_of_variables, const char *selector
+);
+void printANF(
+    const ANF *anf, const ANF *selected,
+    const char **variables, uint8_t num_of_variables, const char *selector, FILE *fp
+);
+
+#endif
@@ -0,0 +1,133 @@
+#include "Alloc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+static uint8_t huge_pages = 0;
+static uint8_t numa_interleave = 0;
+
+void enableHugePages() {
+    huge_pages = 1;
+}
+
+void enableNUMAInterleave() {
+    numa_interleave = 1;
+}
+
+uint8_t isLargeAllocationEnabled() {
+    return huge_pages || numa_interleave;
+}
+
+int takeAllocOptions(int argc, char **argv) {
+    int kept = 0;
+    for (int i = 0; i < argc; ++i) {
+        if (i && !strcmp(argv[i], "--huge-pages")) enableHugePages();
+        else if (i && !strcmp(argv[i], "--numa-interleave")) enableNUMAInterleave();
+        else argv[kept++] = argv[i];
+    }
+    argv[kept] = NULL;
+    return kept;
+}
+
+static size_t roundToHugePage(size_t size) {
+    return (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+}
+
+// Маска узлов из /sys/devices/system/node/online (например, "0-3,6").
+static unsigned long getOnlineNodes() {
+    unsigned long nodes = 0;
+    FILE *fp = fopen("/sys/devices/system/node/online", "r");
+    if (!fp) return 0;
+    unsigned first, last;
+    char separator;
+    while (fscanf(fp, "%u", &first) == 1) {
+        last = first;
+        if (fscanf(fp, "%c", &separator) == 1 && separator == '-' && fscanf(fp, "%u", &last) == 1)
+            fscanf(fp, "%c", &separator);
+        for (unsigned node = first; node <= last && node < 8 * sizeof(nodes); ++node)
+            nodes |= 1ul << node;
+    }
+    fclose(fp);
+    return nodes;
+}
+
+static void interleave(void *ptr, size_t size) {
+    unsigned long nodes = getOnlineNodes();
+    if (!nodes || !(nodes & (nodes - 1))) return;
+    if (syscall(SYS_mbind, ptr, size, MPOL_INTERLEAVE, &nodes, 8 * sizeof(nodes) + 1, 0))
+        fprintf(stderr, "Не удалось распределить память по узлам NUMA\n");
+}
+
+// Обычное отображение с запасом в одну огромную страницу, обрезанное до выровненного куска.
+static void *mapAligned(size_t size) {
+    uint8_t *raw = mmap(NULL, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return NULL;
+    uint8_t *aligned = (uint8_t *)(((uintptr_t)raw + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1));
+    if (aligned > raw) munmap(raw, aligned - raw);
+    if (raw + HUGE_PAGE_SIZE > aligned) munmap(aligned + size, raw + HUGE_PAGE_SIZE - aligned);
+    return aligned;
+}
+
+void *allocLarge(size_t size, uint8_t *kind) {
+    *kind = ALLOC_HEAP;
+    if (!isLargeAllocationEnabled() || size < HUGE_PAGE_SIZE) return calloc(size ? size : 1, 1);
+    size_t mapping_size = roundToHugePage(size);
+    void *ptr = MAP_FAILED;
+    if (huge_pages)
+        ptr = mmap(
+            NULL, mapping_size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0
+        );
+    if (ptr == MAP_FAILED) {
+        if (!(ptr = mapAligned(mapping_size))) return NULL;
+        if (huge_pages) madvise(ptr, mapping_size, MADV_HUGEPAGE);
+    }
+    if (numa_interleave) interleave(ptr, mapping_size);
+    *kind = ALLOC_LARGE_MAPPING;
+    return ptr;
+}
+
+void freeLarge(void *ptr, size_t size, uint8_t kind) {
+    if (!ptr) return;
+    switch (kind) {
+        case ALLOC_HEAP:
+            free(ptr);
+            break;
+        case ALLOC_FILE_MAPPING:
+            munmap(ptr, size);
+            break;
+        default:
+            if (huge_pages)
+                fprintf(
+                    stderr, "Массив %.1f МиБ: на огромных страницах %.1f МиБ\n",
+                    size / 1048576.0, getHugePageBytes(ptr, size) / 1048576.0
+                );
+            munmap(ptr, roundToHugePage(size));
+    }
+}
+
+uint64_t getHugePageBytes(const void *ptr, size_t size) {
+    FILE *fp = fopen("/proc/self/smaps", "r");
+    if (!fp) return 0;
+    const uintptr_t begin = (uintptr_t)ptr, end = begin + size;
+    uint64_t bytes = 0;
+    uint8_t inside = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), fp)) {
+        uintptr_t first, last;
+        unsigned long kb;
+        if (sscanf(line, "%lx-%lx ", &first, &last) == 2)
+            inside = first < end && last > begin;
+        else if (inside && (
+            sscanf(line, "AnonHugePages: %lu kB", &kb) == 1 ||
+            sscanf(line, "Private_Hugetlb: %lu kB", &kb) == 1 ||
+            sscanf(line, "Shared_Hugetlb: %lu kB", &kb) == 1
+        )) bytes += (uint64_t)kb << 10;
+    }
+    fclose(fp);
+    return bytes < size ? bytes : size;
+}
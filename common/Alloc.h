@@ -0,0 +1,35 @@
+#ifndef ALLOC_H
+#define ALLOC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Способ, которым получена память (хранится рядом с указателем и передаётся в freeLarge).
+#define ALLOC_HEAP 0
+#define ALLOC_FILE_MAPPING 1
+#define ALLOC_LARGE_MAPPING 2
+
+#define HUGE_PAGE_SIZE ((size_t)2 << 20)
+
+// Большие массивы с произвольным доступом (таблицы переходов, массивы по состояниям,
+// строки графа) упираются в промахи TLB. При включённом режиме они выделяются
+// через mmap кусками, кратными 2 МиБ и выровненными на 2 МиБ: сначала с MAP_HUGETLB
+// (если зарезервированы явные огромные страницы), иначе с madvise(MADV_HUGEPAGE).
+// При освобождении в stderr сообщается, какая часть массива действительно
+// оказалась на огромных страницах.
+void enableHugePages();
+// Страницы больших массивов чередуются по всем узлам NUMA (mbind MPOL_INTERLEAVE).
+void enableNUMAInterleave();
+// Включён ли хотя бы один из режимов.
+uint8_t isLargeAllocationEnabled();
+// Включает режимы по аргументам --huge-pages и --numa-interleave и убирает их
+// из argv, чтобы остальной разбор аргументов программы не менялся. Возвращает новый argc.
+int takeAllocOptions(int argc, char **argv);
+// Обнулённая память. Без включённых режимов и для массивов меньше огромной
+// страницы - обычный calloc, *kind = ALLOC_HEAP.
+void *allocLarge(size_t size, uint8_t *kind);
+void freeLarge(void *ptr, size_t size, uint8_t kind);
+// Сколько байт из [ptr, ptr + size) сейчас лежит на огромных страницах (по /proc/self/smaps).
+uint64_t getHugePageBytes(const void *ptr, size_t size);
+
+#endif
@@ -0,0 +1,451 @@
+#include "BDD.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BDD_NO_NODE UINT32_MAX
+#define BDD_FREE_VAR UINT32_MAX
+#define BDD_MIN_SIZE 1024
+#define BDD_MAX_CAPACITY ((uint32_t)1 << 31)
+
+enum {
+    BDD_OPERATION_NONE,
+    BDD_OPERATION_ITE,
+    BDD_OPERATION_EXISTS,
+    BDD_OPERATION_AND_EXISTS,
+    BDD_OPERATION_COMPOSE
+};
+
+static uint32_t roundUpToPowerOfTwo(uint32_t value) {
+    uint32_t result = BDD_MIN_SIZE;
+    while (result < value && result < BDD_MAX_CAPACITY) result <<= 1;
+    return result;
+}
+
+static inline uint32_t hashNode(uint32_t var, BDD low, BDD high) {
+    uint64_t hash = (uint64_t)var * 0x9E3779B97F4A7C15 ^ (uint64_t)low * 0xC2B2AE3D27D4EB4F ^ (uint64_t)high * 0x165667B19E3779F9;
+    return (uint32_t)(hash ^ (hash >> 29));
+}
+
+static inline BDDCacheEntry *getCacheEntry(BDDManager *manager, uint32_t operation, uint32_t first, uint32_t second, uint32_t third) {
+    const uint32_t hash = hashNode(first, second, third) ^ operation * 0x85EBCA6B;
+    return &manager->cache[hash & manager->cache_mask];
+}
+
+static inline uint8_t isCached(const BDDCacheEntry *entry, uint32_t operation, uint32_t first, uint32_t second, uint32_t third) {
+    return entry->operation == operation && entry->first == first && entry->second == second && entry->third == third;
+}
+
+static inline void putCache(BDDCacheEntry *entry, uint32_t operation, uint32_t first, uint32_t second, uint32_t third, BDD result) {
+    entry->operation = operation;
+    entry->first = first;
+    entry->second = second;
+    entry->third = third;
+    entry->result = result;
+}
+
+int initBDDManager(BDDManager *manager, uint32_t num_of_vars, uint32_t capacity, uint32_t cache_size) {
+    memset(manager, 0, sizeof(BDDManager));
+    manager->num_of_vars = num_of_vars;
+    manager->capacity = roundUpToPowerOfTwo(capacity);
+    manager->cache_mask = roundUpToPowerOfTwo(cache_size) - 1;
+    manager->nodes = malloc((size_t)manager->capacity * sizeof(BDDNode));
+    manager->refs = calloc(manager->capacity, sizeof(uint32_t));
+    manager->buckets = malloc((size_t)manager->capacity * sizeof(uint32_t));
+    manager->cache = calloc((size_t)manager->cache_mask + 1, sizeof(BDDCacheEntry));
+    if (!manager->nodes || !manager->refs || !manager->buckets || !manager->cache) {
+        freeBDDManager(manager);
+        return -1;
+    }
+    memset(manager->buckets, 0xFF, (size_t)manager->capacity * sizeof(uint32_t));
+    // Константы: их переменная - num_of_vars, ниже всех настоящих.
+    for (BDD terminal = BDD_FALSE; terminal <= BDD_TRUE; ++terminal)
+        manager->nodes[terminal] = (BDDNode){num_of_vars, terminal, terminal, BDD_NO_NODE};
+    manager->used = 2;
+    manager->free_list = BDD_NO_NODE;
+    return 0;
+}
+
+void freeBDDManager(BDDManager *manager) {
+    free(manager->nodes);
+    free(manager->refs);
+    free(manager->buckets);
+    free(manager->cache);
+    manager->nodes = NULL;
+    manager->refs = NULL;
+    manager->buckets = NULL;
+    manager->cache = NULL;
+}
+
+BDD refBDD(BDDManager *manager, BDD f) {
+    if (f != BDD_ERROR && f > BDD_TRUE) ++manager->refs[f];
+    return f;
+}
+
+void derefBDD(BDDManager *manager, BDD f) {
+    if (f != BDD_ERROR && f > BDD_TRUE && manager->refs[f]) --manager->refs[f];
+}
+
+uint32_t getBDDNodeCount(const BDDManager *manager) {
+    return manager->used - manager->num_of_free;
+}
+
+static void rehashNodes(BDDManager *manager) {
+    memset(manager->buckets, 0xFF, (size_t)manager->capacity * sizeof(uint32_t));
+    const uint32_t mask = manager->capacity - 1;
+    for (uint32_t i = 2; i < manager->used; ++i) {
+        BDDNode *node = &manager->nodes[i];
+        if (node->var == BDD_FREE_VAR) continue;
+        const uint32_t bucket = hashNode(node->var, node->low, node->high) & mask;
+        node->next = manager->buckets[bucket];
+        manager->buckets[bucket] = i;
+    }
+}
+
+static int growNodes(BDDManager *manager) {
+    if (manager->capacity >= BDD_MAX_CAPACITY) return -1;
+    const uint32_t capacity = manager->capacity << 1;
+    BDDNode *nodes = realloc(manager->nodes, (size_t)capacity * sizeof(BDDNode));
+    if (!nodes) return -1;
+    manager->nodes = nodes;
+    uint32_t *refs = realloc(manager->refs, (size_t)capacity * sizeof(uint32_t));
+    if (!refs) return -1;
+    memset(refs + manager->capacity, 0, (size_t)(capacity - manager->capacity) * sizeof(uint32_t));
+    manager->refs = refs;
+    uint32_t *buckets = realloc(manager->buckets, (size_t)capacity * sizeof(uint32_t));
+    if (!buckets) return -1;
+    manager->buckets = buckets;
+    manager->capacity = capacity;
+    rehashNodes(manager);
+    // Кэш растёт вместе с таблицей, пока не сравняется с ней.
+    if (manager->cache_mask + 1 < capacity) {
+        BDDCacheEntry *cache = realloc(manager->cache, (size_t)(manager->cache_mask + 1) * 2 * sizeof(BDDCacheEntry));
+        if (cache) {
+            manager->cache = cache;
+            manager->cache_mask = manager->cache_mask * 2 + 1;
+            memset(manager->cache, 0, (size_t)(manager->cache_mask + 1) * sizeof(BDDCacheEntry));
+        }
+    }
+    return 0;
+}
+
+static BDD findOrAddNode(BDDManager *manager, uint32_t var, BDD low, BDD high) {
+    if (low == high) return low;
+    uint32_t bucket = hashNode(var, low, high) & (manager->capacity - 1);
+    for (uint32_t i = manager->buckets[bucket]; i != BDD_NO_NODE; i = manager->nodes[i].next) {
+        const BDDNode *node = &manager->nodes[i];
+        if (node->var == var && node->low == low && node->high == high) return i;
+    }
+    BDD result;
+    if (manager->free_list != BDD_NO_NODE) {
+        result = manager->free_list;
+        manager->free_list = manager->nodes[result].next;
+        --manager->num_of_free;
+    } else {
+        if (manager->used == manager->capacity) {
+            if (growNodes(manager)) return BDD_ERROR;
+            bucket = hashNode(var, low, high) & (manager->capacity - 1);
+        }
+        result = manager->used++;
+    }
+    manager->nodes[result] = (BDDNode){var, low, high, manager->buckets[bucket]};
+    manager->buckets[bucket] = result;
+    return result;
+}
+
+static void markNode(const BDDManager *manager, uint8_t *marks, BDD f) {
+    while (f > BDD_TRUE && !marks[f]) {
+        marks[f] = 1;
+        markNode(manager, marks, manager->nodes[f].low);
+        f = manager->nodes[f].high;
+    }
+}
+
+static void collectGarbage(BDDManager *manager, const BDD *roots, uint32_t num_of_roots) {
+    uint8_t *marks = calloc(manager->used, 1);
+    // Без памяти под отметки сборка пропускается: таблица просто вырастет.
+    if (!marks) return;
+    for (uint32_t i = 2; i < manager->used; ++i)
+        if (manager->refs[i]) markNode(manager, marks, i);
+    for (uint32_t i = 0; i < num_of_roots; ++i)
+        if (roots[i] != BDD_ERROR) markNode(manager, marks, roots[i]);
+    for (uint32_t i = 2; i < manager->used; ++i) {
+        BDDNode *node = &manager->nodes[i];
+        if (marks[i] || node->var == BDD_FREE_VAR) continue;
+        node->var = BDD_FREE_VAR;
+        node->next = manager->free_list;
+        manager->free_list = i;
+        ++manager->num_of_free;
+    }
+    free(marks);
+    rehashNodes(manager);
+    memset(manager->cache, 0, (size_t)(manager->cache_mask + 1) * sizeof(BDDCacheEntry));
+    ++manager->num_of_collections;
+}
+
+// Единственное место, где возможна сборка мусора: внутри рекурсии промежуточные
+// результаты нигде не захвачены.
+static void enterOperation(BDDManager *manager, const BDD *roots, uint32_t num_of_roots) {
+    const uint32_t available = manager->capacity - manager->used + manager->num_of_free;
+    if (available < manager->capacity / 4) collectGarbage(manager, roots, num_of_roots);
+}
+
+static inline uint32_t getVar(const BDDManager *manager, BDD f) {
+    return manager->nodes[f].var;
+}
+
+static BDD ite(BDDManager *manager, BDD f, BDD g, BDD h) {
+    if (f == BDD_TRUE) return g;
+    if (f == BDD_FALSE) return h;
+    if (g == h) return g;
+    if (g == BDD_TRUE && h == BDD_FALSE) return f;
+    BDDCacheEntry *entry = getCacheEntry(manager, BDD_OPERATION_ITE, f, g, h);
+    if (isCached(entry, BDD_OPERATION_ITE, f, g, h)) return entry->result;
+    uint32_t top = getVar(manager, f);
+    if (getVar(manager, g) < top) top = getVar(manager, g);
+    if (getVar(manager, h) < top) top = getVar(manager, h);
+    const BDDNode *nf = &manager->nodes[f], *ng = &manager->nodes[g], *nh = &manager->nodes[h];
+    const BDD f0 = nf->var == top ? nf->low : f, f1 = nf->var == top ? nf->high : f;
+    const BDD g0 = ng->var == top ? ng->low : g, g1 = ng->var == top ? ng->high : g;
+    const BDD h0 = nh->var == top ? nh->low : h, h1 = nh->var == top ? nh->high : h;
+    const BDD high = ite(manager, f1, g1, h1);
+    if (high == BDD_ERROR) return BDD_ERROR;
+    const BDD low = ite(manager, f0, g0, h0);
+    if (low == BDD_ERROR) return BDD_ERROR;
+    const BDD result = findOrAddNode(manager, top, low, high);
+    if (result == BDD_ERROR) return BDD_ERROR;
+    // Таблица могла вырасти и кэш - очиститься: запись ищется заново.
+    putCache(getCacheEntry(manager, BDD_OPERATION_ITE, f, g, h), BDD_OPERATION_ITE, f, g, h, result);
+    return result;
+}
+
+static BDD exists(BDDManager *manager, BDD f, BDD cube) {
+    if (f <= BDD_TRUE) return f;
+    const uint32_t var = getVar(manager, f);
+    while (cube != BDD_TRUE && getVar(manager, cube) < var) cube = manager->nodes[cube].high;
+    if (cube == BDD_TRUE) return f;
+    BDDCacheEntry *entry = getCacheEntry(manager, BDD_OPERATION_EXISTS, f, cube, 0);
+    if (isCached(entry, BDD_OPERATION_EXISTS, f, cube, 0)) return entry->result;
+    const BDD f0 = manager->nodes[f].low, f1 = manager->nodes[f].high;
+    BDD result;
+    if (getVar(manager, cube) == var) {
+        const BDD rest = manager->nodes[cube].high;
+        const BDD low = exists(manager, f0, rest);
+        if (low == BDD_ERROR) return BDD_ERROR;
+        if (low == BDD_TRUE) result = BDD_TRUE;
+        else {
+            const BDD high = exists(manager, f1, rest);
+            if (high == BDD_ERROR) return BDD_ERROR;
+            result = ite(manager, low, BDD_TRUE, high);
+        }
+    } else {
+        const BDD high = exists(manager, f1, cube);
+        if (high == BDD_ERROR) return BDD_ERROR;
+        const BDD low = exists(manager, f0, cube);
+        if (low == BDD_ERROR) return BDD_ERROR;
+        result = findOrAddNode(manager, var, low, high);
+    }
+    if (result == BDD_ERROR) return BDD_ERROR;
+    putCache(getCacheEntry(manager, BDD_OPERATION_EXISTS, f, cube, 0), BDD_OPERATION_EXISTS, f, cube, 0, result);
+    return result;
+}
+
+static BDD andExists(BDDManager *manager, BDD f, BDD g, BDD cube) {
+    if (f == BDD_FALSE || g == BDD_FALSE) return BDD_FALSE;
+    if (f == BDD_TRUE || f == g) return exists(manager, g, cube);
+    if (g == BDD_TRUE) return exists(manager, f, cube);
+    if (f > g) {
+        const BDD swap = f;
+        f = g;
+        g = swap;
+    }
+    uint32_t top = getVar(manager, f);
+    if (getVar(manager, g) < top) top = getVar(manager, g);
+    while (cube != BDD_TRUE && getVar(manager, cube) < top) cube = manager->nodes[cube].high;
+    if (cube == BDD_TRUE) return ite(manager, f, g, BDD_FALSE);
+    BDDCacheEntry *entry = getCacheEntry(manager, BDD_OPERATION_AND_EXISTS, f, g, cube);
+    if (isCached(entry, BDD_OPERATION_AND_EXISTS, f, g, cube)) return entry->result;
+    const BDDNode *nf = &manager->nodes[f], *ng = &manager->nodes[g];
+    const BDD f0 = nf->var == top ? nf->low : f, f1 = nf->var == top ? nf->high : f;
+    const BDD g0 = ng->var == top ? ng->low : g, g1 = ng->var == top ? ng->high : g;
+    BDD result;
+    if (getVar(manager, cube) == top) {
+        const BDD rest = manager->nodes[cube].high;
+        const BDD low = andExists(manager, f0, g0, rest);
+        if (low == BDD_ERROR) return BDD_ERROR;
+        if (low == BDD_TRUE) result = BDD_TRUE;
+        else {
+            const BDD high = andExists(manager, f1, g1, rest);
+            if (high == BDD_ERROR) return BDD_ERROR;
+            result = ite(manager, low, BDD_TRUE, high);
+        }
+    } else {
+        const BDD high = andExists(manager, f1, g1, cube);
+        if (high == BDD_ERROR) return BDD_ERROR;
+        const BDD low = andExists(manager, f0, g0, cube);
+        if (low == BDD_ERROR) return BDD_ERROR;
+        result = findOrAddNode(manager, top, low, high);
+    }
+    if (result == BDD_ERROR) return BDD_ERROR;
+    putCache(
+        getCacheEntry(manager, BDD_OPERATION_AND_EXISTS, f, g, cube),
+        BDD_OPERATION_AND_EXISTS, f, g, cube, result
+    );
+    return result;
+}
+
+static BDD compose(BDDManager *manager, BDD f) {
+    if (f <= BDD_TRUE) return f;
+    BDDCacheEntry *entry = getCacheEntry(manager, BDD_OPERATION_COMPOSE, f, manager->compose_id, 0);
+    if (isCached(entry, BDD_OPERATION_COMPOSE, f, manager->compose_id, 0)) return entry->result;
+    const BDD high = compose(manager, manager->nodes[f].high);
+    if (high == BDD_ERROR) return BDD_ERROR;
+    const BDD low = compose(manager, manager->nodes[f].low);
+    if (low == BDD_ERROR) return BDD_ERROR;
+    const BDD result = ite(manager, manager->compose_map[getVar(manager, f)], high, low);
+    if (result == BDD_ERROR) return BDD_ERROR;
+    putCache(
+        getCacheEntry(manager, BDD_OPERATION_COMPOSE, f, manager->compose_id, 0),
+        BDD_OPERATION_COMPOSE, f, manager->compose_id, 0, result
+    );
+    return result;
+}
+
+BDD getBDDVariable(BDDManager *manager, uint32_t var) {
+    enterOperation(manager, NULL, 0);
+    return findOrAddNode(manager, var, BDD_FALSE, BDD_TRUE);
+}
+
+BDD makeBDDNode(BDDManager *manager, uint32_t var, BDD low, BDD high) {
+    const BDD roots[2] = {low, high};
+    enterOperation(manager, roots, 2);
+    return findOrAddNode(manager, var, low, high);
+}
+
+BDD iteBDD(BDDManager *manager, BDD f, BDD g, BDD h) {
+    if (f == BDD_ERROR || g == BDD_ERROR || h == BDD_ERROR) return BDD_ERROR;
+    const BDD roots[3] = {f, g, h};
+    enterOperation(manager, roots, 3);
+    return ite(manager, f, g, h);
+}
+
+BDD notBDD(BDDManager *manager, BDD f) {
+    return iteBDD(manager, f, BDD_FALSE, BDD_TRUE);
+}
+
+BDD andBDD(BDDManager *manager, BDD f, BDD g) {
+    return iteBDD(manager, f, g, BDD_FALSE);
+}
+
+BDD orBDD(BDDManager *manager, BDD f, BDD g) {
+    return iteBDD(manager, f, BDD_TRUE, g);
+}
+
+BDD xorBDD(BDDManager *manager, BDD f, BDD g) {
+    if (f == BDD_ERROR || g == BDD_ERROR) return BDD_ERROR;
+    const BDD roots[2] = {f, g};
+    enterOperation(manager, roots, 2);
+    const BDD not_g = ite(manager, g, BDD_FALSE, BDD_TRUE);
+    if (not_g == BDD_ERROR) return BDD_ERROR;
+    return ite(manager, f, not_g, g);
+}
+
+BDD xnorBDD(BDDManager *manager, BDD f, BDD g) {
+    if (f == BDD_ERROR || g == BDD_ERROR) return BDD_ERROR;
+    const BDD roots[2] = {f, g};
+    enterOperation(manager, roots, 2);
+    const BDD not_g = ite(manager, g, BDD_FALSE, BDD_TRUE);
+    if (not_g == BDD_ERROR) return BDD_ERROR;
+    return ite(manager, f, g, not_g);
+}
+
+BDD existsBDD(BDDManager *manager, BDD f, BDD cube) {
+    if (f == BDD_ERROR || cube == BDD_ERROR) return BDD_ERROR;
+    const BDD roots[2] = {f, cube};
+    enterOperation(manager, roots, 2);
+    return exists(manager, f, cube);
+}
+
+BDD forallBDD(BDDManager *manager, BDD f, BDD cube) {
+    if (f == BDD_ERROR || cube == BDD_ERROR) return BDD_ERROR;
+    const BDD roots[2] = {f, cube};
+    enterOperation(manager, roots, 2);
+    const BDD not_f = ite(manager, f, BDD_FALSE, BDD_TRUE);
+    if (not_f == BDD_ERROR) return BDD_ERROR;
+    const BDD result = exists(manager, not_f, cube);
+    if (result == BDD_ERROR) return BDD_ERROR;
+    return ite(manager, result, BDD_FALSE, BDD_TRUE);
+}
+
+BDD andExistsBDD(BDDManager *manager, BDD f, BDD g, BDD cube) {
+    if (f == BDD_ERROR || g == BDD_ERROR || cube == BDD_ERROR) return BDD_ERROR;
+    const BDD roots[3] = {f, g, cube};
+    enterOperation(manager, roots, 3);
+    return andExists(manager, f, g, cube);
+}
+
+BDD composeBDD(BDDManager *manager, BDD f, const BDD *map) {
+    if (f == BDD_ERROR) return BDD_ERROR;
+    for (uint32_t var = 0; var < manager->num_of_vars; ++var)
+        if (map[var] == BDD_ERROR) return BDD_ERROR;
+    // Корни: f и все подставляемые функции.
+    BDD *roots = malloc(((size_t)manager->num_of_vars + 1) * sizeof(BDD));
+    if (!roots) return BDD_ERROR;
+    roots[0] = f;
+    memcpy(roots + 1, map, manager->num_of_vars * sizeof(BDD));
+    enterOperation(manager, roots, manager->num_of_vars + 1);
+    free(roots);
+    // Записи прошлых подстановок не должны совпасть с новыми.
+    if (++manager->compose_id == 0)
+        memset(manager->cache, 0, (size_t)(manager->cache_mask + 1) * sizeof(BDDCacheEntry));
+    manager->compose_map = map;
+    return compose(manager, f);
+}
+
+BDD makeBDDCube(BDDManager *manager, const uint32_t *vars, uint32_t num_of_vars) {
+    enterOperation(manager, NULL, 0);
+    BDD cube = BDD_TRUE;
+    for (uint32_t i = 0; i < num_of_vars && cube != BDD_ERROR; ++i) {
+        const BDD var = findOrAddNode(manager, vars[i], BDD_FALSE, BDD_TRUE);
+        cube = var == BDD_ERROR ? BDD_ERROR : ite(manager, var, cube, BDD_FALSE);
+    }
+    return cube;
+}
+
+static double countNode(const BDDManager *manager, double *counts, BDD f) {
+    if (f <= BDD_TRUE) return f;
+    if (counts[f] >= 0) return counts[f];
+    const BDDNode *node = &manager->nodes[f];
+    const double low = ldexp(countNode(manager, counts, node->low), (int)(getVar(manager, node->low) - node->var - 1));
+    const double high = ldexp(countNode(manager, counts, node->high), (int)(getVar(manager, node->high) - node->var - 1));
+    return counts[f] = low + high;
+}
+
+double countBDD(const BDDManager *manager, BDD f) {
+    if (f <= BDD_TRUE) return ldexp(f, (int)manager->num_of_vars);
+    double *counts = malloc((size_t)manager->used * sizeof(double));
+    if (!counts) return -1;
+    for (uint32_t i = 0; i < manager->used; ++i) counts[i] = -1;
+    const double result = ldexp(countNode(manager, counts, f), (int)getVar(manager, f));
+    free(counts);
+    return result;
+}
+
+static uint32_t countNodes(const BDDManager *manager, uint8_t *marks, BDD f) {
+    uint32_t result = 0;
+    while (f > BDD_TRUE && !marks[f]) {
+        marks[f] = 1;
+        ++result;
+        result += countNodes(manager, marks, manager->nodes[f].low);
+        f = manager->nodes[f].high;
+    }
+    return result;
+}
+
+uint32_t getBDDSize(const BDDManager *manager, BDD f) {
+    uint8_t *marks = calloc(manager->used, 1);
+    if (!marks) return 0;
+    const uint32_t result = countNodes(manager, marks, f);
+    free(marks);
+    return result;
+}
@@ -0,0 +1,91 @@
+#ifndef BDD_H
+#define BDD_H
+
+#include <stdint.h>
+
+// Сокращённые упорядоченные диаграммы решений. Диаграмма - номер вершины в менеджере,
+// 0 и 1 - константы. Порядок переменных фиксирован: переменная с меньшим номером
+// ближе к корню. Одинаковые вершины не повторяются (таблица уникальности), так что
+// равные функции - равные номера.
+typedef uint32_t BDD;
+#define BDD_FALSE 0
+#define BDD_TRUE 1
+// Возвращается операциями, если не хватило памяти.
+#define BDD_ERROR UINT32_MAX
+
+typedef struct {
+    uint32_t var;
+    BDD low;
+    BDD high;
+    // Следующая вершина в цепочке таблицы уникальности или в списке свободных.
+    uint32_t next;
+} BDDNode;
+
+// Кэш результатов операций: прямое отображение, при коллизии запись затирается.
+typedef struct {
+    uint32_t operation;
+    uint32_t first;
+    uint32_t second;
+    uint32_t third;
+    BDD result;
+} BDDCacheEntry;
+
+// Сборка мусора выполняется только при входе в операцию, если свободных вершин
+// осталось меньше четверти. Выживают вершины, достижимые из захваченных refBDD, и
+// аргументы самой операции; результат прошлой операции, не захваченный и не
+// переданный в следующую, может быть собран. Если и после сборки места мало,
+// таблица вершин удваивается.
+typedef struct {
+    uint32_t num_of_vars;
+    BDDNode *nodes;
+    uint32_t *refs;
+    uint32_t capacity;
+    // Вершины с номерами не меньше used ещё не выдавались.
+    uint32_t used;
+    uint32_t num_of_free;
+    uint32_t free_list;
+    uint32_t *buckets;
+    BDDCacheEntry *cache;
+    uint32_t cache_mask;
+    // Отличает записи кэша разных вызовов composeBDD.
+    uint32_t compose_id;
+    const BDD *compose_map;
+    uint64_t num_of_collections;
+} BDDManager;
+
+// capacity и cache_size округляются вверх до степени двойки.
+int initBDDManager(BDDManager *manager, uint32_t num_of_vars, uint32_t capacity, uint32_t cache_size);
+void freeBDDManager(BDDManager *manager);
+BDD refBDD(BDDManager *manager, BDD f);
+void derefBDD(BDDManager *manager, BDD f);
+// Число занятых вершин, включая ещё не собранные.
+uint32_t getBDDNodeCount(const BDDManager *manager);
+
+// Переменная var как функция.
+BDD getBDDVariable(BDDManager *manager, uint32_t var);
+// Вершина "если var, то high, иначе low"; var должна быть меньше переменных low и high.
+BDD makeBDDNode(BDDManager *manager, uint32_t var, BDD low, BDD high);
+BDD iteBDD(BDDManager *manager, BDD f, BDD g, BDD h);
+BDD notBDD(BDDManager *manager, BDD f);
+BDD andBDD(BDDManager *manager, BDD f, BDD g);
+BDD orBDD(BDDManager *manager, BDD f, BDD g);
+BDD xorBDD(BDDManager *manager, BDD f, BDD g);
+BDD xnorBDD(BDDManager *manager, BDD f, BDD g);
+// Квантор по переменным куба cube (конъюнкции переменных без отрицаний).
+BDD existsBDD(BDDManager *manager, BDD f, BDD cube);
+BDD forallBDD(BDDManager *manager, BDD f, BDD cube);
+// Существование по cube от f & g без построения самой конъюнкции.
+BDD andExistsBDD(BDDManager *manager, BDD f, BDD g, BDD cube);
+// Одновременная подстановка map[var] вместо каждой переменной var (map содержит
+// num_of_vars функций; переименование - частный случай).
+BDD composeBDD(BDDManager *manager, BDD f, const BDD *map);
+// Куб из num_of_vars переменных массива vars.
+BDD makeBDDCube(BDDManager *manager, const uint32_t *vars, uint32_t num_of_vars);
+
+// Число наборов всех num_of_vars переменных, на которых f = 1 (точно до 2^53).
+// Возвращает -1, если не хватило памяти.
+double countBDD(const BDDManager *manager, BDD f);
+// Число вершин диаграммы, не считая констант.
+uint32_t getBDDSize(const BDDManager *manager, BDD f);
+
+#endif
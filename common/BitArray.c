@@ -1,20 +1,27 @@
 #include "BitArray.h"
 #include <stdlib.h>
+#include <sys/mman.h>
 #include "Hash.h"
+#include "Alloc.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
 
 int initBitArray(BitArray *array, uint64_t length) {
-    if (!(array->bucket = malloc((length + 7) / 8)))
+    if (!(array->bucket = allocLarge((length + 7) / 8, &array->mapped)))
         return -1;
-    memset(array->bucket, 0, (length + 7) / 8);
     array->length = length;
     return 0;
 }
 
-uint64_t getBitArrayLength(BitArray *array) {
+uint64_t getBitArrayLength(const BitArray *array) {
     return array->length;
 }
 
-uint8_t getBitArrayElement(BitArray *array, uint64_t i) {
+uint8_t getBitArrayElement(const BitArray *array, uint64_t i) {
     return (array->bucket[i / 8] >> (i % 8)) & (uint8_t)1; 
 }
 
@@ -25,10 +32,11 @@ void setBitArrayElement(BitArray *array, uint64_t i, uint8_t element) {
 
 void freeBitArray(BitArray *array) {
     if (array->bucket) {
-        free(array->bucket);
+        freeLarge(array->bucket, (array->length + 7) / 8, array->mapped);
         array->bucket = NULL;
     }
     array->length = 0;
+    array->mapped = 0;
 }
 
 int readArrayFromFile(BitArray *array, uint64_t length, FILE *fp) {
@@ -55,20 +63,140 @@ int readArrayFromFile(BitArray *array, uint64_t length, FILE *fp) {
     return 0;
 }
 
-uint64_t hashBitArray(BitArray *array) {
+// Биты пишутся последовательно, поэтому накапливаются и сбрасываются в массив целыми байтами.
+struct BitWriter {
+    uint8_t *bucket;
+    uint64_t byte;
+    uint32_t accumulator;
+    unsigned filled;
+};
+
+static void appendBits(struct BitWriter *writer, uint32_t bits, unsigned count) {
+    writer->accumulator |= bits << writer->filled;
+    writer->filled += count;
+    while (writer->filled >= 8) {
+        writer->bucket[writer->byte++] = (uint8_t)writer->accumulator;
+        writer->accumulator >>= 8;
+        writer->filled -= 8;
+    }
+}
+
+static void flushBits(struct BitWriter *writer) {
+    if (!writer->filled) return;
+    uint8_t mask = (uint8_t)((1u << writer->filled) - 1);
+    writer->bucket[writer->byte] = (writer->bucket[writer->byte] & ~mask) | (uint8_t)writer->accumulator;
+}
+
+#ifdef __SSE2__
+// Сжимает биты на чётных позициях 16-битного числа в младший байт.
+static uint32_t compressEvenBits(uint32_t x) {
+    x &= 0x5555;
+    x = (x | (x >> 1)) & 0x3333;
+    x = (x | (x >> 2)) & 0x0F0F;
+    return (x | (x >> 4)) & 0x00FF;
+}
+
+// Разбирает 16 символов за раз. Возвращает 0, если блок нужно разобрать посимвольно
+// (встретился посторонний символ или в блоке больше цифр, чем осталось прочитать).
+static int readBlock16(struct BitWriter *writer, const char *data, uint64_t remaining) {
+    __m128i block = _mm_loadu_si128((const __m128i *)data);
+    uint32_t ones = _mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8('1')));
+    uint32_t digits = ones | _mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8('0')));
+    uint32_t spaces = _mm_movemask_epi8(_mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(block, _mm_set1_epi8('\n'))),
+        _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('\t')), _mm_cmpeq_epi8(block, _mm_set1_epi8('\r')))
+    ));
+    if ((digits | spaces) != 0xFFFF) return 0;
+    unsigned count = __builtin_popcount(digits);
+    if (count > remaining) return 0;
+    if (digits == 0x5555) appendBits(writer, compressEvenBits(ones), 8);
+    else if (digits == 0xAAAA) appendBits(writer, compressEvenBits(ones >> 1), 8);
+    else if (digits == 0xFFFF) appendBits(writer, ones, 16);
+    else {
+#ifdef __BMI2__
+        appendBits(writer, _pext_u32(ones, digits), count);
+#else
+        for (; digits; digits &= digits - 1)
+            appendBits(writer, (ones >> __builtin_ctz(digits)) & 1, 1);
+#endif
+    }
+    return (int)count + 1;
+}
+#endif
+
+int readArrayFromBuffer(BitArray *array, uint64_t length, const char *data, size_t size, size_t *position) {
+    struct BitWriter writer = {array->bucket, 0, 0, 0};
+    size_t p = *position;
+    uint64_t i = 0;
+    while (i < length) {
+#ifdef __SSE2__
+        int read;
+        if (size - p >= 16 && (read = readBlock16(&writer, data + p, length - i))) {
+            i += read - 1;
+            p += 16;
+            continue;
+        }
+#endif
+        int c = p < size ? (unsigned char)data[p++] : EOF;
+        switch (c) {
+            case '1':
+            case '0':
+                appendBits(&writer, c == '1', 1);
+                ++i;
+                break;
+            case ' ':
+            case '\t':
+            case '\n':
+            case '\r':
+                break;
+            default:
+                flushBits(&writer);
+                printf("Ошибка при чтении файла. Получен символ %d.\n", c);
+                return -1;
+        }
+    }
+    flushBits(&writer);
+    *position = p;
+    return 0;
+}
+
+int mapBitArray(BitArray *array, uint64_t length, int fd, uint64_t offset) {
+    void *bucket = mmap(
+        NULL, (length + 7) / 8, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, (off_t)offset
+    );
+    if (bucket == MAP_FAILED) return -1;
+    array->bucket = bucket;
+    array->length = length;
+    array->mapped = ALLOC_FILE_MAPPING;
+    return 0;
+}
+
+uint64_t countBitArrayOnes(const BitArray *array) {
+    const uint64_t size = (array->length + 7) / 8;
+    uint64_t ones = 0, i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, array->bucket + i, sizeof(word));
+        ones += __builtin_popcountll(word);
+    }
+    for (; i < size; ++i) ones += __builtin_popcount(array->bucket[i]);
+    return ones;
+}
+
+uint64_t hashBitArray(const BitArray *array) {
     return hashBytes(array->bucket, (array->length + 7) / 8);
 }
 
-uint8_t compareBitArrays(BitArray *first, BitArray *second) {
+uint8_t compareBitArrays(const BitArray *first, const BitArray *second) {
     if (first->length != second->length) return 0;
     return !memcmp(first->bucket, second->bucket, (first->length + 7) / 8);
 }
 
-uint8_t compareFirstNBytesOfBitArray(BitArray *first, BitArray *second, size_t n) {
+uint8_t compareFirstNBytesOfBitArray(const BitArray *first, const BitArray *second, size_t n) {
     return !memcmp(first->bucket, second->bucket, n);
 }
 
-int copyBitArray(BitArray *dst, BitArray *src) {
+int copyBitArray(BitArray *dst, const BitArray *src) {
     if (initBitArray(dst, src->length)) return -1;
     memcpy(dst->bucket, src->bucket, (src->length + 7) / 8);
     return 0;
@@ -7,17 +7,26 @@
 typedef struct {
     uint8_t *bucket;
     uint64_t length;
+    // Откуда взята память: ALLOC_HEAP, ALLOC_FILE_MAPPING или ALLOC_LARGE_MAPPING (см. Alloc.h).
+    uint8_t mapped;
 } BitArray;
 
 int initBitArray(BitArray *array, uint64_t length);
-uint64_t getBitArrayLength(BitArray *array);
-uint8_t getBitArrayElement(BitArray *array, uint64_t i);
+uint64_t getBitArrayLength(const BitArray *array);
+uint8_t getBitArrayElement(const BitArray *array, uint64_t i);
 void setBitArrayElement(BitArray *array, uint64_t i, uint8_t element);
 void freeBitArray(BitArray *array);
 int readArrayFromFile(BitArray *array, uint64_t length, FILE *fp);
-uint64_t hashBitArray(BitArray *array);
-uint8_t compareBitArrays(BitArray *first, BitArray *second);
-uint8_t compareFirstNBytesOfBitArray(BitArray *first, BitArray *second, size_t n);
-int copyBitArray(BitArray *dst, BitArray *src);
+// Разбирает length символов 0/1 (разделённых пробельными символами) из буфера,
+// начиная с *position, и сдвигает *position за последний прочитанный символ.
+int readArrayFromBuffer(BitArray *array, uint64_t length, const char *data, size_t size, size_t *position);
+// Отображает length битов файла fd со смещения offset (кратного размеру страницы).
+// Изменения массива в файл не попадают.
+int mapBitArray(BitArray *array, uint64_t length, int fd, uint64_t offset);
+uint64_t countBitArrayOnes(const BitArray *array);
+uint64_t hashBitArray(const BitArray *array);
+uint8_t compareBitArrays(const BitArray *first, const BitArray *second);
+uint8_t compareFirstNBytesOfBitArray(const BitArray *first, const BitArray *second, size_t n);
+int copyBitArray(BitArray *dst, const BitArray *src);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "GFLinearComplexity.hpp"
+#include <flint/fq_vec.h>
+#include <algorithm>
+
+GFLinearComplexity::GFLinearComplexity(const GF &gf)
+    : gf(gf), L(0), shift(1), n(0), capacity(1024), base(0) {
+    fq_poly_init(this->connection, this->gf.getCTX());
+    fq_poly_init(this->previous, this->gf.getCTX());
+    fq_poly_init(this->shifted, this->gf.getCTX());
+    fq_poly_one(this->connection, this->gf.getCTX());
+    fq_poly_one(this->previous, this->gf.getCTX());
+    fq_init(this->previous_discrepancy, this->gf.getCTX());
+    fq_one(this->previous_discrepancy, this->gf.getCTX());
+    this->history = _fq_vec_init(this->capacity, this->gf.getCTX());
+}
+
+GFLinearComplexity::~GFLinearComplexity() {
+    fq_poly_clear(this->connection, this->gf.getCTX());
+    fq_poly_clear(this->previous, this->gf.getCTX());
+    fq_poly_clear(this->shifted, this->gf.getCTX());
+    fq_clear(this->previous_discrepancy, this->gf.getCTX());
+    _fq_vec_clear(this->history, this->capacity, this->gf.getCTX());
+}
+
+// Когда место кончается, ненужное начало истории отбрасывается, а если
+// освободилось меньше половины, история вдвое увеличивается.
+void GFLinearComplexity::store(const fq_t element) {
+    if (this->n - this->base == static_cast<uint64_t>(this->capacity)) {
+        const uint64_t keep = std::min(static_cast<uint64_t>(this->L), this->n - static_cast<uint64_t>(this->L));
+        const slong kept = static_cast<slong>(this->n - keep);
+        fq_struct *history = this->history;
+        if (2 * kept > this->capacity) history = _fq_vec_init(2 * this->capacity, this->gf.getCTX());
+        for (slong i = 0; i < kept; ++i)
+            fq_swap(history + i, this->history + (keep - this->base) + i, this->gf.getCTX());
+        if (history != this->history) {
+            _fq_vec_clear(this->history, this->capacity, this->gf.getCTX());
+            this->history = history;
+            this->capacity *= 2;
+        }
+        this->base = keep;
+    }
+    fq_set(this->history + (this->n - this->base), element, this->gf.getCTX());
+}
+
+slong GFLinearComplexity::push(const GFElement &element) {
+    const fq_ctx_t &ctx = this->gf.getCTX();
+    this->store(element.raw());
+    fq_t discrepancy, term;
+    fq_init(discrepancy, ctx);
+    fq_init(term, ctx);
+    const slong terms = std::min(this->L + 1, fq_poly_length(this->connection, ctx));
+    for (slong i = 0; i < terms; ++i) {
+        fq_mul(term, this->connection->coeffs + i, this->history + (this->n - i - this->base), ctx);
+        fq_add(discrepancy, discrepancy, term, ctx);
+    }
+    if (fq_is_zero(discrepancy, ctx)) ++this->shift;
+    else {
+        // shifted = C(x) - d / b * x^shift * B(x).
+        fq_div(term, discrepancy, this->previous_discrepancy, ctx);
+        fq_poly_shift_left(this->shifted, this->previous, this->shift, ctx);
+        fq_poly_scalar_mul_fq(this->shifted, this->shifted, term, ctx);
+        fq_poly_sub(this->shifted, this->connection, this->shifted, ctx);
+        if (2 * static_cast<uint64_t>(this->L) <= this->n) {
+            fq_poly_swap(this->previous, this->connection, ctx);
+            fq_set(this->previous_discrepancy, discrepancy, ctx);
+            this->L = static_cast<slong>(this->n) + 1 - this->L;
+            this->shift = 1;
+        } else ++this->shift;
+        fq_poly_swap(this->connection, this->shifted, ctx);
+    }
+    fq_clear(discrepancy, ctx);
+    fq_clear(term, ctx);
+    ++this->n;
+    return this->L;
+}
+
+slong GFLinearComplexity::complexity() const {
+    return this->L;
+}
+
+uint64_t GFLinearComplexity::length() const {
+    return this->n;
+}
+
+std::string GFLinearComplexity::connectionPolynomial() const {
+    char *str = fq_poly_get_str_pretty(this->connection, "x", this->gf.getCTX());
+    std::string result(str);
+    flint_free(str);
+    return result;
+}
@@ -0,0 +1,39 @@
+#ifndef GF_LINEAR_COMPLEXITY_HPP
+#define GF_LINEAR_COMPLEXITY_HPP
+
+#include "GF.hpp"
+#include <flint/fq_poly.h>
+#include <string>
+
+// Алгоритм Берлекэмпа-Мэсси над GF(q), получающий последовательность по одному
+// элементу (для GF(2) см. LinearComplexity.h). Как и там, хранятся только элементы
+// с индексами не меньше min(L, n - L): более ранние в невязках уже не участвуют.
+class GFLinearComplexity {
+public:
+    explicit GFLinearComplexity(const GF &gf);
+    GFLinearComplexity(const GFLinearComplexity &other) = delete;
+    GFLinearComplexity &operator=(const GFLinearComplexity &other) = delete;
+    ~GFLinearComplexity();
+    // Добавляет очередной элемент и возвращает линейную сложность полученной части.
+    slong push(const GFElement &element);
+    slong complexity() const;
+    uint64_t length() const;
+    // Многочлен связи C(x), s_n + c_1 s_(n - 1) + ... + c_L s_(n - L) = 0.
+    std::string connectionPolynomial() const;
+private:
+    const GF &gf;
+    fq_poly_t connection, previous, shifted;
+    // Невязка на шаге последнего изменения L.
+    fq_t previous_discrepancy;
+    slong L;
+    slong shift;
+    uint64_t n;
+    // s_j хранится в history[j - base].
+    fq_struct *history;
+    slong capacity;
+    uint64_t base;
+
+    void store(const fq_t element);
+};
+
+#endif
@@ -7,7 +7,7 @@ static int noop(const char *__restrict__ __format, ...) {
     return 0;
 }
 
-static int (*printSearchLog)(const char *__restrict__ __format, ...) = noop;
+int (*printSearchLog)(const char *__restrict__ __format, ...) = noop;
 
 void enablePrintSearchLog() {
     printSearchLog = printf;
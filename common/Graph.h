@@ -10,6 +10,8 @@ struct Graph {
     uint64_t num_of_nodes;
 };
 
+// Журнал поиска печатается через printSearchLog, после enablePrintSearchLog - это printf.
+extern int (*printSearchLog)(const char *__restrict__ __format, ...);
 void enablePrintSearchLog();
 int initGraph(struct Graph *graph, uint64_t num_of_nodes);
 void freeGraph(struct Graph *graph);
@@ -6,4 +6,22 @@ uint64_t hashBytes(const void *data, size_t length) {
     for (size_t i = 0; i < length; ++i)
         hash = ((hash << 5) + hash) + ptr[i];
     return hash;
+}
+
+uint64_t hashBlocks(const void *data, size_t length) {
+    const uint64_t prime = 0x9E3779B97F4A7C15;
+    uint64_t lanes[4] = {1, 2, 3, 4};
+    const uint8_t *ptr = (const uint8_t *)data;
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32)
+        for (int j = 0; j < 4; ++j) {
+            uint64_t word;
+            memcpy(&word, ptr + i + 8 * j, sizeof(word));
+            lanes[j] = (lanes[j] ^ word) * prime;
+            lanes[j] ^= lanes[j] >> 29;
+        }
+    uint64_t hash = hashBytes(ptr + i, length - i);
+    for (int j = 0; j < 4; ++j)
+        hash = (hash ^ lanes[j]) * prime;
+    return hash ^ (hash >> 32) ^ length;
 }
\ No newline at end of file
@@ -8,5 +8,7 @@ typedef uint64_t (*Hash)(void *value);
 
 // Простая хэш-функция (djb2).
 uint64_t hashBytes(const void *data, size_t length);
+// Хэш для больших буферов: обрабатывает по 64-битному слову в четыре независимые цепочки.
+uint64_t hashBlocks(const void *data, size_t length);
 
 #endif
\ No newline at end of file
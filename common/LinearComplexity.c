@@ -0,0 +1,149 @@
+#include "LinearComplexity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#define INITIAL_HISTORY_WORDS 1024
+
+int initLinearComplexity(LinearComplexity *lc) {
+    lc->complexity = 0;
+    lc->num_of_bits = 0;
+    lc->shift = 1;
+    lc->num_of_words = 1;
+    lc->connection = calloc(1, sizeof(uint64_t));
+    lc->previous = calloc(1, sizeof(uint64_t));
+    lc->history_words = INITIAL_HISTORY_WORDS;
+    lc->history = calloc(lc->history_words + 1, sizeof(uint64_t));
+    lc->origin = lc->history_words * 64 - 1;
+    if (!lc->connection || !lc->previous || !lc->history) {
+        freeLinearComplexity(lc);
+        return -1;
+    }
+    lc->connection[0] = lc->previous[0] = 1;
+    return 0;
+}
+
+static int reserveWords(LinearComplexity *lc, uint64_t num_of_words) {
+    if (num_of_words <= lc->num_of_words) return 0;
+    if (num_of_words < 2 * lc->num_of_words) num_of_words = 2 * lc->num_of_words;
+    uint64_t *connection = realloc(lc->connection, num_of_words * sizeof(uint64_t));
+    if (!connection) return -1;
+    lc->connection = connection;
+    uint64_t *previous = realloc(lc->previous, num_of_words * sizeof(uint64_t));
+    if (!previous) return -1;
+    lc->previous = previous;
+    memset(lc->connection + lc->num_of_words, 0, (num_of_words - lc->num_of_words) * sizeof(uint64_t));
+    memset(lc->previous + lc->num_of_words, 0, (num_of_words - lc->num_of_words) * sizeof(uint64_t));
+    lc->num_of_words = num_of_words;
+    return 0;
+}
+
+// Вызывается, когда позиция для очередного бита ушла бы ниже нуля. Биты с индексами
+// не меньше min(L, n - L) переносятся в конец нового массива, вдвое большего их.
+static int growHistory(LinearComplexity *lc) {
+    const uint64_t n = lc->num_of_bits;
+    const uint64_t keep = lc->complexity < n - lc->complexity ? lc->complexity : n - lc->complexity;
+    const uint64_t kept_words = ((lc->origin - keep) >> 6) + 1;
+    const uint64_t history_words = kept_words < INITIAL_HISTORY_WORDS / 2 ? INITIAL_HISTORY_WORDS : 2 * kept_words;
+    const uint64_t room = history_words - kept_words;
+    uint64_t *history = calloc(history_words + 1, sizeof(uint64_t));
+    if (!history) return -1;
+    memcpy(history + room, lc->history, kept_words * sizeof(uint64_t));
+    free(lc->history);
+    lc->history = history;
+    lc->history_words = history_words;
+    lc->origin += room * 64;
+    return 0;
+}
+
+// Сумма c_i * s_(n - i) по i от 0 до L.
+static uint8_t getDiscrepancy(const LinearComplexity *lc, uint64_t position) {
+    const uint64_t *history = lc->history + (position >> 6);
+    const unsigned offset = position & 63;
+    const uint64_t top = lc->complexity >> 6;
+    uint64_t sum = 0;
+    if (offset)
+        for (uint64_t k = 0; k <= top; ++k)
+            sum ^= lc->connection[k] & (history[k] >> offset | history[k + 1] << (64 - offset));
+    else
+        for (uint64_t k = 0; k <= top; ++k) sum ^= lc->connection[k] & history[k];
+    return __builtin_parityll(sum);
+}
+
+// Слово k многочлена polynomial * x^shift.
+static inline uint64_t getShiftedWord(const uint64_t *polynomial, uint64_t shift, uint64_t k) {
+    const uint64_t words = shift >> 6;
+    const unsigned bits = shift & 63;
+    if (k < words) return 0;
+    uint64_t word = polynomial[k - words] << bits;
+    if (bits && k > words) word |= polynomial[k - words - 1] >> (64 - bits);
+    return word;
+}
+
+// target += source * x^shift в словах до top включительно.
+static void addShifted(uint64_t *restrict target, const uint64_t *restrict source, uint64_t shift, uint64_t top) {
+    const uint64_t words = shift >> 6;
+    const unsigned bits = shift & 63;
+    if (words > top) return;
+    if (!bits) {
+        for (uint64_t k = words; k <= top; ++k) target[k] ^= source[k - words];
+        return;
+    }
+    target[words] ^= source[0] << bits;
+    for (uint64_t k = words + 1; k <= top; ++k)
+        target[k] ^= source[k - words] << bits | source[k - words - 1] >> (64 - bits);
+}
+
+int pushLinearComplexityBit(LinearComplexity *lc, uint8_t bit) {
+    const uint64_t n = lc->num_of_bits;
+    if (n > lc->origin && growHistory(lc)) return -1;
+    const uint64_t position = lc->origin - n;
+    lc->history[position >> 6] |= (uint64_t)(bit & 1) << (position & 63);
+    if (!getDiscrepancy(lc, position)) ++lc->shift;
+    else if (2 * lc->complexity <= n) {
+        const uint64_t complexity = n + 1 - lc->complexity;
+        if (reserveWords(lc, (complexity >> 6) + 1)) return -1;
+        // previous = previous * x^shift + connection, затем они меняются местами.
+        // Сверху вниз, поэтому сдвиг на месте не портит ещё не прочитанные слова.
+        for (uint64_t k = (complexity >> 6) + 1; k-- > 0;)
+            lc->previous[k] = getShiftedWord(lc->previous, lc->shift, k) ^ lc->connection[k];
+        uint64_t *connection = lc->previous;
+        lc->previous = lc->connection;
+        lc->connection = connection;
+        lc->complexity = complexity;
+        lc->shift = 1;
+    } else {
+        addShifted(lc->connection, lc->previous, lc->shift, lc->complexity >> 6);
+        ++lc->shift;
+    }
+    ++lc->num_of_bits;
+    return 0;
+}
+
+int pushLinearComplexityWords(
+    LinearComplexity *lc, const uint64_t *words, uint64_t num_of_bits,
+    int (*on_change)(void *context, const LinearComplexity *lc), void *context
+) {
+    for (uint64_t i = 0; i < num_of_bits; ++i) {
+        const uint64_t complexity = lc->complexity;
+        if (pushLinearComplexityBit(lc, (uint8_t)(words[i >> 6] >> (i & 63)) & 1)) return -1;
+        if (on_change && lc->complexity != complexity && on_change(context, lc)) return -2;
+    }
+    return 0;
+}
+
+void printConnectionPolynomial(const LinearComplexity *lc, FILE *fp) {
+    fprintf(fp, "1");
+    for (uint64_t i = 1; i <= lc->complexity; ++i)
+        if ((lc->connection[i >> 6] >> (i & 63)) & 1) {
+            if (i == 1) fprintf(fp, " + x");
+            else fprintf(fp, " + x^%" PRIu64, i);
+        }
+}
+
+void freeLinearComplexity(LinearComplexity *lc) {
+    free(lc->connection);
+    free(lc->previous);
+    free(lc->history);
+    lc->connection = lc->previous = lc->history = NULL;
+}
@@ -0,0 +1,48 @@
+#ifndef LINEAR_COMPLEXITY_H
+#define LINEAR_COMPLEXITY_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Алгоритм Берлекэмпа-Мэсси над GF(2), получающий последовательность по битам.
+// Многочлены и история хранятся упакованными по 64 бита, так что шаг стоит
+// O(L / 64) операций со словами. Вся последовательность не хранится: биты с
+// индексами меньше min(L, n - L) больше не участвуют в невязках и отбрасываются
+// при расширении истории.
+typedef struct {
+    // Линейная сложность L уже полученной части последовательности.
+    uint64_t complexity;
+    uint64_t num_of_bits;
+    // Число шагов с последнего изменения L (x^shift при прибавлении previous).
+    uint64_t shift;
+    // Многочлен связи C(x): бит i - коэффициент при x^i; previous - C до
+    // последнего изменения L. Оба по num_of_words слов.
+    uint64_t *connection;
+    uint64_t *previous;
+    uint64_t num_of_words;
+    // Бит s_j лежит на позиции origin - j, так что s_n, s_(n - 1), ... идут
+    // подряд и умножаются на C пословно. За history_words словами - нулевое.
+    uint64_t *history;
+    uint64_t history_words;
+    uint64_t origin;
+} LinearComplexity;
+
+int initLinearComplexity(LinearComplexity *lc);
+// Добавляет очередной бит. Возвращает -1, если не хватило памяти.
+int pushLinearComplexityBit(LinearComplexity *lc, uint8_t bit);
+// num_of_bits битов, упакованных по 64 в слово (младший первый). Если on_change != NULL,
+// он вызывается после каждого бита, изменившего линейную сложность; ненулевой
+// результат прерывает обработку. Возвращает -1, если не хватило памяти, -2 при отказе on_change.
+int pushLinearComplexityWords(
+    LinearComplexity *lc, const uint64_t *words, uint64_t num_of_bits,
+    int (*on_change)(void *context, const LinearComplexity *lc), void *context
+);
+// Печатает многочлен связи в виде 1 + x^3 + x^5.
+void printConnectionPolynomial(const LinearComplexity *lc, FILE *fp);
+void freeLinearComplexity(LinearComplexity *lc);
+
+static inline uint64_t getLinearComplexity(const LinearComplexity *lc) {
+    return lc->complexity;
+}
+
+#endif
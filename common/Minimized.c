@@ -1,27 +1,102 @@
 #include "Minimized.h"
+#include "Alloc.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <inttypes.h>
 
+void initMinimized(struct Minimized *minimized, uint64_t num_of_states) {
+    memset(minimized, 0, sizeof(struct Minimized));
+    minimized->num_of_states = num_of_states;
+}
+
+int addMinimizedRound(struct Minimized *minimized, uint64_t num_of_classes) {
+    if (minimized->degree_of_distinguishability == minimized->round_classes_capacity) {
+        const uint64_t capacity = minimized->round_classes_capacity ? 2 * minimized->round_classes_capacity : 16;
+        uint64_t *grown = realloc(minimized->round_classes, capacity * sizeof(uint64_t));
+        if (!grown) return -1;
+        minimized->round_classes = grown;
+        minimized->round_classes_capacity = capacity;
+    }
+    minimized->round_classes[minimized->degree_of_distinguishability++] = num_of_classes;
+    return 0;
+}
+
 void freeMinimized(struct Minimized *minimized) {
-    clearListOfEquivalenceClasses(
-        minimized->equivalence_classes,
-        minimized->freeValue
-    );
-    free(minimized->equivalence_classes);
+    if (minimized->equivalence_classes) {
+        clearListOfEquivalenceClasses(
+            minimized->equivalence_classes,
+            minimized->freeValue
+        );
+        free(minimized->equivalence_classes);
+        minimized->equivalence_classes = NULL;
+    }
+    if (minimized->class_of)
+        freeLarge(minimized->class_of, minimized->num_of_states * sizeof(uint32_t), minimized->class_of_kind);
+    minimized->class_of = NULL;
+    free(minimized->round_classes);
+    minimized->round_classes = NULL;
+    minimized->round_classes_capacity = 0;
     minimized->degree_of_distinguishability = 0;
     minimized->original_is_minimal = 0;
 }
 
 void printMinimized(struct Minimized *minimized) {
-    printf("Классы эквивалентности:\n");
-    printListOfEquivalenceClasses(
-        minimized->equivalence_classes,
-        minimized->printState
-    );
-    printf("Приведённый вес: %" PRIu64 "\n", getListSize(minimized->equivalence_classes));
+    if (minimized->equivalence_classes) {
+        printf("Классы эквивалентности:\n");
+        printListOfEquivalenceClasses(
+            minimized->equivalence_classes,
+            minimized->printState
+        );
+    }
+    printf("Приведённый вес: %" PRIu64 "\n", minimized->num_of_classes);
     printf("Степень различимости: %" PRIu64 "\n", minimized->degree_of_distinguishability);
     printf("Минимальный? ");
     if (minimized->original_is_minimal) printf("Да\n");
     else printf("Нет\n");
-}
\ No newline at end of file
+}
+
+int saveMinimizedToFile(const struct Minimized *minimized, const char *file, uint8_t with_rounds) {
+    if (!minimized->class_of) return -1;
+    FILE *fp = fopen(file, "wb");
+    if (!fp) return -2;
+    struct MinimizedFileHeader header = {
+        .version = MINIMIZED_FILE_VERSION,
+        .original_is_minimal = minimized->original_is_minimal,
+        .num_of_states = minimized->num_of_states,
+        .num_of_classes = minimized->num_of_classes,
+        .degree_of_distinguishability = minimized->degree_of_distinguishability,
+        .num_of_rounds = with_rounds ? minimized->degree_of_distinguishability : 0
+    };
+    memcpy(header.magic, MINIMIZED_FILE_MAGIC, sizeof(header.magic));
+    int rc = 0;
+    static const char zeros[4096];
+    if (fwrite(&header, sizeof(header), 1, fp) != 1) {
+        rc = -3;
+        goto end;
+    }
+    for (uint64_t written = sizeof(header); written < MINIMIZED_FILE_DATA_OFFSET;) {
+        size_t chunk = MINIMIZED_FILE_DATA_OFFSET - written < sizeof(zeros) ?
+            MINIMIZED_FILE_DATA_OFFSET - written : sizeof(zeros);
+        if (fwrite(zeros, 1, chunk, fp) != chunk) {
+            rc = -3;
+            goto end;
+        }
+        written += chunk;
+    }
+    if (fwrite(minimized->class_of, sizeof(uint32_t), minimized->num_of_states, fp) != minimized->num_of_states) {
+        rc = -3;
+        goto end;
+    }
+    if (!header.num_of_rounds) goto end;
+    // Числа по шагам выравниваются на 8.
+    if ((minimized->num_of_states & 1) && fwrite(zeros, sizeof(uint32_t), 1, fp) != 1) {
+        rc = -3;
+        goto end;
+    }
+    if (fwrite(minimized->round_classes, sizeof(uint64_t), header.num_of_rounds, fp) != header.num_of_rounds)
+        rc = -3;
+end:
+    if (fclose(fp) && !rc) rc = -3;
+    return rc;
+}
@@ -4,15 +4,55 @@
 #include <stdint.h>
 #include "EquivalenceClass.h"
 
+// Что строит минимизация (флаги minimizeShiftRegisterInThreads). Без флагов остаются
+// только вес, степень различимости и число классов по шагам.
+#define MINIMIZE_PRINT_ROUNDS 1 // печатать классы каждого шага
+#define MINIMIZE_CLASS_LIST 2   // список классов equivalence_classes
+#define MINIMIZE_CLASS_ARRAY 4  // массив class_of
+
+// Двоичный файл разбиения: заголовок, затем с MINIMIZED_FILE_DATA_OFFSET - массив
+// class_of (uint32_t на состояние), за ним, если записаны, num_of_rounds чисел
+// классов по шагам (uint64_t, с выравниванием на 8). Смещение кратно странице,
+// так что массив отображается в память без копирования.
+#define MINIMIZED_FILE_MAGIC "CLASSMAP"
+#define MINIMIZED_FILE_VERSION 1
+#define MINIMIZED_FILE_DATA_OFFSET ((uint64_t)1 << 16)
+
+struct MinimizedFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t original_is_minimal;
+    uint64_t num_of_states;
+    uint64_t num_of_classes;
+    uint64_t degree_of_distinguishability;
+    uint64_t num_of_rounds;
+};
+
 struct Minimized {
+    // NULL, если список не строился.
     List *equivalence_classes;
     uint8_t original_is_minimal;
     uint64_t degree_of_distinguishability;
     PrintValue printState;
     FreeValueFunction freeValue;
+    uint64_t num_of_states;
+    uint64_t num_of_classes;
+    // Номер класса каждого состояния, классы нумеруются в порядке списка. NULL, если
+    // массив не строился.
+    uint32_t *class_of;
+    uint8_t class_of_kind;
+    // Число классов на каждом шаге, degree_of_distinguishability чисел.
+    uint64_t *round_classes;
+    uint64_t round_classes_capacity;
 };
 
+void initMinimized(struct Minimized *minimized, uint64_t num_of_states);
+int addMinimizedRound(struct Minimized *minimized, uint64_t num_of_classes);
 void freeMinimized(struct Minimized *minimized);
+// Список классов, если он есть, и итоги.
 void printMinimized(struct Minimized *minimized);
+// Записывает class_of и, если with_rounds, числа классов по шагам. Возвращает -1,
+// если массива нет, -2, если файл не открывается, -3 при ошибке записи.
+int saveMinimizedToFile(const struct Minimized *minimized, const char *file, uint8_t with_rounds);
 
-#endif
\ No newline at end of file
+#endif
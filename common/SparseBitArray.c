@@ -0,0 +1,139 @@
+#include "SparseBitArray.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Слово из 16 битов блока; за концом массива - нули.
+static uint16_t getDenseWord(const BitArray *dense, uint64_t word) {
+    const uint64_t size = (dense->length + 7) / 8;
+    uint16_t value = 0;
+    if (2 * word < size) value = dense->bucket[2 * word];
+    if (2 * word + 1 < size) value |= (uint16_t)dense->bucket[2 * word + 1] << 8;
+    return value;
+}
+
+int initSparseBitArray(SparseBitArray *array, const BitArray *dense) {
+    memset(array, 0, sizeof(*array));
+    array->length = dense->length;
+    const uint64_t num_of_words = (dense->length + 15) / 16;
+    const uint64_t max_blocks = (num_of_words + SPARSE_BLOCK_WORDS - 1) / SPARSE_BLOCK_WORDS;
+    uint64_t *counts = calloc(max_blocks ? max_blocks : 1, sizeof(uint64_t));
+    if (!counts) return -1;
+    for (uint64_t word = 0; word < num_of_words; ++word)
+        counts[word / SPARSE_BLOCK_WORDS] += __builtin_popcount(getDenseWord(dense, word));
+    uint64_t data_size = 0;
+    for (uint64_t block = 0; block < max_blocks; ++block) {
+        if (!counts[block]) continue;
+        ++array->num_of_blocks;
+        data_size += counts[block] > SPARSE_BLOCK_MAX_LIST ? SPARSE_BLOCK_WORDS : counts[block];
+    }
+    array->directory = malloc((max_blocks ? max_blocks : 1) * sizeof(uint32_t));
+    array->keys = malloc((array->num_of_blocks ? array->num_of_blocks : 1) * sizeof(uint32_t));
+    array->ranks = malloc((array->num_of_blocks + 1) * sizeof(uint64_t));
+    array->offsets = malloc((array->num_of_blocks ? array->num_of_blocks : 1) * sizeof(uint64_t));
+    array->data = malloc((data_size ? data_size : 1) * sizeof(uint16_t));
+    if (!array->directory || !array->keys || !array->ranks || !array->offsets || !array->data) {
+        free(counts);
+        freeSparseBitArray(array);
+        return -1;
+    }
+    uint32_t b = 0;
+    uint64_t rank = 0, offset = 0;
+    for (uint64_t block = 0; block < max_blocks; ++block) {
+        array->directory[block] = counts[block] ? b : SPARSE_NO_BLOCK;
+        if (!counts[block]) continue;
+        array->keys[b] = (uint32_t)block;
+        array->ranks[b] = rank;
+        array->offsets[b] = offset;
+        uint16_t *data = array->data + offset;
+        const uint64_t first = block * SPARSE_BLOCK_WORDS;
+        if (counts[block] > SPARSE_BLOCK_MAX_LIST) {
+            for (uint64_t word = 0; word < SPARSE_BLOCK_WORDS; ++word)
+                data[word] = getDenseWord(dense, first + word);
+            offset += SPARSE_BLOCK_WORDS;
+        } else {
+            for (uint64_t word = 0; word < SPARSE_BLOCK_WORDS && first + word < num_of_words; ++word)
+                for (uint16_t bits = getDenseWord(dense, first + word); bits; bits &= bits - 1)
+                    *data++ = (uint16_t)(word * 16 + __builtin_ctz(bits));
+            offset += counts[block];
+        }
+        rank += counts[block];
+        ++b;
+    }
+    array->ranks[b] = rank;
+    free(counts);
+    return 0;
+}
+
+int sparseBitArrayToBitArray(BitArray *dense, const SparseBitArray *array) {
+    if (initBitArray(dense, array->length)) return -1;
+    for (uint32_t b = 0; b < array->num_of_blocks; ++b) {
+        const uint16_t *data = array->data + array->offsets[b];
+        const uint64_t size = getSparseBlockSize(array, b);
+        const uint64_t first = (uint64_t)array->keys[b] << SPARSE_BLOCK_BITS;
+        if (size > SPARSE_BLOCK_MAX_LIST) {
+            for (uint64_t i = 0; i < (uint64_t)1 << SPARSE_BLOCK_BITS && first + i < array->length; ++i)
+                if ((data[i >> 4] >> (i & 15)) & 1) setBitArrayElement(dense, first + i, 1);
+        } else for (uint64_t j = 0; j < size; ++j) setBitArrayElement(dense, first + data[j], 1);
+    }
+    return 0;
+}
+
+void freeSparseBitArray(SparseBitArray *array) {
+    free(array->directory);
+    free(array->keys);
+    free(array->ranks);
+    free(array->offsets);
+    free(array->data);
+    memset(array, 0, sizeof(*array));
+}
+
+uint64_t getSparseBitArraySize(const SparseBitArray *array) {
+    if (!array->ranks) return 0;
+    const uint64_t num_of_words = (array->length + 15) / 16;
+    uint64_t size = (num_of_words + SPARSE_BLOCK_WORDS - 1) / SPARSE_BLOCK_WORDS * sizeof(uint32_t) +
+        (uint64_t)array->num_of_blocks * (sizeof(uint32_t) + 2 * sizeof(uint64_t)) + sizeof(uint64_t);
+    for (uint32_t b = 0; b < array->num_of_blocks; ++b) {
+        const uint64_t block_size = getSparseBlockSize(array, b);
+        size += (block_size > SPARSE_BLOCK_MAX_LIST ? SPARSE_BLOCK_WORDS : block_size) * sizeof(uint16_t);
+    }
+    return size;
+}
+
+uint64_t rankSparseBitArray(const SparseBitArray *array, uint64_t i) {
+    if (i >= array->length) return array->ranks[array->num_of_blocks];
+    const uint32_t key = (uint32_t)(i >> SPARSE_BLOCK_BITS);
+    uint32_t low = 0, high = array->num_of_blocks;
+    while (low < high) {
+        const uint32_t middle = (low + high) >> 1;
+        if (array->keys[middle] < key) low = middle + 1;
+        else high = middle;
+    }
+    uint64_t rank = array->ranks[low];
+    if (low == array->num_of_blocks || array->keys[low] != key) return rank;
+    const uint16_t *data = array->data + array->offsets[low];
+    const uint64_t size = getSparseBlockSize(array, low);
+    const uint16_t position = (uint16_t)(i & ((1 << SPARSE_BLOCK_BITS) - 1));
+    if (size <= SPARSE_BLOCK_MAX_LIST) return rank + lowerBoundSparseList(data, size, position);
+    for (uint16_t word = 0; word < position >> 4; ++word) rank += __builtin_popcount(data[word]);
+    return rank + __builtin_popcount(data[position >> 4] & ((1u << (position & 15)) - 1));
+}
+
+uint64_t selectSparseBitArray(const SparseBitArray *array, uint64_t k) {
+    if (k >= array->ranks[array->num_of_blocks]) return array->length;
+    // Последний блок, до которого меньше k + 1 единиц.
+    uint32_t low = 0, high = array->num_of_blocks - 1;
+    while (low < high) {
+        const uint32_t middle = (low + high + 1) >> 1;
+        if (array->ranks[middle] <= k) low = middle;
+        else high = middle - 1;
+    }
+    const uint16_t *data = array->data + array->offsets[low];
+    const uint64_t first = (uint64_t)array->keys[low] << SPARSE_BLOCK_BITS;
+    uint64_t rest = k - array->ranks[low];
+    if (getSparseBlockSize(array, low) <= SPARSE_BLOCK_MAX_LIST) return first + data[rest];
+    uint64_t word = 0;
+    for (; (uint64_t)__builtin_popcount(data[word]) <= rest; ++word) rest -= __builtin_popcount(data[word]);
+    uint16_t bits = data[word];
+    for (; rest; --rest) bits &= bits - 1;
+    return first + word * 16 + __builtin_ctz(bits);
+}
@@ -0,0 +1,74 @@
+#ifndef SPARSE_BIT_ARRAY_H
+#define SPARSE_BIT_ARRAY_H
+
+#include <stdint.h>
+#include "BitArray.h"
+
+// Разреженный массив битов в духе roaring: индексы делятся на блоки по 2^16 битов,
+// хранятся только непустые блоки. Блок, в котором не больше
+// SPARSE_BLOCK_MAX_LIST единиц, хранится отсортированным списком младших 16 битов
+// их индексов, иначе - плотной картой на 8 КиБ. Массив только читается.
+#define SPARSE_BLOCK_BITS 16
+#define SPARSE_BLOCK_WORDS ((1 << SPARSE_BLOCK_BITS) / 16)
+#define SPARSE_BLOCK_MAX_LIST SPARSE_BLOCK_WORDS
+
+#define SPARSE_NO_BLOCK UINT32_MAX
+
+typedef struct {
+    uint64_t length;
+    uint32_t num_of_blocks;
+    // Для каждого блока массива - его место среди непустых или SPARSE_NO_BLOCK.
+    uint32_t *directory;
+    // Номера непустых блоков по возрастанию.
+    uint32_t *keys;
+    // ranks[b] - число единиц в блоках до b-го, ranks[num_of_blocks] - всего единиц.
+    uint64_t *ranks;
+    // Начало данных блока в data.
+    uint64_t *offsets;
+    uint16_t *data;
+} SparseBitArray;
+
+int initSparseBitArray(SparseBitArray *array, const BitArray *dense);
+int sparseBitArrayToBitArray(BitArray *dense, const SparseBitArray *array);
+void freeSparseBitArray(SparseBitArray *array);
+uint64_t getSparseBitArraySize(const SparseBitArray *array);
+// Число единиц с индексами меньше i.
+uint64_t rankSparseBitArray(const SparseBitArray *array, uint64_t i);
+// Индекс k-й (с нуля) единицы; length, если единиц не больше k.
+uint64_t selectSparseBitArray(const SparseBitArray *array, uint64_t k);
+
+static inline uint64_t getSparseBlockSize(const SparseBitArray *array, uint32_t block) {
+    return array->ranks[block + 1] - array->ranks[block];
+}
+
+// Первая позиция в списке, значение в которой не меньше value.
+// Поиск без ветвлений: число шагов зависит только от size.
+static inline uint64_t lowerBoundSparseList(const uint16_t *list, uint64_t size, uint16_t value) {
+    const uint16_t *base = list;
+    while (size > 1) {
+        const uint64_t half = size >> 1;
+        base = base[half - 1] < value ? base + half : base;
+        size -= half;
+    }
+    return (uint64_t)(base - list) + (size && *base < value);
+}
+
+// Биты i, ..., i + 3 (i кратно 4) младшими битами результата.
+static inline uint8_t getSparseBitArrayNibble(const SparseBitArray *array, uint64_t i) {
+    const uint32_t block = array->directory[i >> SPARSE_BLOCK_BITS];
+    if (block == SPARSE_NO_BLOCK) return 0;
+    const uint16_t *data = array->data + array->offsets[block];
+    const uint64_t size = getSparseBlockSize(array, block);
+    const uint16_t low = (uint16_t)(i & ((1 << SPARSE_BLOCK_BITS) - 1));
+    if (size > SPARSE_BLOCK_MAX_LIST) return (data[low >> 4] >> (low & 15)) & 0xF;
+    uint8_t nibble = 0;
+    for (uint64_t j = lowerBoundSparseList(data, size, low); j < size && data[j] < low + 4; ++j)
+        nibble |= (uint8_t)(1 << (data[j] - low));
+    return nibble;
+}
+
+static inline uint8_t getSparseBitArrayElement(const SparseBitArray *array, uint64_t i) {
+    return (getSparseBitArrayNibble(array, i & ~(uint64_t)3) >> (i & 3)) & 1;
+}
+
+#endif
@@ -0,0 +1,280 @@
+#include "Transform.h"
+#include <pthread.h>
+
+// Уровни с шагом меньше TRANSFORM_BLOCK элементов проходятся целиком внутри блока,
+// пока он лежит в кэше; остальные - попарно (два уровня за один проход по памяти).
+#define TRANSFORM_BLOCK ((uint64_t)1 << 13)
+
+struct ParallelRange {
+    void (*body)(void *context, uint64_t begin, uint64_t end);
+    void *context;
+    uint64_t begin;
+    uint64_t end;
+    pthread_t thread;
+};
+
+static void *runRange(void *arg) {
+    struct ParallelRange *range = arg;
+    range->body(range->context, range->begin, range->end);
+    return NULL;
+}
+
+// Делит [0, count) на num_of_threads равных частей. Если поток не создаётся,
+// его часть выполняется в вызывающем.
+static void parallelFor(
+    uint64_t count, unsigned num_of_threads,
+    void (*body)(void *context, uint64_t begin, uint64_t end), void *context
+) {
+    if (num_of_threads > count) num_of_threads = (unsigned)count;
+    if (num_of_threads <= 1) {
+        body(context, 0, count);
+        return;
+    }
+    struct ParallelRange ranges[num_of_threads];
+    uint8_t started[num_of_threads];
+    for (unsigned i = 0; i < num_of_threads; ++i) {
+        ranges[i] = (struct ParallelRange){
+            body, context, count * i / num_of_threads, count * (i + 1) / num_of_threads, 0
+        };
+        started[i] = i && !pthread_create(&ranges[i].thread, NULL, runRange, &ranges[i]);
+        if (i && !started[i]) runRange(&ranges[i]);
+    }
+    runRange(&ranges[0]);
+    for (unsigned i = 1; i < num_of_threads; ++i)
+        if (started[i]) pthread_join(ranges[i].thread, NULL);
+}
+
+struct Level {
+    void *vector;
+    uint64_t size;
+    // Шаг младшего из обрабатываемых уровней.
+    uint64_t step;
+};
+
+static void mobiusWords(void *context, uint64_t begin, uint64_t end) {
+    // Маски точек, в которых переменная i равна 1, для i < 6.
+    static const uint64_t masks[6] = {
+        0xAAAAAAAAAAAAAAAA, 0xCCCCCCCCCCCCCCCC, 0xF0F0F0F0F0F0F0F0,
+        0xFF00FF00FF00FF00, 0xFFFF0000FFFF0000, 0xFFFFFFFF00000000
+    };
+    const struct Level *level = context;
+    uint64_t *vector = level->vector;
+    for (uint64_t w = begin; w < end; ++w) {
+        uint64_t word = vector[w];
+        for (uint8_t i = 0; i < level->step; ++i)
+            word ^= (word << (1u << i)) & masks[i];
+        vector[w] = word;
+    }
+}
+
+static void mobiusBlocks(void *context, uint64_t begin, uint64_t end) {
+    const struct Level *level = context;
+    uint64_t *vector = level->vector;
+    const uint64_t block = level->size < TRANSFORM_BLOCK ? level->size : TRANSFORM_BLOCK;
+    for (uint64_t b = begin; b < end; ++b) {
+        uint64_t *words = vector + b * block;
+        for (uint64_t step = 1; step < block; step <<= 1)
+            for (uint64_t group = 0; group < block; group += step << 1)
+                for (uint64_t w = group; w < group + step; ++w)
+                    words[w + step] ^= words[w];
+    }
+}
+
+// Номер t (из size / 2) пары уровня step переводится в младший индекс пары.
+static inline uint64_t getPairIndex(uint64_t t, uint64_t step) {
+    return ((t / step) * step << 1) + t % step;
+}
+
+static void mobiusLevel(void *context, uint64_t begin, uint64_t end) {
+    const struct Level *level = context;
+    uint64_t *vector = level->vector;
+    const uint64_t step = level->step;
+    for (uint64_t t = begin; t < end;) {
+        const uint64_t first = getPairIndex(t, step);
+        const uint64_t run = step - t % step < end - t ? step - t % step : end - t;
+        for (uint64_t w = first; w < first + run; ++w) vector[w + step] ^= vector[w];
+        t += run;
+    }
+}
+
+// Уровни step и 2 * step за один проход, как в walshHadamardTwoLevels.
+static void mobiusTwoLevels(void *context, uint64_t begin, uint64_t end) {
+    const struct Level *level = context;
+    uint64_t *vector = level->vector;
+    const uint64_t step = level->step;
+    for (uint64_t t = begin; t < end;) {
+        const uint64_t first = ((t / step) * step << 2) + t % step;
+        const uint64_t run = step - t % step < end - t ? step - t % step : end - t;
+        for (uint64_t w = first; w < first + run; ++w) {
+            const uint64_t a = vector[w], b = vector[w + step];
+            const uint64_t c = vector[w + 2 * step], d = vector[w + 3 * step];
+            vector[w + step] = a ^ b;
+            vector[w + 2 * step] = a ^ c;
+            vector[w + 3 * step] = a ^ b ^ c ^ d;
+        }
+        t += run;
+    }
+}
+
+void mobiusTransform(uint64_t *vector, uint8_t num_of_variables, unsigned num_of_threads) {
+    const uint64_t num_of_words = num_of_variables > 6 ? (uint64_t)1 << (num_of_variables - 6) : 1;
+    struct Level level = {vector, num_of_words, num_of_variables < 6 ? num_of_variables : 6};
+    parallelFor(num_of_words, num_of_threads, mobiusWords, &level);
+    const uint64_t block = num_of_words < TRANSFORM_BLOCK ? num_of_words : TRANSFORM_BLOCK;
+    parallelFor(num_of_words / block, num_of_threads, mobiusBlocks, &level);
+    for (level.step = block; level.step < num_of_words; level.step <<= 2) {
+        if (level.step << 1 < num_of_words) parallelFor(num_of_words / 4, num_of_threads, mobiusTwoLevels, &level);
+        else parallelFor(num_of_words / 2, num_of_threads, mobiusLevel, &level);
+    }
+}
+
+static void walshHadamardBlocks(void *context, uint64_t begin, uint64_t end) {
+    const struct Level *level = context;
+    int64_t *spectrum = level->vector;
+    const uint64_t block = level->size < TRANSFORM_BLOCK ? level->size : TRANSFORM_BLOCK;
+    for (uint64_t b = begin; b < end; ++b) {
+        int64_t *values = spectrum + b * block;
+        for (uint64_t step = 1; step < block; step <<= 1)
+            for (uint64_t group = 0; group < block; group += step << 1)
+                for (uint64_t i = group; i < group + step; ++i) {
+                    const int64_t first = values[i], second = values[i + step];
+                    values[i] = first + second;
+                    values[i + step] = first - second;
+                }
+    }
+}
+
+static void walshHadamardLevel(void *context, uint64_t begin, uint64_t end) {
+    const struct Level *level = context;
+    int64_t *spectrum = level->vector;
+    const uint64_t step = level->step;
+    for (uint64_t t = begin; t < end;) {
+        const uint64_t first = getPairIndex(t, step);
+        const uint64_t run = step - t % step < end - t ? step - t % step : end - t;
+        for (uint64_t i = first; i < first + run; ++i) {
+            const int64_t a = spectrum[i], b = spectrum[i + step];
+            spectrum[i] = a + b;
+            spectrum[i + step] = a - b;
+        }
+        t += run;
+    }
+}
+
+// Уровни step и 2 * step за один проход: четвёрки i, i + step, i + 2 * step, i + 3 * step.
+static void walshHadamardTwoLevels(void *context, uint64_t begin, uint64_t end) {
+    const struct Level *level = context;
+    int64_t *spectrum = level->vector;
+    const uint64_t step = level->step;
+    for (uint64_t t = begin; t < end;) {
+        const uint64_t first = ((t / step) * step << 2) + t % step;
+        const uint64_t run = step - t % step < end - t ? step - t % step : end - t;
+        for (uint64_t i = first; i < first + run; ++i) {
+            const int64_t a = spectrum[i], b = spectrum[i + step];
+            const int64_t c = spectrum[i + 2 * step], d = spectrum[i + 3 * step];
+            spectrum[i] = a + b + c + d;
+            spectrum[i + step] = a - b + c - d;
+            spectrum[i + 2 * step] = a + b - c - d;
+            spectrum[i + 3 * step] = a - b - c + d;
+        }
+        t += run;
+    }
+}
+
+void walshHadamardTransform(int64_t *spectrum, uint8_t num_of_variables, unsigned num_of_threads) {
+    const uint64_t size = (uint64_t)1 << num_of_variables;
+    struct Level level = {spectrum, size, 0};
+    const uint64_t block = size < TRANSFORM_BLOCK ? size : TRANSFORM_BLOCK;
+    parallelFor(size / block, num_of_threads, walshHadamardBlocks, &level);
+    for (level.step = block; level.step < size; level.step <<= 2) {
+        if (level.step << 1 < size) parallelFor(size / 4, num_of_threads, walshHadamardTwoLevels, &level);
+        else parallelFor(size / 2, num_of_threads, walshHadamardLevel, &level);
+    }
+}
+
+struct Signs {
+    const uint64_t *table;
+    int64_t *spectrum;
+};
+
+static void fillSigns(void *context, uint64_t begin, uint64_t end) {
+    const struct Signs *signs = context;
+    for (uint64_t i = begin; i < end; ++i)
+        signs->spectrum[i] = 1 - 2 * (int64_t)((signs->table[i >> 6] >> (i & 63)) & 1);
+}
+
+void initWalshSpectrum(int64_t *spectrum, const uint64_t *table, uint8_t num_of_variables, unsigned num_of_threads) {
+    struct Signs signs = {table, spectrum};
+    parallelFor((uint64_t)1 << num_of_variables, num_of_threads, fillSigns, &signs);
+    walshHadamardTransform(spectrum, num_of_variables, num_of_threads);
+}
+
+struct SpectrumScan {
+    const int64_t *spectrum;
+    uint8_t num_of_variables;
+    pthread_mutex_t mutex;
+    uint64_t max_absolute;
+    uint8_t min_weight;
+};
+
+static void scanSpectrum(void *context, uint64_t begin, uint64_t end) {
+    struct SpectrumScan *scan = context;
+    uint64_t max_absolute = 0;
+    uint8_t min_weight = scan->num_of_variables + 1;
+    for (uint64_t a = begin; a < end; ++a) {
+        const int64_t value = scan->spectrum[a];
+        const uint64_t absolute = value < 0 ? (uint64_t)-value : (uint64_t)value;
+        if (absolute > max_absolute) max_absolute = absolute;
+        if (a && value && __builtin_popcountll(a) < min_weight) min_weight = (uint8_t)__builtin_popcountll(a);
+    }
+    pthread_mutex_lock(&scan->mutex);
+    if (max_absolute > scan->max_absolute) scan->max_absolute = max_absolute;
+    if (min_weight < scan->min_weight) scan->min_weight = min_weight;
+    pthread_mutex_unlock(&scan->mutex);
+}
+
+void analyzeWalshSpectrum(
+    const int64_t *spectrum, uint8_t num_of_variables, unsigned num_of_threads,
+    uint64_t *max_absolute, uint8_t *correlation_immunity
+) {
+    struct SpectrumScan scan = {spectrum, num_of_variables, PTHREAD_MUTEX_INITIALIZER, 0, num_of_variables + 1};
+    parallelFor((uint64_t)1 << num_of_variables, num_of_threads, scanSpectrum, &scan);
+    pthread_mutex_destroy(&scan.mutex);
+    *max_absolute = scan.max_absolute;
+    *correlation_immunity = scan.min_weight - 1;
+}
+
+struct DegreeScan {
+    const uint64_t *coefficients;
+    uint8_t num_of_variables;
+    pthread_mutex_t mutex;
+    int degree;
+};
+
+static void scanDegree(void *context, uint64_t begin, uint64_t end) {
+    // Маски позиций j в слове с popcount(j) = k.
+    static const uint64_t weight_masks[7] = {
+        0x0000000000000001, 0x0000000100010116, 0x0001011601161668, 0x0116166816686880,
+        0x1668688068808000, 0x6880800080000000, 0x8000000000000000
+    };
+    struct DegreeScan *scan = context;
+    const uint64_t used = scan->num_of_variables < 6 ? ((uint64_t)1 << (1u << scan->num_of_variables)) - 1 : ~(uint64_t)0;
+    int degree = -1;
+    for (uint64_t w = begin; w < end; ++w) {
+        const uint64_t word = scan->coefficients[w] & used;
+        if (!word) continue;
+        int k = 6;
+        while (!(word & weight_masks[k])) --k;
+        if (__builtin_popcountll(w) + k > degree) degree = __builtin_popcountll(w) + k;
+    }
+    pthread_mutex_lock(&scan->mutex);
+    if (degree > scan->degree) scan->degree = degree;
+    pthread_mutex_unlock(&scan->mutex);
+}
+
+int getAlgebraicDegree(const uint64_t *coefficients, uint8_t num_of_variables, unsigned num_of_threads) {
+    const uint64_t num_of_words = num_of_variables > 6 ? (uint64_t)1 << (num_of_variables - 6) : 1;
+    struct DegreeScan scan = {coefficients, num_of_variables, PTHREAD_MUTEX_INITIALIZER, -1};
+    parallelFor(num_of_words, num_of_threads, scanDegree, &scan);
+    pthread_mutex_destroy(&scan.mutex);
+    return scan.degree;
+}
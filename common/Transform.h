@@ -0,0 +1,31 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include <stdint.h>
+
+// Все преобразования выполняются на месте и делят работу между num_of_threads
+// потоками (1 - без потоков). Уровни с малым шагом проходятся блоками, помещающимися
+// в кэш, так что таблица 2^33 точек читается из памяти O(num_of_variables / 2) раз.
+
+// Преобразование Мёбиуса на месте: таблица истинности функции от num_of_variables
+// переменных (бит i вектора - значение в точке i, по 64 бита в слове, младший
+// первый) переходит в вектор коэффициентов её многочлена Жегалкина: бит m -
+// коэффициент при мономе, составленном из переменных, номера которых - единицы m.
+// Преобразование обратно самому себе. При num_of_variables < 6 старшие биты слова не используются.
+void mobiusTransform(uint64_t *vector, uint8_t num_of_variables, unsigned num_of_threads);
+// Преобразование Уолша-Адамара вектора из 2^num_of_variables целых.
+void walshHadamardTransform(int64_t *spectrum, uint8_t num_of_variables, unsigned num_of_threads);
+// Спектр Уолша W(a) = sum (-1)^(f(x) + a.x) функции с таблицей истинности table
+// (формат как у mobiusTransform). spectrum - 2^num_of_variables чисел, то есть
+// 2^(num_of_variables + 3) байт.
+void initWalshSpectrum(int64_t *spectrum, const uint64_t *table, uint8_t num_of_variables, unsigned num_of_threads);
+// max |W(a)| и порядок корреляционной иммунности: наибольшее m, при котором W(a) = 0
+// для всех a с 1 <= wt(a) <= m.
+void analyzeWalshSpectrum(
+    const int64_t *spectrum, uint8_t num_of_variables, unsigned num_of_threads,
+    uint64_t *max_absolute, uint8_t *correlation_immunity
+);
+// Степень многочлена по вектору коэффициентов из mobiusTransform, -1 у нулевого.
+int getAlgebraicDegree(const uint64_t *coefficients, uint8_t num_of_variables, unsigned num_of_threads);
+
+#endif
@@ -1,5 +1,8 @@
 #include "LinearFSM.hpp"
+#include "../common/GFLinearComplexity.hpp"
 #include <iostream>
+#include <memory>
+#include <vector>
 
 bool getInput(uint16_t &input) {
     if (!(std::cin >> input)) {
@@ -35,8 +38,15 @@ bool initState(LinearFSM &lin) {
     return false;
 }
 
-void cycle(LinearFSM &lin) {
+// Если linear_complexity, после каждого такта выводится линейная сложность
+// последовательности каждой компоненты выхода, а если connection_polynomial - ещё
+// и её многочлен связи.
+void cycle(LinearFSM &lin, bool linear_complexity, bool connection_polynomial) {
     GFMatrix input(lin.getGF(), 1, lin.inputLength());
+    std::vector<std::unique_ptr<GFLinearComplexity>> complexities;
+    if (linear_complexity)
+        for (slong i = 0; i < lin.outputLength(); ++i)
+            complexities.push_back(std::make_unique<GFLinearComplexity>(lin.getGF()));
     while (true) {
         std::cout << "Введите вход из (" <<
             *lin.getGF().Prime() << "^" << lin.getGF().Degree() << ")^" << lin.inputLength() << ": ";
@@ -45,17 +55,33 @@ void cycle(LinearFSM &lin) {
             if (getInput(input_element)) return;
             input(0, i, input_element);
         }
-        std::cout << "Выход: " << lin(input) << ". Новое состояние: " << lin.getState() << "." << std::endl;
+        GFMatrix output = lin(input);
+        std::cout << "Выход: " << output << ". Новое состояние: " << lin.getState() << "." << std::endl;
+        if (!linear_complexity) continue;
+        std::cout << "Линейная сложность компонент выхода:";
+        for (slong i = 0; i < lin.outputLength(); ++i)
+            std::cout << " " << complexities[i]->push(output(0, i));
+        std::cout << std::endl;
+        if (!connection_polynomial) continue;
+        std::cout << "Многочлены связи компонент выхода:";
+        for (slong i = 0; i < lin.outputLength(); ++i)
+            std::cout << " " << complexities[i]->connectionPolynomial() << ";";
+        std::cout << std::endl;
     }
 }
 
 int main(int argc, char **argv) {
-    if (argc < 2) {
-        std::cout << "Использование: " << argv[0] << " <файл конфигурации линейного автомата>" << std::endl;
+    const std::string option = argc > 2 ? argv[2] : "";
+    if (argc < 2 || argc > 3 || (argc > 2 && option != "--linear-complexity" && option != "--connection-polynomial")) {
+        std::cout << "Использование: " << argv[0] << " <файл конфигурации линейного автомата>\n"
+            "       [--linear-complexity | --connection-polynomial]\n"
+            "--linear-complexity после каждого такта выводит линейную сложность (алгоритм\n"
+            "Берлекэмпа-Мэсси) последовательности каждой компоненты выхода,\n"
+            "--connection-polynomial - ещё и её многочлен связи." << std::endl;
         return -1;
     }
     LinearFSM lin = initLinearFSM(argv[1]);
     printWelcomeMessage();
-    if (!initState(lin)) cycle(lin);
+    if (!initState(lin)) cycle(lin, argc > 2, option == "--connection-polynomial");
     return 0;
 }
\ No newline at end of file
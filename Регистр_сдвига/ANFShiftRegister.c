@@ -0,0 +1,265 @@
+#include "ANFShiftRegister.h"
+#include "LinearShiftRegister.h"
+#include "SmallShiftRegister.h"
+#include "Alloc.h"
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+static char variable_names[ANF_SHIFT_REGISTER_MAX_LENGTH][4];
+static const char *variables[ANF_SHIFT_REGISTER_MAX_LENGTH];
+
+static const char **getVariables(void) {
+    if (!variables[0])
+        for (uint8_t i = 0; i < ANF_SHIFT_REGISTER_MAX_LENGTH; ++i) {
+            snprintf(variable_names[i], sizeof(variable_names[i]), "s%" PRIu8, i);
+            variables[i] = variable_names[i];
+        }
+    return variables;
+}
+
+uint8_t isANFShiftRegisterFile(char *settings_file) {
+    char magic[sizeof(ANF_SHIFT_REGISTER_FILE_MAGIC) - 1];
+    FILE *fp = fopen(settings_file, "r");
+    if (!fp) return 0;
+    uint8_t result =
+        fread(magic, 1, sizeof(magic), fp) == sizeof(magic) &&
+        !memcmp(magic, ANF_SHIFT_REGISTER_FILE_MAGIC, sizeof(magic));
+    fclose(fp);
+    return result;
+}
+
+static void initEmptyANFShiftRegister(struct ANFShiftRegister *reg) {
+    for (uint8_t i = 0; i < 2; ++i) {
+        initANF(&reg->phi[i]);
+        initANF(&reg->psi[i]);
+    }
+    reg->state = 0;
+}
+
+// Разбирает строку "<имя> = <многочлен>" в пару многочленов функции.
+static int readFunction(struct ANFShiftRegister *reg, char *line, ANF *function, uint8_t *found) {
+    if (*found) {
+        printf("Функция задана дважды: %s", line);
+        return -1;
+    }
+    char *equals = strchr(line, '=');
+    if (!equals) {
+        printf("Ожидается знак = в строке: %s", line);
+        return -2;
+    }
+    if (parseANF(&function[0], &function[1], equals + 1, getVariables(), reg->length, "x")) return -3;
+    *found = 1;
+    return 0;
+}
+
+int initANFShiftRegisterFromFile(struct ANFShiftRegister *reg, char *settings_file) {
+    initEmptyANFShiftRegister(reg);
+    FILE *fp = fopen(settings_file, "r");
+    if (!fp) {
+        printf("Не открывается файл %s\n", settings_file);
+        return -1;
+    }
+    int rc = 0;
+    unsigned length;
+    if (fscanf(fp, ANF_SHIFT_REGISTER_FILE_MAGIC " %u", &length) != 1) {
+        printf("Не считывается размер регистра \n");
+        fclose(fp);
+        return -2;
+    }
+    if (length > ANF_SHIFT_REGISTER_MAX_LENGTH) {
+        printf("Длина регистра не должна превышать %d\n", ANF_SHIFT_REGISTER_MAX_LENGTH);
+        fclose(fp);
+        return -3;
+    }
+    reg->length = (uint8_t)length;
+    reg->mask = reg->length == 64 ? ~(uint64_t)0 : ((uint64_t)1 << reg->length) - 1;
+    char *line = NULL;
+    size_t capacity = 0;
+    uint8_t found_phi = 0, found_psi = 0;
+    while (!rc && getline(&line, &capacity, fp) != -1) {
+        char *p = line;
+        while (*p == ' ' || *p == '\t') ++p;
+        if (!strncmp(p, "phi", 3)) {
+            if (readFunction(reg, p + 3, reg->phi, &found_phi)) rc = -5;
+        } else if (!strncmp(p, "psi", 3)) {
+            if (readFunction(reg, p + 3, reg->psi, &found_psi)) rc = -6;
+        } else if (strspn(p, " \t\r\n") != strlen(p)) {
+            printf("Неизвестная строка: %s", p);
+            rc = -7;
+        }
+    }
+    if (!rc && (!found_phi || !found_psi)) {
+        printf("В файле должны быть заданы phi и psi\n");
+        rc = -7;
+    }
+    free(line);
+    fclose(fp);
+    if (rc) freeANFShiftRegister(reg);
+    return rc;
+}
+
+int saveANFShiftRegisterToFile(struct ANFShiftRegister *reg, char *settings_file) {
+    FILE *fp = fopen(settings_file, "w");
+    if (!fp) {
+        printf("Не открывается файл %s\n", settings_file);
+        return -1;
+    }
+    fprintf(fp, ANF_SHIFT_REGISTER_FILE_MAGIC " %" PRIu8 "\nphi = ", reg->length);
+    printANF(&reg->phi[0], &reg->phi[1], getVariables(), reg->length, "x", fp);
+    fprintf(fp, "\npsi = ");
+    printANF(&reg->psi[0], &reg->psi[1], getVariables(), reg->length, "x", fp);
+    fprintf(fp, "\n");
+    return fclose(fp) ? -2 : 0;
+}
+
+int readANFState(struct ANFShiftRegister *reg) {
+    printf("Введите начальное состояние: ");
+    reg->state = 0;
+    for (uint8_t i = 0; i < reg->length; ++i) {
+        switch (fgetc(stdin)) {
+            case '1':
+                reg->state = (reg->state << 1) | 1;
+                break;
+            case '0':
+                reg->state = (reg->state << 1);
+                break;
+            case ' ':
+            case '\t':
+            case '\n':
+                --i;
+                break;
+            default:
+                return -1;
+        }
+    }
+    return 0;
+}
+
+uint8_t useANFShiftRegister(struct ANFShiftRegister *reg, uint8_t x) {
+    uint8_t phi = evaluateANF(&reg->phi[0], reg->state) ^ (x & evaluateANF(&reg->phi[1], reg->state));
+    uint8_t y = evaluateANF(&reg->psi[0], reg->state) ^ (phi & evaluateANF(&reg->psi[1], reg->state));
+    reg->state = ((reg->state << 1) | phi) & reg->mask;
+    return y;
+}
+
+void useANFShiftRegisterOnWords(
+    struct ANFShiftRegister *reg,
+    const uint64_t *input,
+    uint64_t *output,
+    uint64_t num_of_bits
+) {
+    for (uint64_t word = 0; word < (num_of_bits + 63) / 64; ++word) {
+        const uint64_t x = input[word];
+        const unsigned bits = num_of_bits - word * 64 < 64 ? (unsigned)(num_of_bits - word * 64) : 64;
+        uint64_t y = 0;
+        for (unsigned i = 0; i < bits; ++i)
+            y |= (uint64_t)useANFShiftRegister(reg, (x >> i) & 1) << i;
+        output[word] = y;
+    }
+}
+
+void freeANFShiftRegister(struct ANFShiftRegister *reg) {
+    for (uint8_t i = 0; i < 2; ++i) {
+        freeANF(&reg->phi[i]);
+        freeANF(&reg->psi[i]);
+    }
+    reg->length = 0;
+}
+
+int anfToShiftRegister(struct ShiftRegister *table, struct ANFShiftRegister *reg) {
+    // Младшие 6 битов номера состояния перебираются внутри слова.
+    static const uint64_t low_planes[6] = {
+        0xAAAAAAAAAAAAAAAA, 0xCCCCCCCCCCCCCCCC, 0xF0F0F0F0F0F0F0F0,
+        0xFF00FF00FF00FF00, 0xFFFF0000FFFF0000, 0xFFFFFFFF00000000
+    };
+    if (reg->length > 32) {
+        printf("Таблицы строятся только для регистров длины не более 32\n");
+        return -1;
+    }
+    table->length = reg->length;
+    table->mask = (uint32_t)reg->mask;
+    memset(&table->kernel, 0, sizeof(table->kernel));
+    if (initBitArray(&table->transitions, (uint64_t)1 << (reg->length + 2))) return -2;
+    uint64_t planes[32];
+    const uint64_t num_of_states = (uint64_t)1 << reg->length;
+    for (uint64_t base = 0; base < num_of_states; base += 64) {
+        for (uint8_t i = 0; i < reg->length; ++i)
+            planes[i] = i < 6 ? low_planes[i] : ((base >> i) & 1 ? ~(uint64_t)0 : 0);
+        const uint64_t phi0 = evaluateANFBitsliced(&reg->phi[0], planes);
+        const uint64_t phi1 = phi0 ^ evaluateANFBitsliced(&reg->phi[1], planes);
+        const uint64_t psi0 = evaluateANFBitsliced(&reg->psi[0], planes);
+        const uint64_t psi1 = psi0 ^ evaluateANFBitsliced(&reg->psi[1], planes);
+        for (uint64_t lane = 0; lane < 64 && base + lane < num_of_states; ++lane) {
+            const uint8_t nibble = (uint8_t)(
+                ((phi0 >> lane) & 1) | ((phi1 >> lane) & 1) << 1 |
+                ((psi0 >> lane) & 1) << 2 | ((psi1 >> lane) & 1) << 3
+            );
+            table->transitions.bucket[(base + lane) >> 1] |= nibble << (((base + lane) & 1) << 2);
+        }
+    }
+    detectLinearFeedback(table);
+    initSmallEngine(table);
+    initSparseTransitions(table);
+    return 0;
+}
+
+int shiftRegisterToANF(struct ANFShiftRegister *reg, const struct ShiftRegister *table, uint64_t max_monomials) {
+    initEmptyANFShiftRegister(reg);
+    reg->length = table->length;
+    reg->mask = table->mask;
+    const uint64_t num_of_states = (uint64_t)1 << table->length;
+    const size_t size = (num_of_states + 63) / 64 * sizeof(uint64_t);
+    uint8_t kind;
+    uint64_t *vector = allocLarge(size, &kind);
+    if (!vector) return -1;
+    int rc = 0;
+    // Бит shift полубайта и, для коэффициентов при x, бит shift + 1.
+    ANF *functions[4] = {&reg->phi[0], &reg->phi[1], &reg->psi[0], &reg->psi[1]};
+    for (uint8_t f = 0; f < 4 && !rc; ++f) {
+        const uint8_t shift = f & 2;
+        memset(vector, 0, size);
+        for (uint64_t state = 0; state < num_of_states; ++state) {
+            const uint8_t nibble = getShiftRegisterTransitions(table, state) >> shift;
+            vector[state >> 6] |= (uint64_t)((nibble ^ (f & 1 ? nibble >> 1 : 0)) & 1) << (state & 63);
+        }
+        rc = initANFFromTruthTable(functions[f], vector, table->length, max_monomials);
+    }
+    freeLarge(vector, size, kind);
+    if (rc) freeANFShiftRegister(reg);
+    return rc;
+}
+
+void initBitslicedANFShiftRegister(struct BitslicedANFShiftRegister *sliced, const struct ANFShiftRegister *reg) {
+    sliced->reg = reg;
+    memset(sliced->history, 0, sizeof(sliced->history));
+    sliced->top = sliced->history + ANF_BITSLICED_HISTORY - ANF_SHIFT_REGISTER_MAX_LENGTH;
+}
+
+void setBitslicedANFState(struct BitslicedANFShiftRegister *sliced, uint8_t lane, uint64_t state) {
+    for (uint8_t j = 0; j < sliced->reg->length; ++j)
+        sliced->top[j] = (sliced->top[j] & ~((uint64_t)1 << lane)) | ((state >> j) & 1) << lane;
+}
+
+uint64_t getBitslicedANFState(struct BitslicedANFShiftRegister *sliced, uint8_t lane) {
+    uint64_t state = 0;
+    for (uint8_t j = 0; j < sliced->reg->length; ++j)
+        state |= ((sliced->top[j] >> lane) & 1) << j;
+    return state;
+}
+
+uint64_t useBitslicedANFShiftRegister(struct BitslicedANFShiftRegister *sliced, uint64_t x) {
+    const struct ANFShiftRegister *reg = sliced->reg;
+    const uint64_t phi =
+        evaluateANFBitsliced(&reg->phi[0], sliced->top) ^
+        (x & evaluateANFBitsliced(&reg->phi[1], sliced->top));
+    const uint64_t y =
+        evaluateANFBitsliced(&reg->psi[0], sliced->top) ^
+        (phi & evaluateANFBitsliced(&reg->psi[1], sliced->top));
+    if (sliced->top == sliced->history) {
+        sliced->top = sliced->history + ANF_BITSLICED_HISTORY - ANF_SHIFT_REGISTER_MAX_LENGTH;
+        memmove(sliced->top, sliced->history, ANF_SHIFT_REGISTER_MAX_LENGTH * sizeof(uint64_t));
+    }
+    *--sliced->top = phi;
+    return y;
+}
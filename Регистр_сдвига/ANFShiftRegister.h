@@ -0,0 +1,63 @@
+#ifndef ANF_SHIFT_REGISTER_H
+#define ANF_SHIFT_REGISTER_H
+
+#include "ANF.h"
+#include "ShiftRegister.h"
+
+#define ANF_SHIFT_REGISTER_MAX_LENGTH 64
+#define ANF_SHIFT_REGISTER_FILE_MAGIC "ANF"
+
+// Регистр, функции которого заданы многочленами Жегалкина от битов состояния
+// s0 (младший, последний вдвинутый) .. s{length-1}:
+// phi(s, x) = phi[0](s) + x*phi[1](s), psi(s, x) = psi[0](s) + x*psi[1](s),
+// где x у psi, как и в таблицах, - вычисленный бит phi. Память пропорциональна
+// числу мономов, поэтому длина ограничена только разрядностью состояния.
+// Формат файла:
+//   ANF <длина>
+//   phi = s0*s3 + x + 1
+//   psi = s1 + x*s2
+struct ANFShiftRegister {
+    uint8_t length;
+    ANF phi[2];
+    ANF psi[2];
+    uint64_t state;
+    uint64_t mask;
+};
+
+// 64 независимых экземпляра одного регистра. Бит j состояния экземпляра lane
+// хранится в бите lane планки top[j]; сдвиг состояния - это сдвиг указателя top
+// по буферу history, так что такт не копирует планки.
+#define ANF_BITSLICED_HISTORY 1024
+struct BitslicedANFShiftRegister {
+    const struct ANFShiftRegister *reg;
+    uint64_t *top;
+    uint64_t history[ANF_BITSLICED_HISTORY];
+};
+
+uint8_t isANFShiftRegisterFile(char *settings_file);
+int initANFShiftRegisterFromFile(struct ANFShiftRegister *reg, char *settings_file);
+int saveANFShiftRegisterToFile(struct ANFShiftRegister *reg, char *settings_file);
+int readANFState(struct ANFShiftRegister *reg);
+uint8_t useANFShiftRegister(struct ANFShiftRegister *reg, uint8_t x);
+// Упаковка входа и выхода как в useShiftRegisterOnWords.
+void useANFShiftRegisterOnWords(
+    struct ANFShiftRegister *reg,
+    const uint64_t *input,
+    uint64_t *output,
+    uint64_t num_of_bits
+);
+void freeANFShiftRegister(struct ANFShiftRegister *reg);
+// Строит таблицы phi и psi (только для length <= 32), после чего для регистра
+// доступны все средства анализа ShiftRegister.
+int anfToShiftRegister(struct ShiftRegister *table, struct ANFShiftRegister *reg);
+// Обратное преобразование (преобразованием Мёбиуса). Если в одном из четырёх
+// многочленов больше max_monomials мономов, возвращает -2.
+int shiftRegisterToANF(struct ANFShiftRegister *reg, const struct ShiftRegister *table, uint64_t max_monomials);
+
+void initBitslicedANFShiftRegister(struct BitslicedANFShiftRegister *sliced, const struct ANFShiftRegister *reg);
+void setBitslicedANFState(struct BitslicedANFShiftRegister *sliced, uint8_t lane, uint64_t state);
+uint64_t getBitslicedANFState(struct BitslicedANFShiftRegister *sliced, uint8_t lane);
+// Один такт всех экземпляров. Бит lane в x - вход экземпляра lane, в результате - его выход.
+uint64_t useBitslicedANFShiftRegister(struct BitslicedANFShiftRegister *sliced, uint64_t x);
+
+#endif
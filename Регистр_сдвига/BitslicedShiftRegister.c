@@ -0,0 +1,85 @@
+#include "BitslicedShiftRegister.h"
+#include <stdlib.h>
+
+int initBitslicedShiftRegister(struct BitslicedShiftRegister *sliced, const struct ShiftRegister *reg) {
+    if (reg->length > BITSLICED_MAX_LENGTH) return -1;
+    size_t size = ((size_t)sizeof(BitSlice) << reg->length);
+    if (!(sliced->scratch = aligned_alloc(sizeof(BitSlice), size))) return -2;
+    sliced->length = reg->length;
+    sliced->reg = reg;
+    memset(sliced->planes, 0, sizeof(sliced->planes));
+    return 0;
+}
+
+void freeBitslicedShiftRegister(struct BitslicedShiftRegister *sliced) {
+    free(sliced->scratch);
+    sliced->scratch = NULL;
+    sliced->length = 0;
+}
+
+void setBitslicedState(struct BitslicedShiftRegister *sliced, uint64_t lane, uint32_t state) {
+    const uint64_t bit = (uint64_t)1 << (lane % 64);
+    for (uint8_t j = 0; j < sliced->length; ++j)
+        if ((state >> j) & 1) sliced->planes[j][lane / 64] |= bit;
+        else sliced->planes[j][lane / 64] &= ~bit;
+}
+
+uint32_t getBitslicedState(struct BitslicedShiftRegister *sliced, uint64_t lane) {
+    uint32_t state = 0;
+    for (uint8_t j = 0; j < sliced->length; ++j)
+        state |= (uint32_t)((sliced->planes[j][lane / 64] >> (lane % 64)) & 1) << j;
+    return state;
+}
+
+void setConsecutiveBitslicedStates(struct BitslicedShiftRegister *sliced, uint32_t first_state) {
+    for (uint64_t lane = 0; lane < BITSLICE_LANES; ++lane)
+        setBitslicedState(sliced, lane, first_state + (uint32_t)lane);
+}
+
+// Значение phi (shift = 0) или psi (shift = 2) на индексе (state << 1) | low во всех
+// экземплярах: дерево мультиплексоров по битам индекса, листья которого - биты таблицы.
+static BitSlice evaluateTable(
+    const struct ShiftRegister *reg,
+    uint8_t shift,
+    const BitSlice *planes,
+    BitSlice low,
+    BitSlice *scratch
+) {
+    const uint8_t length = reg->length;
+    const uint64_t leaves = (uint64_t)1 << length;
+    for (uint64_t k = 0; k < leaves; ++k) {
+        const uint8_t pair = (getShiftRegisterTransitions(reg, k) >> shift) & 3;
+        const uint64_t constant = -(uint64_t)(pair & 1);
+        const uint64_t differs = -(uint64_t)((pair ^ (pair >> 1)) & 1);
+        scratch[k] = (low & differs) ^ constant;
+    }
+    for (uint8_t j = 0; j < length; ++j) {
+        const uint64_t half = leaves >> (j + 1);
+        for (uint64_t k = 0; k < half; ++k)
+            scratch[k] = scratch[2 * k] ^ ((scratch[2 * k] ^ scratch[2 * k + 1]) & planes[j]);
+    }
+    return scratch[0];
+}
+
+BitSlice useBitslicedShiftRegister(struct BitslicedShiftRegister *sliced, BitSlice x) {
+    BitSlice phi = evaluateTable(sliced->reg, 0, sliced->planes, x, sliced->scratch);
+    BitSlice y = evaluateTable(sliced->reg, 2, sliced->planes, phi, sliced->scratch);
+    for (uint8_t j = sliced->length; j > 1; --j)
+        sliced->planes[j - 1] = sliced->planes[j - 2];
+    if (sliced->length) sliced->planes[0] = phi;
+    return y;
+}
+
+void useBitslicedShiftRegisterOnWords(
+    struct BitslicedShiftRegister *sliced,
+    const uint64_t *input,
+    BitSlice *output,
+    uint64_t num_of_bits
+) {
+    const BitSlice zero = {0};
+    for (uint64_t t = 0; t < num_of_bits; ++t)
+        output[t] = useBitslicedShiftRegister(
+            sliced,
+            zero - ((input[t / 64] >> (t % 64)) & 1)
+        );
+}
@@ -0,0 +1,86 @@
+#include "CompiledShiftRegister.h"
+#include <stdlib.h>
+#include <unistd.h>
+
+uint64_t getCacheBudget() {
+    long size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    return size > 0 ? (uint64_t)size : (uint64_t)256 << 10;
+}
+
+static uint32_t compileEntry(const struct ShiftRegister *reg, uint32_t state, uint32_t x, uint8_t step) {
+    uint32_t y = 0;
+    for (uint8_t i = 0; i < step; ++i) {
+        uint8_t transitions = getShiftRegisterTransitions(reg, state);
+        uint8_t bit = (x >> i) & 1;
+        uint8_t phi = (transitions >> bit) & 1;
+        y |= (uint32_t)getShiftRegisterOutput(transitions, bit) << i;
+        state = (uint32_t)((((uint64_t)state << 1) | phi) & reg->mask);
+    }
+    return state | (y << reg->length);
+}
+
+int compileShiftRegister(
+    struct CompiledShiftRegister *compiled,
+    const struct ShiftRegister *reg,
+    uint64_t cache_budget
+) {
+    uint8_t step = COMPILED_MAX_STEP;
+    while (
+        step && (
+            reg->length + step > 32 ||
+            ((uint64_t)sizeof(uint32_t) << (reg->length + step)) > cache_budget
+        )
+    ) step >>= 1;
+    if (!step) return -1;
+    uint64_t size = (uint64_t)1 << (reg->length + step);
+    if (!(compiled->table = malloc(size * sizeof(uint32_t)))) return -2;
+    for (uint64_t i = 0; i < size; ++i)
+        compiled->table[i] = compileEntry(
+            reg,
+            (uint32_t)(i >> step),
+            (uint32_t)(i & (((uint32_t)1 << step) - 1)),
+            step
+        );
+    compiled->length = reg->length;
+    compiled->step = step;
+    compiled->mask = reg->mask;
+    compiled->source = reg;
+    return 0;
+}
+
+void freeCompiledShiftRegister(struct CompiledShiftRegister *compiled) {
+    free(compiled->table);
+    compiled->table = NULL;
+    compiled->length = 0;
+    compiled->step = 0;
+}
+
+void useCompiledShiftRegisterOnWords(
+    const struct CompiledShiftRegister *compiled,
+    struct ShiftRegisterCursor *cursor,
+    const uint64_t *input,
+    uint64_t *output,
+    uint64_t num_of_bits
+) {
+    const uint32_t *table = compiled->table;
+    const uint8_t step = compiled->step;
+    const uint8_t length = compiled->length;
+    const uint32_t mask = compiled->mask;
+    const uint64_t x_mask = ((uint64_t)1 << step) - 1;
+    uint64_t state = cursor->state;
+    uint64_t full_words = num_of_bits / 64;
+    for (uint64_t word = 0; word < full_words; ++word) {
+        const uint64_t x = input[word];
+        uint64_t y = 0;
+        for (unsigned i = 0; i < 64; i += step) {
+            const uint32_t entry = table[(state << step) | ((x >> i) & x_mask)];
+            state = entry & mask;
+            y |= (uint64_t)(entry >> length) << i;
+        }
+        output[word] = y;
+    }
+    cursor->state = (uint32_t)state;
+    // Хвост короче слова обрабатывается исходным регистром побитно.
+    if (num_of_bits % 64)
+        useShiftRegisterOnWords(cursor, input + full_words, output + full_words, num_of_bits % 64);
+}
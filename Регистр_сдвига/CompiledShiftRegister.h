@@ -0,0 +1,39 @@
+#ifndef COMPILED_SHIFT_REGISTER_H
+#define COMPILED_SHIFT_REGISTER_H
+
+#include "ShiftRegister.h"
+
+// Элемент таблицы хранит следующее состояние в младших length битах
+// и step выходных битов над ними, поэтому length + step <= 32.
+#define COMPILED_MAX_STEP 8
+
+// Регистр, переходы которого заранее посчитаны на step тактов вперёд:
+// table[(state << step) | x] - результат подачи step битов x (младший первый).
+struct CompiledShiftRegister {
+    uint8_t length;
+    uint8_t step;
+    uint32_t mask;
+    uint32_t *table;
+    const struct ShiftRegister *source;
+};
+
+// Размер кэша, под который подбирается таблица (L2, а если он неизвестен - 256 КиБ).
+uint64_t getCacheBudget();
+// Выбирает наибольший step из 8, 4, 2, 1, при котором таблица помещается в cache_budget байт.
+int compileShiftRegister(
+    struct CompiledShiftRegister *compiled,
+    const struct ShiftRegister *reg,
+    uint64_t cache_budget
+);
+void freeCompiledShiftRegister(struct CompiledShiftRegister *compiled);
+// Аналог useShiftRegisterOnWords, обрабатывающий step битов за одно обращение к таблице.
+// Курсор должен указывать на исходный регистр; таблица только читается.
+void useCompiledShiftRegisterOnWords(
+    const struct CompiledShiftRegister *compiled,
+    struct ShiftRegisterCursor *cursor,
+    const uint64_t *input,
+    uint64_t *output,
+    uint64_t num_of_bits
+);
+
+#endif
@@ -0,0 +1,385 @@
+#include "CycleStructure.h"
+#include "Alloc.h"
+#include "StateGraph.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+// Код состояния (2 бита). При подсчёте - число входящих рёбер (0..2),
+// CODE_TREE - состояние снято как лист дерева. После обрыва деревьев
+// у состояний циклов остаётся ровно одно ребро, при перечислении циклов
+// их код меняется на CODE_VISITED_CYCLE.
+#define CODE_VISITED_CYCLE 2
+#define CODE_TREE 3
+#define CHUNK_STATES ((uint64_t)1 << 16)
+#define QUEUE_SIZE 1024
+
+struct TreeNode {
+    uint32_t state;
+    uint32_t depth;
+};
+
+struct Accumulator {
+    // Открытая адресация по длине цикла, length = 0 - пустая ячейка.
+    struct CycleClass *classes;
+    uint64_t capacity;
+    uint64_t size;
+    struct Cycle *cycles;
+    uint64_t num_of_cycles;
+    uint64_t cycles_capacity;
+    struct TreeNode *stack;
+    uint64_t stack_capacity;
+    uint64_t leaves;
+    int error;
+};
+
+struct Analysis {
+    const struct ShiftRegister *reg;
+    uint8_t x;
+    uint8_t list_cycles;
+    uint64_t num_of_states;
+    uint8_t *codes;
+    uint8_t codes_kind;
+    uint64_t next_chunk;
+    pthread_mutex_t mutex;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    struct Cycle queue[QUEUE_SIZE];
+    uint64_t head;
+    uint64_t tail;
+    uint8_t done;
+};
+
+struct Worker {
+    struct Analysis *analysis;
+    struct Accumulator accumulator;
+    pthread_t thread;
+};
+
+static inline uint64_t getNextState(const struct Analysis *analysis, uint64_t state) {
+    return ((state << 1) | getPhiValue(analysis->reg, (state << 1) | analysis->x)) & analysis->reg->mask;
+}
+
+static inline uint8_t getPredecessors(const struct Analysis *analysis, uint64_t state, uint32_t *predecessors) {
+    return getShiftRegisterPredecessorsOnInput(analysis->reg, (uint32_t)state, analysis->x, predecessors);
+}
+
+static inline uint8_t getCode(uint8_t *codes, uint64_t state) {
+    return (__atomic_load_n(&codes[state >> 2], __ATOMIC_RELAXED) >> ((state & 3) << 1)) & 3;
+}
+
+// Меняет код expected на desired; 0, если код уже другой.
+static uint8_t replaceCode(uint8_t *codes, uint64_t state, uint8_t expected, uint8_t desired) {
+    const unsigned shift = (state & 3) << 1;
+    uint8_t old = __atomic_load_n(&codes[state >> 2], __ATOMIC_RELAXED);
+    while (((old >> shift) & 3) == expected) {
+        const uint8_t updated = (uint8_t)((old & ~(3u << shift)) | ((unsigned)desired << shift));
+        if (__atomic_compare_exchange_n(
+            &codes[state >> 2], &old, updated, 1, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED
+        )) return 1;
+    }
+    return 0;
+}
+
+// Возвращает новое значение счётчика.
+static uint8_t decrementCode(uint8_t *codes, uint64_t state) {
+    const unsigned shift = (state & 3) << 1;
+    uint8_t old = __atomic_fetch_sub(&codes[state >> 2], (uint8_t)(1u << shift), __ATOMIC_ACQ_REL);
+    return ((old >> shift) & 3) - 1;
+}
+
+static uint8_t getChunk(struct Analysis *analysis, uint64_t *begin, uint64_t *end) {
+    *begin = __atomic_fetch_add(&analysis->next_chunk, CHUNK_STATES, __ATOMIC_RELAXED);
+    if (*begin >= analysis->num_of_states) return 0;
+    *end = *begin + CHUNK_STATES < analysis->num_of_states ? *begin + CHUNK_STATES : analysis->num_of_states;
+    return 1;
+}
+
+// Куски кратны 4 состояниям, поэтому потоки пишут в разные байты.
+static void *countInDegrees(void *arg) {
+    struct Worker *worker = arg;
+    struct Analysis *analysis = worker->analysis;
+    uint64_t begin, end;
+    uint32_t predecessors[2];
+    while (getChunk(analysis, &begin, &end))
+        for (uint64_t state = begin; state < end; ++state) {
+            const uint8_t degree = getPredecessors(analysis, state, predecessors);
+            analysis->codes[state >> 2] |= (uint8_t)(degree << ((state & 3) << 1));
+            worker->accumulator.leaves += !degree;
+        }
+    return NULL;
+}
+
+// Снятый лист уменьшает счётчик следующего состояния; обнулившееся состояние
+// забирает тот, кто первым сменит его код на CODE_TREE.
+static void *peelTrees(void *arg) {
+    struct Worker *worker = arg;
+    struct Analysis *analysis = worker->analysis;
+    uint64_t begin, end;
+    while (getChunk(analysis, &begin, &end))
+        for (uint64_t state = begin; state < end; ++state) {
+            if (getCode(analysis->codes, state) || !replaceCode(analysis->codes, state, 0, CODE_TREE))
+                continue;
+            uint64_t next = state;
+            do next = getNextState(analysis, next);
+            while (!decrementCode(analysis->codes, next) && replaceCode(analysis->codes, next, 0, CODE_TREE));
+        }
+    return NULL;
+}
+
+static int pushTreeNode(struct Accumulator *accumulator, uint64_t *size, uint64_t state, uint32_t depth) {
+    if (*size == accumulator->stack_capacity) {
+        uint64_t capacity = accumulator->stack_capacity ? accumulator->stack_capacity * 2 : 1024;
+        struct TreeNode *stack = realloc(accumulator->stack, capacity * sizeof(struct TreeNode));
+        if (!stack) return -1;
+        accumulator->stack = stack;
+        accumulator->stack_capacity = capacity;
+    }
+    accumulator->stack[(*size)++] = (struct TreeNode){(uint32_t)state, depth};
+    return 0;
+}
+
+static int addCycleClass(struct Accumulator *accumulator, const struct Cycle *cycle) {
+    if (2 * (accumulator->size + 1) > accumulator->capacity) {
+        uint64_t capacity = accumulator->capacity ? accumulator->capacity * 2 : 64;
+        struct CycleClass *classes = calloc(capacity, sizeof(struct CycleClass));
+        if (!classes) return -1;
+        for (uint64_t i = 0; i < accumulator->capacity; ++i) {
+            if (!accumulator->classes[i].length) continue;
+            uint64_t j = accumulator->classes[i].length * 0x9E3779B97F4A7C15 & (capacity - 1);
+            while (classes[j].length) j = (j + 1) & (capacity - 1);
+            classes[j] = accumulator->classes[i];
+        }
+        free(accumulator->classes);
+        accumulator->classes = classes;
+        accumulator->capacity = capacity;
+    }
+    uint64_t j = cycle->length * 0x9E3779B97F4A7C15 & (accumulator->capacity - 1);
+    while (accumulator->classes[j].length && accumulator->classes[j].length != cycle->length)
+        j = (j + 1) & (accumulator->capacity - 1);
+    struct CycleClass *class = &accumulator->classes[j];
+    if (!class->length) {
+        class->length = cycle->length;
+        ++accumulator->size;
+    }
+    ++class->cycles;
+    class->basin += cycle->basin;
+    if (cycle->max_tail > class->max_tail) class->max_tail = cycle->max_tail;
+    return 0;
+}
+
+static int addCycle(struct Accumulator *accumulator, const struct Cycle *cycle) {
+    if (accumulator->num_of_cycles == accumulator->cycles_capacity) {
+        uint64_t capacity = accumulator->cycles_capacity ? accumulator->cycles_capacity * 2 : 64;
+        struct Cycle *cycles = realloc(accumulator->cycles, capacity * sizeof(struct Cycle));
+        if (!cycles) return -1;
+        accumulator->cycles = cycles;
+        accumulator->cycles_capacity = capacity;
+    }
+    accumulator->cycles[accumulator->num_of_cycles++] = *cycle;
+    return 0;
+}
+
+// Обходит деревья, висящие на цикле, считая размер бассейна и длину хвоста.
+static void processCycle(struct Analysis *analysis, struct Accumulator *accumulator, struct Cycle cycle) {
+    uint32_t predecessors[2];
+    uint64_t state = cycle.representative;
+    cycle.basin = cycle.length;
+    cycle.max_tail = 0;
+    for (uint64_t i = 0; i < cycle.length; ++i, state = getNextState(analysis, state)) {
+        uint64_t size = 0;
+        uint8_t count = getPredecessors(analysis, state, predecessors);
+        for (uint8_t j = 0; j < count; ++j)
+            if (getCode(analysis->codes, predecessors[j]) == CODE_TREE &&
+                pushTreeNode(accumulator, &size, predecessors[j], 1)) goto error;
+        while (size) {
+            struct TreeNode node = accumulator->stack[--size];
+            ++cycle.basin;
+            if (node.depth > cycle.max_tail) cycle.max_tail = node.depth;
+            count = getPredecessors(analysis, node.state, predecessors);
+            for (uint8_t j = 0; j < count; ++j)
+                if (pushTreeNode(accumulator, &size, predecessors[j], node.depth + 1)) goto error;
+        }
+    }
+    if (addCycleClass(accumulator, &cycle)) goto error;
+    if (analysis->list_cycles && addCycle(accumulator, &cycle)) goto error;
+    return;
+error:
+    accumulator->error = -1;
+}
+
+static void *consumeCycles(void *arg) {
+    struct Worker *worker = arg;
+    struct Analysis *analysis = worker->analysis;
+    while (1) {
+        pthread_mutex_lock(&analysis->mutex);
+        while (analysis->head == analysis->tail && !analysis->done)
+            pthread_cond_wait(&analysis->not_empty, &analysis->mutex);
+        if (analysis->head == analysis->tail) {
+            pthread_mutex_unlock(&analysis->mutex);
+            return NULL;
+        }
+        struct Cycle cycle = analysis->queue[analysis->head++ % QUEUE_SIZE];
+        pthread_cond_signal(&analysis->not_full);
+        pthread_mutex_unlock(&analysis->mutex);
+        processCycle(analysis, &worker->accumulator, cycle);
+    }
+}
+
+static void pushCycle(struct Analysis *analysis, struct Cycle cycle) {
+    pthread_mutex_lock(&analysis->mutex);
+    while (analysis->tail - analysis->head == QUEUE_SIZE)
+        pthread_cond_wait(&analysis->not_full, &analysis->mutex);
+    analysis->queue[analysis->tail++ % QUEUE_SIZE] = cycle;
+    pthread_cond_signal(&analysis->not_empty);
+    pthread_mutex_unlock(&analysis->mutex);
+}
+
+// Перечисляет циклы по возрастанию наименьшего состояния. Если потоков
+// больше одного, деревья обходят остальные потоки.
+static void enumerateCycles(struct Analysis *analysis, struct Worker *workers, unsigned num_of_threads) {
+    for (uint64_t state = 0; state < analysis->num_of_states; ++state) {
+        if (getCode(analysis->codes, state) != 1) continue;
+        struct Cycle cycle = {.representative = (uint32_t)state};
+        uint64_t next = state;
+        do {
+            replaceCode(analysis->codes, next, 1, CODE_VISITED_CYCLE);
+            next = getNextState(analysis, next);
+            ++cycle.length;
+        } while (next != state);
+        if (num_of_threads > 1) pushCycle(analysis, cycle);
+        else processCycle(analysis, &workers[0].accumulator, cycle);
+    }
+    pthread_mutex_lock(&analysis->mutex);
+    analysis->done = 1;
+    pthread_cond_broadcast(&analysis->not_empty);
+    pthread_mutex_unlock(&analysis->mutex);
+}
+
+static void runInThreads(struct Worker *workers, unsigned num_of_threads, void *(*function)(void *)) {
+    workers[0].analysis->next_chunk = 0;
+    unsigned started = 1;
+    for (; started < num_of_threads; ++started)
+        if (pthread_create(&workers[started].thread, NULL, function, &workers[started])) break;
+    function(&workers[0]);
+    for (unsigned i = 1; i < started; ++i) pthread_join(workers[i].thread, NULL);
+}
+
+static int compareCycleClasses(const void *first, const void *second) {
+    const struct CycleClass *a = first, *b = second;
+    return (a->length > b->length) - (a->length < b->length);
+}
+
+static int compareCycles(const void *first, const void *second) {
+    const struct Cycle *a = first, *b = second;
+    return (a->representative > b->representative) - (a->representative < b->representative);
+}
+
+static int mergeAccumulators(struct CycleStructure *result, struct Worker *workers, unsigned num_of_threads) {
+    uint64_t num_of_classes = 0, num_of_cycles = 0;
+    for (unsigned i = 0; i < num_of_threads; ++i) {
+        if (workers[i].accumulator.error) return -1;
+        num_of_classes += workers[i].accumulator.size;
+        num_of_cycles += workers[i].accumulator.num_of_cycles;
+        result->leaves += workers[i].accumulator.leaves;
+    }
+    result->classes = malloc((num_of_classes ? num_of_classes : 1) * sizeof(struct CycleClass));
+    if (!result->classes) return -1;
+    for (unsigned i = 0; i < num_of_threads; ++i)
+        for (uint64_t j = 0; j < workers[i].accumulator.capacity; ++j)
+            if (workers[i].accumulator.classes[j].length)
+                result->classes[result->num_of_classes++] = workers[i].accumulator.classes[j];
+    qsort(result->classes, result->num_of_classes, sizeof(struct CycleClass), compareCycleClasses);
+    uint64_t merged = 0;
+    for (uint64_t i = 0; i < result->num_of_classes; ++i) {
+        struct CycleClass *class = &result->classes[i];
+        if (merged && result->classes[merged - 1].length == class->length) {
+            struct CycleClass *target = &result->classes[merged - 1];
+            target->cycles += class->cycles;
+            target->basin += class->basin;
+            if (class->max_tail > target->max_tail) target->max_tail = class->max_tail;
+        } else result->classes[merged++] = *class;
+    }
+    result->num_of_classes = merged;
+    for (uint64_t i = 0; i < merged; ++i) {
+        result->num_of_cycles += result->classes[i].cycles;
+        result->cyclic_states += result->classes[i].cycles * result->classes[i].length;
+        if (result->classes[i].max_tail > result->max_tail) result->max_tail = result->classes[i].max_tail;
+    }
+    if (!num_of_cycles) return 0;
+    if (!(result->cycles = malloc(num_of_cycles * sizeof(struct Cycle)))) return -1;
+    num_of_cycles = 0;
+    for (unsigned i = 0; i < num_of_threads; ++i) {
+        if (!workers[i].accumulator.num_of_cycles) continue;
+        memcpy(
+            result->cycles + num_of_cycles, workers[i].accumulator.cycles,
+            workers[i].accumulator.num_of_cycles * sizeof(struct Cycle)
+        );
+        num_of_cycles += workers[i].accumulator.num_of_cycles;
+    }
+    qsort(result->cycles, num_of_cycles, sizeof(struct Cycle), compareCycles);
+    return 0;
+}
+
+int analyzeCycleStructure(
+    struct CycleStructure *result,
+    const struct ShiftRegister *reg,
+    uint8_t x,
+    unsigned num_of_threads,
+    uint8_t list_cycles
+) {
+    memset(result, 0, sizeof(*result));
+    if (!num_of_threads) num_of_threads = 1;
+    int return_code = 0;
+    struct Analysis *analysis = calloc(1, sizeof(struct Analysis));
+    struct Worker *workers = calloc(num_of_threads, sizeof(struct Worker));
+    if (!analysis || !workers) {
+        return_code = -1;
+        goto end;
+    }
+    analysis->reg = reg;
+    analysis->x = x;
+    analysis->list_cycles = list_cycles;
+    analysis->num_of_states = (uint64_t)1 << reg->length;
+    if (!(analysis->codes = allocLarge((analysis->num_of_states + 3) / 4, &analysis->codes_kind))) {
+        return_code = -1;
+        goto end;
+    }
+    pthread_mutex_init(&analysis->mutex, NULL);
+    pthread_cond_init(&analysis->not_empty, NULL);
+    pthread_cond_init(&analysis->not_full, NULL);
+    for (unsigned i = 0; i < num_of_threads; ++i) workers[i].analysis = analysis;
+    runInThreads(workers, num_of_threads, countInDegrees);
+    runInThreads(workers, num_of_threads, peelTrees);
+    unsigned started = 1;
+    for (; started < num_of_threads; ++started)
+        if (pthread_create(&workers[started].thread, NULL, consumeCycles, &workers[started])) break;
+    enumerateCycles(analysis, workers, started);
+    for (unsigned i = 1; i < started; ++i) pthread_join(workers[i].thread, NULL);
+    if (mergeAccumulators(result, workers, num_of_threads)) {
+        freeCycleStructure(result);
+        return_code = -2;
+    }
+    pthread_mutex_destroy(&analysis->mutex);
+    pthread_cond_destroy(&analysis->not_empty);
+    pthread_cond_destroy(&analysis->not_full);
+end:
+    if (workers)
+        for (unsigned i = 0; i < num_of_threads; ++i) {
+            free(workers[i].accumulator.classes);
+            free(workers[i].accumulator.cycles);
+            free(workers[i].accumulator.stack);
+        }
+    if (analysis) freeLarge(analysis->codes, (analysis->num_of_states + 3) / 4, analysis->codes_kind);
+    free(analysis);
+    free(workers);
+    return return_code;
+}
+
+void freeCycleStructure(struct CycleStructure *result) {
+    free(result->classes);
+    free(result->cycles);
+    result->classes = NULL;
+    result->cycles = NULL;
+    result->num_of_classes = 0;
+}
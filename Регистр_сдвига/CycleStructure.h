@@ -0,0 +1,53 @@
+#ifndef CYCLE_STRUCTURE_H
+#define CYCLE_STRUCTURE_H
+
+#include "ShiftRegister.h"
+
+// Циклы одной длины: их число, суммарный размер бассейнов (вместе с самими
+// циклами) и наибольшая длина хвоста.
+struct CycleClass {
+    uint64_t length;
+    uint64_t cycles;
+    uint64_t basin;
+    uint64_t max_tail;
+};
+
+// Отдельный цикл, representative - наименьшее состояние на нём.
+struct Cycle {
+    uint32_t representative;
+    uint64_t length;
+    uint64_t basin;
+    uint64_t max_tail;
+};
+
+struct CycleStructure {
+    uint64_t num_of_cycles;
+    uint64_t cyclic_states;
+    // Состояния без прообраза.
+    uint64_t leaves;
+    uint64_t max_tail;
+    // Отсортированы по длине цикла.
+    struct CycleClass *classes;
+    uint64_t num_of_classes;
+    // Заполняется, только если запрошен список циклов; отсортирован по representative.
+    struct Cycle *cycles;
+};
+
+// Разбирает функциональный граф state -> getStateFunctionValue(state, x) на циклы
+// и деревья. Память - 2 бита на состояние: счётчик входящих рёбер, по которому
+// сначала обрываются деревья (листья снимаются, пока счётчики не обнулятся),
+// а оставшиеся состояния лежат на циклах. Прообразы состояния не хранятся,
+// а вычисляются: это (state >> 1) | (b << (n - 1)), если phi на них даёт
+// младший бит state. Подсчёт входящих рёбер и обрыв деревьев идут в
+// num_of_threads потоках; циклы перечисляются одним потоком, а обход их
+// деревьев раздаётся остальным.
+int analyzeCycleStructure(
+    struct CycleStructure *result,
+    const struct ShiftRegister *reg,
+    uint8_t x,
+    unsigned num_of_threads,
+    uint8_t list_cycles
+);
+void freeCycleStructure(struct CycleStructure *result);
+
+#endif
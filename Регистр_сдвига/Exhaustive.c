@@ -0,0 +1,283 @@
+#include "Exhaustive.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+uint16_t packSmallProperties(const struct SmallProperties *properties) {
+    return (uint16_t)(
+        (properties->num_of_classes - 1) |
+        properties->degree_of_distinguishability << 4 |
+        properties->strongly_connected << 7 |
+        properties->connected << 8 |
+        properties->memory << 9
+    );
+}
+
+void unpackSmallProperties(uint16_t code, struct SmallProperties *properties) {
+    properties->num_of_classes = (code & 0xF) + 1;
+    properties->degree_of_distinguishability = (code >> 4) & 7;
+    properties->strongly_connected = (code >> 7) & 1;
+    properties->connected = (code >> 8) & 1;
+    properties->memory = (code >> 9) & 0x3F;
+}
+
+static void getNextStates(uint8_t length, const struct SmallTables *small, uint8_t next[2][64]) {
+    for (unsigned state = 0; state < 1u << length; ++state)
+        for (unsigned x = 0; x < 2; ++x)
+            next[x][state] = (uint8_t)(((state << 1) | ((small->phi[x] >> state) & 1)) & ((1u << length) - 1));
+}
+
+static uint64_t getClosure(const uint64_t *edges, uint64_t reached) {
+    uint64_t previous;
+    do {
+        previous = reached;
+        for (uint64_t m = previous; m; m &= m - 1) reached |= edges[__builtin_ctzll(m)];
+    } while (reached != previous);
+    return reached;
+}
+
+// Связность графа переходов при обоих входах: сильная - из состояния 0 достижимы все
+// и все достигают его, слабая - то же без учёта направления рёбер.
+static void getSmallConnectivity(uint8_t length, const uint8_t next[2][64], uint8_t *strongly, uint8_t *weakly) {
+    const unsigned num_of_states = 1u << length;
+    const uint64_t all = num_of_states == 64 ? ~(uint64_t)0 : ((uint64_t)1 << num_of_states) - 1;
+    uint64_t forward[64] = {0}, backward[64] = {0}, both[64];
+    for (unsigned state = 0; state < num_of_states; ++state)
+        for (unsigned x = 0; x < 2; ++x) {
+            forward[state] |= (uint64_t)1 << next[x][state];
+            backward[next[x][state]] |= (uint64_t)1 << state;
+        }
+    for (unsigned state = 0; state < num_of_states; ++state) both[state] = forward[state] | backward[state];
+    *strongly = getClosure(forward, 1) == all && getClosure(backward, 1) == all;
+    *weakly = getClosure(both, 1) == all;
+}
+
+// Память по определению из Memory.cpp: наименьшее m, при котором никакая пара входных
+// и выходных последовательностей длины m не приводит в два разных класса. Это на
+// единицу больше длины самого длинного пути в графе пар различных классов, где
+// (i, j) -> (next(i, x), next(j, x)) при равных выходах; цикл - память бесконечна.
+// Пар не больше 28, так что множества пар - маски, и из графа по очереди удаляются
+// пары без последователей среди оставшихся.
+static uint8_t getSmallMemory(
+    const uint8_t next[2][64],
+    const uint64_t out[2],
+    const uint64_t *classes,
+    unsigned num_of_classes
+) {
+    if (num_of_classes == 1) return 0;
+    uint8_t class_of[64], representative[64];
+    for (unsigned c = 0; c < num_of_classes; ++c) {
+        representative[c] = (uint8_t)__builtin_ctzll(classes[c]);
+        for (uint64_t m = classes[c]; m; m &= m - 1) class_of[__builtin_ctzll(m)] = (uint8_t)c;
+    }
+    // Пара (i, j), i < j, - бит i * num_of_classes + j.
+    uint64_t successors[64], remaining = 0;
+    for (unsigned i = 0; i < num_of_classes; ++i)
+        for (unsigned j = i + 1; j < num_of_classes; ++j) {
+            const unsigned pair = i * num_of_classes + j;
+            remaining |= (uint64_t)1 << pair;
+            successors[pair] = 0;
+            for (unsigned x = 0; x < 2; ++x) {
+                if (((out[x] >> representative[i]) & 1) != ((out[x] >> representative[j]) & 1)) continue;
+                const unsigned a = class_of[next[x][representative[i]]], b = class_of[next[x][representative[j]]];
+                if (a == b) continue;
+                successors[pair] |= (uint64_t)1 << (a < b ? a * num_of_classes + b : b * num_of_classes + a);
+            }
+        }
+    uint8_t memory = 0;
+    while (remaining) {
+        uint64_t left = 0;
+        for (uint64_t m = remaining; m; m &= m - 1)
+            if (successors[__builtin_ctzll(m)] & remaining) left |= m & -m;
+        if (left == remaining) return EXHAUSTIVE_INFINITE_MEMORY;
+        remaining = left;
+        ++memory;
+    }
+    return memory;
+}
+
+static uint16_t analyzeSmallPair(
+    uint8_t length,
+    const struct SmallTables *small,
+    const uint8_t next[2][64],
+    uint8_t strongly_connected,
+    uint8_t connected
+) {
+    uint64_t classes[64], next_classes[64];
+    struct SmallProperties properties = {
+        .strongly_connected = strongly_connected, .connected = connected
+    };
+    unsigned num_of_classes = getSmallOutputClasses(length, small, classes);
+    if (num_of_classes > 1)
+        while (1) {
+            ++properties.degree_of_distinguishability;
+            const unsigned num_of_next_classes = refineSmallClasses(next, classes, num_of_classes, next_classes);
+            memcpy(classes, next_classes, num_of_next_classes * sizeof(uint64_t));
+            if (num_of_next_classes == num_of_classes) break;
+            num_of_classes = num_of_next_classes;
+        }
+    const uint64_t out[2] = {
+        (small->psi[0] & ~small->phi[0]) | (small->psi[1] & small->phi[0]),
+        (small->psi[0] & ~small->phi[1]) | (small->psi[1] & small->phi[1])
+    };
+    properties.num_of_classes = (uint8_t)num_of_classes;
+    properties.memory = getSmallMemory(next, out, classes, num_of_classes);
+    return packSmallProperties(&properties);
+}
+
+void analyzeSmallShiftRegister(uint8_t length, const struct SmallTables *small, struct SmallProperties *properties) {
+    uint8_t next[2][64], strongly_connected, connected;
+    getNextStates(length, small, next);
+    getSmallConnectivity(length, next, &strongly_connected, &connected);
+    unpackSmallProperties(analyzeSmallPair(length, small, next, strongly_connected, connected), properties);
+}
+
+// Перестановки номеров функций, общие для всех потоков. Замена входа меняет местами
+// соседние биты phi; замена состояния на противоположное переводит phi(s, x) в
+// phi(~s, x) + 1 и psi(s, b) в psi(~s, b + 1) (автомат изоморфен исходному).
+struct Sweep {
+    uint8_t length;
+    uint8_t width;
+    uint64_t num_of_functions;
+    uint16_t *complement_state_phi;
+    uint16_t *complement_state_psi;
+    // Значения на чётных (x = 0) и нечётных (x = 1) индексах - слова SmallTables.
+    uint8_t *even;
+    uint8_t *odd;
+    uint16_t *table;
+    uint64_t next_phi;
+};
+
+struct SweepWorker {
+    struct Sweep *sweep;
+    pthread_t thread;
+    uint64_t *histogram;
+    uint64_t num_of_representatives;
+};
+
+static inline uint64_t swapInput(uint64_t function) {
+    return ((function & 0x5555) << 1) | ((function >> 1) & 0x5555);
+}
+
+static void fillOrbit(const struct Sweep *sweep, uint64_t phi, uint64_t psi, uint16_t code) {
+    const uint64_t full = sweep->num_of_functions - 1;
+    for (unsigned state = 0; state < 2; ++state)
+        for (unsigned input = 0; input < 2; ++input)
+            for (unsigned output = 0; output < 2; ++output) {
+                uint64_t image_phi = state ? sweep->complement_state_phi[phi] : phi;
+                uint64_t image_psi = state ? sweep->complement_state_psi[psi] : psi;
+                if (input) image_phi = swapInput(image_phi);
+                if (output) image_psi ^= full;
+                sweep->table[(image_phi << sweep->width) | image_psi] = code;
+            }
+}
+
+// Считается только пара, наименьшая (по phi, затем по psi) среди своих образов, и
+// учитывается с весом, равным размеру орбиты.
+static void *sweepFunctions(void *arg) {
+    struct SweepWorker *worker = arg;
+    struct Sweep *sweep = worker->sweep;
+    const uint64_t full = sweep->num_of_functions - 1;
+    uint64_t phi;
+    while ((phi = __atomic_fetch_add(&sweep->next_phi, 1, __ATOMIC_RELAXED)) < sweep->num_of_functions) {
+        const uint64_t phi_input = swapInput(phi), phi_state = sweep->complement_state_phi[phi];
+        const uint64_t phi_both = swapInput(phi_state);
+        if (phi_input < phi || phi_state < phi || phi_both < phi) continue;
+        const unsigned fixing_input = 1 + (phi_input == phi), fixing_state = (phi_state == phi) + (phi_both == phi);
+        struct SmallTables small = {.phi = {sweep->even[phi], sweep->odd[phi]}};
+        uint8_t next[2][64], strongly_connected, connected;
+        getNextStates(sweep->length, &small, next);
+        getSmallConnectivity(sweep->length, next, &strongly_connected, &connected);
+        for (uint64_t psi = 0; psi <= full; ++psi) {
+            const uint64_t psi_state = sweep->complement_state_psi[psi];
+            if ((psi ^ full) < psi) continue;
+            if (fixing_state && (psi_state < psi || (psi_state ^ full) < psi)) continue;
+            const unsigned stabilizer = fixing_input + fixing_state * ((psi_state == psi) + ((psi_state ^ full) == psi));
+            small.psi[0] = sweep->even[psi];
+            small.psi[1] = sweep->odd[psi];
+            const uint16_t code = analyzeSmallPair(sweep->length, &small, next, strongly_connected, connected);
+            worker->histogram[code] += 8 / stabilizer;
+            ++worker->num_of_representatives;
+            if (sweep->table) fillOrbit(sweep, phi, psi, code);
+        }
+    }
+    return NULL;
+}
+
+static int initSweep(struct Sweep *sweep, uint8_t length, uint16_t *table) {
+    sweep->length = length;
+    sweep->width = (uint8_t)(2u << length);
+    sweep->num_of_functions = (uint64_t)1 << sweep->width;
+    sweep->table = table;
+    sweep->next_phi = 0;
+    sweep->complement_state_phi = malloc(sweep->num_of_functions * sizeof(uint16_t));
+    sweep->complement_state_psi = malloc(sweep->num_of_functions * sizeof(uint16_t));
+    sweep->even = malloc(sweep->num_of_functions);
+    sweep->odd = malloc(sweep->num_of_functions);
+    if (!sweep->complement_state_phi || !sweep->complement_state_psi || !sweep->even || !sweep->odd) return -1;
+    for (uint64_t function = 0; function < sweep->num_of_functions; ++function) {
+        uint16_t phi = 0, psi = 0;
+        uint8_t even = 0, odd = 0;
+        for (unsigned i = 0; i < sweep->width; ++i) {
+            phi |= (uint16_t)(!((function >> (i ^ (sweep->width - 2))) & 1) << i);
+            psi |= (uint16_t)(((function >> (i ^ (sweep->width - 1))) & 1) << i);
+            if (i & 1) odd |= (uint8_t)(((function >> i) & 1) << (i >> 1));
+            else even |= (uint8_t)(((function >> i) & 1) << (i >> 1));
+        }
+        sweep->complement_state_phi[function] = phi;
+        sweep->complement_state_psi[function] = psi;
+        sweep->even[function] = even;
+        sweep->odd[function] = odd;
+    }
+    return 0;
+}
+
+static void freeSweep(struct Sweep *sweep) {
+    free(sweep->complement_state_phi);
+    free(sweep->complement_state_psi);
+    free(sweep->even);
+    free(sweep->odd);
+}
+
+int sweepShiftRegisters(struct ExhaustiveResult *result, uint8_t length, unsigned num_of_threads, uint16_t *table) {
+    if (!length || length > EXHAUSTIVE_MAX_LENGTH) return -1;
+    if (num_of_threads < 1) num_of_threads = 1;
+    int rc = 0;
+    struct Sweep sweep = {0};
+    struct SweepWorker *workers = calloc(num_of_threads, sizeof(struct SweepWorker));
+    result->histogram = calloc(EXHAUSTIVE_CODES, sizeof(uint64_t));
+    if (!workers || !result->histogram || initSweep(&sweep, length, table)) {
+        rc = -2;
+        goto end;
+    }
+    for (unsigned i = 0; i < num_of_threads; ++i) {
+        workers[i].sweep = &sweep;
+        if (!(workers[i].histogram = calloc(EXHAUSTIVE_CODES, sizeof(uint64_t)))) {
+            rc = -2;
+            goto end;
+        }
+    }
+    unsigned started = 1;
+    for (; started < num_of_threads; ++started)
+        if (pthread_create(&workers[started].thread, NULL, sweepFunctions, &workers[started])) break;
+    sweepFunctions(&workers[0]);
+    for (unsigned i = 1; i < started; ++i) pthread_join(workers[i].thread, NULL);
+    result->length = length;
+    result->num_of_pairs = sweep.num_of_functions * sweep.num_of_functions;
+    result->num_of_representatives = 0;
+    for (unsigned i = 0; i < num_of_threads; ++i) {
+        result->num_of_representatives += workers[i].num_of_representatives;
+        for (uint32_t code = 0; code < EXHAUSTIVE_CODES; ++code) result->histogram[code] += workers[i].histogram[code];
+    }
+end:
+    if (workers)
+        for (unsigned i = 0; i < num_of_threads; ++i) free(workers[i].histogram);
+    free(workers);
+    freeSweep(&sweep);
+    if (rc) freeExhaustiveResult(result);
+    return rc;
+}
+
+void freeExhaustiveResult(struct ExhaustiveResult *result) {
+    free(result->histogram);
+    result->histogram = NULL;
+}
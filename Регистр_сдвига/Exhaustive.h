@@ -0,0 +1,46 @@
+#ifndef EXHAUSTIVE_H
+#define EXHAUSTIVE_H
+
+#include "SmallShiftRegister.h"
+
+// Перебор всех пар phi/psi регистров малой длины в одном процессе. Функция от
+// length + 1 переменных задаётся числом из 2^(length + 1) битов: бит (state << 1) | x -
+// её значение на этом индексе, как в файле настроек.
+#define EXHAUSTIVE_MAX_LENGTH 3
+#define EXHAUSTIVE_INFINITE_MEMORY 63
+
+// То, что по одному регистру выводят task2 (приведённый вес и степень различимости),
+// task3 (связность) и task4 (память; EXHAUSTIVE_INFINITE_MEMORY - бесконечна).
+struct SmallProperties {
+    uint8_t num_of_classes;
+    uint8_t degree_of_distinguishability;
+    uint8_t strongly_connected;
+    uint8_t connected;
+    uint8_t memory;
+};
+
+// Характеристики упаковываются в 15 битов: вес - 1 (4 бита), степень (3), сильная
+// связность, связность, память (6).
+#define EXHAUSTIVE_CODES (1 << 15)
+uint16_t packSmallProperties(const struct SmallProperties *properties);
+void unpackSmallProperties(uint16_t code, struct SmallProperties *properties);
+
+// histogram[code] - число пар с характеристиками code.
+struct ExhaustiveResult {
+    uint8_t length;
+    uint64_t num_of_pairs;
+    // Сколько пар посчитано непосредственно: остальные получаются из них заменой
+    // входа, выхода или всех битов состояния на противоположные, что не меняет
+    // ни одной из характеристик.
+    uint64_t num_of_representatives;
+    uint64_t *histogram;
+};
+
+// Характеристики регистра с таблицами small (length <= EXHAUSTIVE_MAX_LENGTH).
+void analyzeSmallShiftRegister(uint8_t length, const struct SmallTables *small, struct SmallProperties *properties);
+// Если table != NULL, в table[(phi << 2^(length + 1)) | psi] записывается код каждой
+// пары: 2^(2^(length + 2)) элементов.
+int sweepShiftRegisters(struct ExhaustiveResult *result, uint8_t length, unsigned num_of_threads, uint16_t *table);
+void freeExhaustiveResult(struct ExhaustiveResult *result);
+
+#endif
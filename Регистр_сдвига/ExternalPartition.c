@@ -0,0 +1,274 @@
+#include "ExternalPartition.h"
+#include "Alloc.h"
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define RADIX_BITS 8
+#define RADIX_DIGITS (1 << RADIX_BITS)
+// Три 32-битных поля ключа.
+#define RADIX_PASSES 12
+#define EXTERNAL_MIN_CHUNK_STATES ((uint64_t)1 << 12)
+
+// Ключ состояния. После слияния в current записывается новый номер класса.
+struct StateRecord {
+    uint32_t current;
+    uint32_t next_0;
+    uint32_t next_1;
+    uint32_t state;
+};
+
+struct MappedFile {
+    void *data;
+    uint64_t size;
+};
+
+struct ExternalStep {
+    const struct ShiftRegister *reg;
+    uint64_t num_of_states;
+    uint64_t chunk_size;
+    uint64_t num_of_runs;
+    struct MappedFile classes[2];
+    struct MappedFile runs;
+    struct StateRecord *records;
+    struct StateRecord *buffer;
+    uint64_t *counts;
+    // Слияние: позиция каждой серии и куча номеров серий по их текущей записи.
+    uint64_t *positions;
+    uint32_t *heap;
+};
+
+// Файл создаётся и сразу удаляется: место освобождается при munmap, даже если
+// программа упадёт.
+static int mapTemporaryFile(struct MappedFile *file, const char *directory, uint64_t size) {
+    static const char name[] = "/shift_register_XXXXXX";
+    char *path = malloc(strlen(directory) + sizeof(name));
+    if (!path) return -1;
+    strcpy(path, directory);
+    strcat(path, name);
+    const int fd = mkstemp(path);
+    if (fd >= 0) unlink(path);
+    free(path);
+    if (fd < 0) return -2;
+    if (ftruncate(fd, (off_t)size)) {
+        close(fd);
+        return -2;
+    }
+    void *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return -2;
+    madvise(data, size, MADV_SEQUENTIAL);
+    file->data = data;
+    file->size = size;
+    return 0;
+}
+
+static void unmapTemporaryFile(struct MappedFile *file) {
+    if (file->data) munmap(file->data, file->size);
+    file->data = NULL;
+}
+
+// Первый шаг: номер класса - место набора выходов среди встречающихся, как в
+// initOutputPartition. Возвращает число классов.
+static uint64_t initOutputClasses(struct ExternalStep *step) {
+    uint32_t *classes = step->classes[0].data;
+    uint64_t counts[4] = {0};
+    for (uint64_t state = 0; state < step->num_of_states; ++state)
+        ++counts[getShiftRegisterOutputs(getShiftRegisterTransitions(step->reg, state))];
+    uint32_t ids[4];
+    uint64_t num_of_classes = 0;
+    for (uint8_t outputs = 0; outputs < 4; ++outputs)
+        if (counts[outputs]) ids[outputs] = (uint32_t)num_of_classes++;
+    for (uint64_t state = 0; state < step->num_of_states; ++state)
+        classes[state] = ids[getShiftRegisterOutputs(getShiftRegisterTransitions(step->reg, state))];
+    return num_of_classes;
+}
+
+static inline uint8_t getDigit(const struct StateRecord *record, uint8_t pass) {
+    const uint32_t field = pass < 4 ? record->next_1 : pass < 8 ? record->next_0 : record->current;
+    return (uint8_t)(field >> ((pass & 3) * RADIX_BITS));
+}
+
+// Устойчивая поразрядная сортировка по (current, next_0, next_1), от младших
+// разрядов. Разряды, одинаковые у всех записей, пропускаются. Возвращает records
+// или buffer - где оказался результат.
+static struct StateRecord *sortRecords(
+    struct StateRecord *records, struct StateRecord *buffer, uint64_t size, uint64_t *counts
+) {
+    memset(counts, 0, RADIX_PASSES * RADIX_DIGITS * sizeof(uint64_t));
+    for (uint64_t i = 0; i < size; ++i)
+        for (uint8_t pass = 0; pass < RADIX_PASSES; ++pass)
+            ++counts[pass * RADIX_DIGITS + getDigit(&records[i], pass)];
+    for (uint8_t pass = 0; pass < RADIX_PASSES; ++pass) {
+        uint64_t *count = counts + pass * RADIX_DIGITS;
+        if (count[getDigit(&records[0], pass)] == size) continue;
+        uint64_t offset = 0;
+        for (unsigned digit = 0; digit < RADIX_DIGITS; ++digit) {
+            const uint64_t temp = count[digit];
+            count[digit] = offset;
+            offset += temp;
+        }
+        for (uint64_t i = 0; i < size; ++i) buffer[count[getDigit(&records[i], pass)]++] = records[i];
+        struct StateRecord *temp = records;
+        records = buffer;
+        buffer = temp;
+    }
+    return records;
+}
+
+static uint64_t getRunSize(const struct ExternalStep *step, uint64_t run) {
+    const uint64_t rest = step->num_of_states - run * step->chunk_size;
+    return rest < step->chunk_size ? rest : step->chunk_size;
+}
+
+// Серии: ключи каждого куска состояний, отсортированные в памяти.
+static void writeRuns(struct ExternalStep *step, const uint32_t *classes) {
+    struct StateRecord *runs = step->runs.data;
+    const uint64_t mask = step->reg->mask;
+    for (uint64_t run = 0; run < step->num_of_runs; ++run) {
+        const uint64_t begin = run * step->chunk_size, size = getRunSize(step, run);
+        for (uint64_t i = 0; i < size; ++i) {
+            const uint64_t state = begin + i;
+            const uint8_t transitions = getShiftRegisterTransitions(step->reg, state);
+            step->records[i] = (struct StateRecord){
+                .current = classes[state],
+                .next_0 = classes[((state << 1) | (transitions & 1)) & mask],
+                .next_1 = classes[((state << 1) | ((transitions >> 1) & 1)) & mask],
+                .state = (uint32_t)state
+            };
+        }
+        const struct StateRecord *sorted = sortRecords(step->records, step->buffer, size, step->counts);
+        memcpy(runs + begin, sorted, size * sizeof(struct StateRecord));
+    }
+}
+
+static inline uint8_t isLess(const struct StateRecord *first, const struct StateRecord *second) {
+    if (first->current != second->current) return first->current < second->current;
+    if (first->next_0 != second->next_0) return first->next_0 < second->next_0;
+    return first->next_1 < second->next_1;
+}
+
+static inline uint8_t isSameKey(const struct StateRecord *first, const struct StateRecord *second) {
+    return
+        first->current == second->current && first->next_0 == second->next_0 && first->next_1 == second->next_1;
+}
+
+static void siftDown(struct ExternalStep *step, uint64_t size, uint64_t i) {
+    const struct StateRecord *runs = step->runs.data;
+    uint32_t *heap = step->heap;
+    while (1) {
+        uint64_t least = i;
+        const uint64_t left = 2 * i + 1, right = left + 1;
+        if (left < size && isLess(&runs[step->positions[heap[left]]], &runs[step->positions[heap[least]]]))
+            least = left;
+        if (right < size && isLess(&runs[step->positions[heap[right]]], &runs[step->positions[heap[least]]]))
+            least = right;
+        if (least == i) return;
+        const uint32_t temp = heap[i];
+        heap[i] = heap[least];
+        heap[least] = temp;
+        i = least;
+    }
+}
+
+// Слияние серий: новый номер - место ключа среди различных, пишется в current.
+// Возвращает число новых классов.
+static uint64_t mergeRuns(struct ExternalStep *step) {
+    struct StateRecord *runs = step->runs.data;
+    uint64_t size = step->num_of_runs;
+    for (uint64_t run = 0; run < size; ++run) {
+        step->positions[run] = run * step->chunk_size;
+        step->heap[run] = (uint32_t)run;
+    }
+    for (uint64_t i = size / 2; i-- > 0;) siftDown(step, size, i);
+    struct StateRecord previous;
+    uint64_t num_of_classes = 0;
+    while (size) {
+        const uint32_t run = step->heap[0];
+        struct StateRecord *record = &runs[step->positions[run]];
+        if (!num_of_classes || !isSameKey(record, &previous)) {
+            previous = *record;
+            ++num_of_classes;
+        }
+        record->current = (uint32_t)(num_of_classes - 1);
+        if (++step->positions[run] == run * step->chunk_size + getRunSize(step, run))
+            step->heap[0] = step->heap[--size];
+        siftDown(step, size, 0);
+    }
+    return num_of_classes;
+}
+
+// Серия run состоит из состояний своего куска, так что запись идёт в одно окно массива.
+static void scatterRuns(struct ExternalStep *step, uint32_t *classes) {
+    const struct StateRecord *runs = step->runs.data;
+    for (uint64_t i = 0; i < step->num_of_states; ++i) classes[runs[i].state] = runs[i].current;
+}
+
+int minimizeShiftRegisterExternally(
+    struct Minimized *minimized,
+    const struct ShiftRegister *reg,
+    const char *directory,
+    uint64_t memory_limit,
+    uint8_t flags
+) {
+    struct ExternalStep step = {.reg = reg, .num_of_states = (uint64_t)1 << reg->length};
+    initMinimized(minimized, step.num_of_states);
+    minimized->printState = (PrintValue)printState;
+    minimized->freeValue = NULL;
+    if (!memory_limit)
+        memory_limit = (uint64_t)sysconf(_SC_PHYS_PAGES) * (uint64_t)sysconf(_SC_PAGESIZE) >> EXTERNAL_MEMORY_SHARE_SHIFT;
+    // Записи куска и буфер сортировки.
+    step.chunk_size = memory_limit / (2 * sizeof(struct StateRecord));
+    if (step.chunk_size < EXTERNAL_MIN_CHUNK_STATES) step.chunk_size = EXTERNAL_MIN_CHUNK_STATES;
+    if (step.chunk_size > step.num_of_states) step.chunk_size = step.num_of_states;
+    step.num_of_runs = (step.num_of_states + step.chunk_size - 1) / step.chunk_size;
+    int rc = 0;
+    if (
+        !(step.records = malloc(step.chunk_size * sizeof(struct StateRecord))) ||
+        !(step.buffer = malloc(step.chunk_size * sizeof(struct StateRecord))) ||
+        !(step.counts = malloc(RADIX_PASSES * RADIX_DIGITS * sizeof(uint64_t))) ||
+        !(step.positions = malloc(step.num_of_runs * sizeof(uint64_t))) ||
+        !(step.heap = malloc(step.num_of_runs * sizeof(uint32_t)))
+    ) {
+        rc = -1;
+        goto end;
+    }
+    for (uint8_t i = 0; i < 2; ++i)
+        if ((rc = mapTemporaryFile(&step.classes[i], directory, step.num_of_states * sizeof(uint32_t)))) goto end;
+    if ((rc = mapTemporaryFile(&step.runs, directory, step.num_of_states * sizeof(struct StateRecord)))) goto end;
+    uint64_t num_of_classes = initOutputClasses(&step);
+    uint8_t current = 0;
+    if (num_of_classes > 1)
+        while (1) {
+            if (addMinimizedRound(minimized, num_of_classes)) {
+                rc = -1;
+                goto end;
+            }
+            writeRuns(&step, step.classes[current].data);
+            const uint64_t num_of_next_classes = mergeRuns(&step);
+            if (num_of_next_classes == num_of_classes) break;
+            scatterRuns(&step, step.classes[current ^ 1].data);
+            current ^= 1;
+            num_of_classes = num_of_next_classes;
+        }
+    minimized->num_of_classes = num_of_classes;
+    minimized->original_is_minimal =
+        minimized->degree_of_distinguishability && num_of_classes == step.num_of_states;
+    if (flags & MINIMIZE_CLASS_ARRAY) {
+        minimized->class_of = step.classes[current].data;
+        minimized->class_of_kind = ALLOC_FILE_MAPPING;
+        step.classes[current].data = NULL;
+    }
+end:
+    unmapTemporaryFile(&step.classes[0]);
+    unmapTemporaryFile(&step.classes[1]);
+    unmapTemporaryFile(&step.runs);
+    free(step.records);
+    free(step.buffer);
+    free(step.counts);
+    free(step.positions);
+    free(step.heap);
+    if (rc) freeMinimized(minimized);
+    return rc;
+}
@@ -0,0 +1,33 @@
+#ifndef EXTERNAL_PARTITION_H
+#define EXTERNAL_PARTITION_H
+
+#include "ShiftRegister.h"
+
+// Минимизация во внешней памяти для регистров длины 30-32, у которых массивы по
+// состояниям в оперативную память не помещаются. Классы хранятся номерами позиций
+// (как в order у struct StatePartition), шаг - тот же, что у refineStatePartition:
+// ключ состояния - (класс, класс следующего при x = 0, при x = 1), новый номер -
+// место ключа среди различных ключей. Поэтому номера классов и итог совпадают с
+// minimizeShiftRegisterInThreads.
+//
+// Шаг проходит состояния по порядку кусками по memory_limit / 32 записей: ключи
+// куска сортируются в памяти и пишутся отсортированной серией, затем слияние серий
+// выдаёт новые номера (пишутся на место ключей), и третий проход раскладывает их
+// в массив классов по состояниям. Массивы классов и серии - отображённые файлы в
+// каталоге directory (удаляются сразу после создания), на диске нужно 24 байта на
+// состояние: 96 ГиБ при длине 32.
+// Если memory_limit = 0, берётся четверть оперативной памяти.
+#define EXTERNAL_MEMORY_SHARE_SHIFT 2
+
+// Из флагов учитывается только MINIMIZE_CLASS_ARRAY: class_of - отображение файла
+// с итоговыми классами (ALLOC_FILE_MAPPING). Возвращает -1 при нехватке памяти,
+// -2, если не создаются или не отображаются файлы.
+int minimizeShiftRegisterExternally(
+    struct Minimized *minimized,
+    const struct ShiftRegister *reg,
+    const char *directory,
+    uint64_t memory_limit,
+    uint8_t flags
+);
+
+#endif
@@ -0,0 +1,107 @@
+#include "GeneratedShiftRegister.h"
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dlfcn.h>
+
+static int compareMonomials(const void *a, const void *b) {
+    const uint64_t first = *(const uint64_t *)a, second = *(const uint64_t *)b;
+    return (first > second) - (first < second);
+}
+
+// Многочлен как функция name(s). Нулевой моном даёт константу: (s & 0) == 0.
+static int writeFunction(const ANF *anf, const char *name, FILE *fp) {
+    uint64_t *monomials = malloc((anf->size ? anf->size : 1) * sizeof(uint64_t));
+    if (!monomials) return -1;
+    memcpy(monomials, anf->monomials, anf->size * sizeof(uint64_t));
+    qsort(monomials, anf->size, sizeof(uint64_t), compareMonomials);
+    fprintf(fp, "static inline __attribute__((always_inline)) uint32_t %s(uint32_t s) {\n", name);
+    fprintf(fp, "    (void)s;\n    return 0");
+    for (uint64_t i = 0; i < anf->size; ++i)
+        fprintf(fp, "\n        ^ M(0x%" PRIx64 "u)", monomials[i]);
+    fprintf(fp, ";\n}\n\n");
+    free(monomials);
+    return 0;
+}
+
+int generateShiftRegisterKernel(const struct ANFShiftRegister *reg, const char *source_name, FILE *fp) {
+    if (reg->length > 32) {
+        printf("Код генерируется только для регистров длины не более 32\n");
+        return -1;
+    }
+    fprintf(fp, "// Сгенерировано shift_register_codegen.exe по %s.\n", source_name);
+    fprintf(fp, "// phi(s, x) = phi0(s) + x*phi1(s), psi(s, x) = psi0(s) + x*psi1(s).\n");
+    fprintf(fp, "#include <stdint.h>\n\n");
+    fprintf(fp, "#define MASK 0x%" PRIx64 "u\n", reg->mask);
+    fprintf(fp, "#define M(monomial) ((s & (monomial)) == (monomial))\n\n");
+    fprintf(fp, "const uint8_t " SHIFT_REGISTER_KERNEL_LENGTH " = %" PRIu8 ";\n\n", reg->length);
+    if (
+        writeFunction(&reg->phi[0], "phi0", fp) || writeFunction(&reg->phi[1], "phi1", fp) ||
+        writeFunction(&reg->psi[0], "psi0", fp) || writeFunction(&reg->psi[1], "psi1", fp)
+    ) return -2;
+    fprintf(fp,
+        "uint8_t " SHIFT_REGISTER_KERNEL_TRANSITIONS "(uint32_t s) {\n"
+        "    const uint32_t phi = phi0(s), psi = psi0(s);\n"
+        "    return (uint8_t)(phi | (phi ^ phi1(s)) << 1 | psi << 2 | (psi ^ psi1(s)) << 3);\n"
+        "}\n\n"
+        "void " SHIFT_REGISTER_KERNEL_WORDS "(\n"
+        "    uint32_t *state, const uint64_t *input, uint64_t *output, uint64_t num_of_bits\n"
+        ") {\n"
+        "    uint32_t s = *state;\n"
+        "    for (uint64_t word = 0; word < (num_of_bits + 63) / 64; ++word) {\n"
+        "        const uint64_t x = input[word];\n"
+        "        const unsigned bits = num_of_bits - word * 64 < 64 ? (unsigned)(num_of_bits - word * 64) : 64;\n"
+        "        uint64_t y = 0;\n"
+        "        for (unsigned i = 0; i < bits; ++i) {\n"
+        "            const uint32_t phi = phi0(s) ^ ((uint32_t)(x >> i) & 1 & phi1(s));\n"
+        "            y |= (uint64_t)(psi0(s) ^ (phi & psi1(s))) << i;\n"
+        "            s = ((s << 1) | phi) & MASK;\n"
+        "        }\n"
+        "        output[word] = y;\n"
+        "    }\n"
+        "    *state = s;\n"
+        "}\n"
+    );
+    return ferror(fp) ? -3 : 0;
+}
+
+uint8_t isShiftRegisterKernelFile(char *file) {
+    FILE *fp = fopen(file, "rb");
+    if (!fp) return 0;
+    char magic[4];
+    uint8_t result = fread(magic, 1, sizeof(magic), fp) == sizeof(magic) && !memcmp(magic, "\x7f" "ELF", 4);
+    fclose(fp);
+    return result;
+}
+
+int initShiftRegisterFromKernel(struct ShiftRegister *reg, char *file) {
+    // Без косой черты dlopen ищет библиотеку в системных каталогах, а не в текущем.
+    char path[4096];
+    snprintf(path, sizeof(path), "%s%s", strchr(file, '/') ? "" : "./", file);
+    void *handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        printf("Не загружается библиотека %s: %s\n", file, dlerror());
+        return -11;
+    }
+    const uint8_t *length = dlsym(handle, SHIFT_REGISTER_KERNEL_LENGTH);
+    reg->kernel.transitions = (uint8_t (*)(uint32_t))dlsym(handle, SHIFT_REGISTER_KERNEL_TRANSITIONS);
+    reg->kernel.useOnWords = (void (*)(uint32_t *, const uint64_t *, uint64_t *, uint64_t))
+        dlsym(handle, SHIFT_REGISTER_KERNEL_WORDS);
+    if (!length || *length > 32 || !reg->kernel.transitions || !reg->kernel.useOnWords) {
+        printf("В библиотеке %s нет кода регистра\n", file);
+        dlclose(handle);
+        return -11;
+    }
+    reg->kernel.handle = handle;
+    reg->length = *length;
+    reg->mask = (uint32_t)(((uint64_t)1 << reg->length) - 1);
+    reg->transitions.bucket = NULL;
+    reg->transitions.length = 0;
+    reg->transitions.mapped = 0;
+    return 0;
+}
+
+void freeShiftRegisterKernel(struct ShiftRegisterKernel *kernel) {
+    if (kernel->handle) dlclose(kernel->handle);
+    kernel->handle = NULL;
+}
@@ -0,0 +1,26 @@
+#ifndef GENERATED_SHIFT_REGISTER_H
+#define GENERATED_SHIFT_REGISTER_H
+
+#include "ShiftRegister.h"
+#include "ANFShiftRegister.h"
+
+// Код регистра генерируется по его многочленам Жегалкина: каждый многочлен - это
+// сумма по модулю 2 конъюнкций битов состояния без ветвлений и обращений к памяти.
+// Собранная из него разделяемая библиотека экспортирует:
+//   const uint8_t shift_register_kernel_length;
+//   uint8_t shift_register_kernel_transitions(uint32_t state);  - полубайт как в таблице
+//   void shift_register_kernel_words(uint32_t *state, const uint64_t *input,
+//       uint64_t *output, uint64_t num_of_bits);                 - как useShiftRegisterOnWords
+#define SHIFT_REGISTER_KERNEL_LENGTH "shift_register_kernel_length"
+#define SHIFT_REGISTER_KERNEL_TRANSITIONS "shift_register_kernel_transitions"
+#define SHIFT_REGISTER_KERNEL_WORDS "shift_register_kernel_words"
+
+// Длина регистра не больше 32. source_name попадает в комментарий в начале файла.
+int generateShiftRegisterKernel(const struct ANFShiftRegister *reg, const char *source_name, FILE *fp);
+// Файл - разделяемая библиотека (ELF).
+uint8_t isShiftRegisterKernelFile(char *file);
+// Загружает библиотеку через dlopen; таблица переходов не строится.
+int initShiftRegisterFromKernel(struct ShiftRegister *reg, char *file);
+void freeShiftRegisterKernel(struct ShiftRegisterKernel *kernel);
+
+#endif
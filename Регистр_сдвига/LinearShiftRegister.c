@@ -0,0 +1,118 @@
+#include "LinearShiftRegister.h"
+
+static inline uint8_t getNibbleBit(const struct ShiftRegister *reg, uint64_t state, uint8_t bit) {
+    return (getShiftRegisterTransitions(reg, state) >> bit) & 1;
+}
+
+// Функция с таблицей в битах shift, shift + 1 полубайтов аффинна, если
+// f(s, 1) + f(s, 0) постоянно и f(s, 0) = f(s - младший бит s, 0) + c[младший бит].
+static uint8_t detectAffineFunction(
+    const struct ShiftRegister *reg,
+    uint8_t shift,
+    uint64_t *coefficients,
+    uint8_t *constant
+) {
+    *constant = getNibbleBit(reg, 0, shift);
+    *coefficients = getNibbleBit(reg, 0, shift + 1) ^ *constant;
+    for (uint8_t i = 0; i < reg->length; ++i)
+        *coefficients |= (uint64_t)(getNibbleBit(reg, (uint64_t)1 << i, shift) ^ *constant) << (i + 1);
+    for (uint64_t state = 0; state < (uint64_t)1 << reg->length; ++state) {
+        const uint8_t nibble = getShiftRegisterTransitions(reg, state) >> shift;
+        if ((((nibble >> 1) ^ nibble) & 1) != (*coefficients & 1)) return 0;
+        if (state && (nibble & 1) != (getNibbleBit(reg, state & (state - 1), shift) ^
+            ((*coefficients >> (__builtin_ctzll(state) + 1)) & 1))) return 0;
+    }
+    return 1;
+}
+
+void detectLinearFeedback(struct ShiftRegister *reg) {
+    struct LinearFeedback *linear = &reg->linear;
+    linear->is_linear =
+        detectAffineFunction(reg, 0, &linear->phi, &linear->phi_constant) &&
+        detectAffineFunction(reg, 2, &linear->psi, &linear->psi_constant);
+}
+
+void useLinearShiftRegisterOnWords(
+    struct ShiftRegisterCursor *cursor,
+    const uint64_t *input,
+    uint64_t *output,
+    uint64_t num_of_bits
+) {
+    const struct ShiftRegister *reg = cursor->reg;
+    const uint64_t mask = reg->mask;
+    const uint64_t phi_mask = reg->linear.phi >> 1, psi_mask = reg->linear.psi >> 1;
+    const uint64_t phi_x = reg->linear.phi & 1, psi_x = reg->linear.psi & 1;
+    const uint64_t phi_constant = reg->linear.phi_constant, psi_constant = reg->linear.psi_constant;
+    uint64_t state = cursor->state;
+    for (uint64_t word = 0; word < (num_of_bits + 63) / 64; ++word) {
+        const uint64_t x = input[word];
+        const unsigned bits = num_of_bits - word * 64 < 64 ? (unsigned)(num_of_bits - word * 64) : 64;
+        uint64_t y = 0;
+        for (unsigned i = 0; i < bits; ++i) {
+            const uint64_t phi =
+                phi_constant ^ (((x >> i) & 1) & phi_x) ^ (uint64_t)__builtin_parityll(state & phi_mask);
+            y |= (psi_constant ^ (phi & psi_x) ^ (uint64_t)__builtin_parityll(state & psi_mask)) << i;
+            state = ((state << 1) | phi) & mask;
+        }
+        output[word] = y;
+    }
+    cursor->state = (uint32_t)state;
+}
+
+// Произведение многочленов над GF(2) по модулю p степени degree (бит i - коэффициент при t^i).
+static uint64_t multiplyModulo(uint64_t a, uint64_t b, uint64_t p, uint8_t degree) {
+    uint64_t result = 0;
+    for (; b; b >>= 1) {
+        if (b & 1) result ^= a;
+        a <<= 1;
+        if ((a >> degree) & 1) a ^= p;
+    }
+    return result;
+}
+
+static uint64_t powerOfTModulo(uint64_t steps, uint64_t p, uint8_t degree) {
+    uint64_t result = 1, base = 2;
+    if ((base >> degree) & 1) base ^= p;
+    for (; steps; steps >>= 1) {
+        if (steps & 1) result = multiplyModulo(result, base, p, degree);
+        base = multiplyModulo(base, base, p, degree);
+    }
+    return result;
+}
+
+void jumpShiftRegister(struct ShiftRegisterCursor *cursor, uint8_t x, uint64_t steps) {
+    const struct ShiftRegister *reg = cursor->reg;
+    const uint8_t n = reg->length;
+    if (!reg->linear.is_linear || steps <= 2 * (uint64_t)(n + 1)) {
+        for (uint64_t i = 0; i < steps; ++i) useShiftRegister(cursor, x);
+        return;
+    }
+    // Вдвигаемые биты v_m: v_0..v_{n-1} - начальное состояние (s_i = v_{n-1-i}),
+    // далее v_m = c + sum b_i v_{m-1-i}. Характеристический многочлен
+    // t^n + sum b_i t^{n-1-i}, при c = 1 он домножается на t + 1.
+    const uint64_t b = reg->linear.phi >> 1;
+    const uint8_t c = reg->linear.phi_constant ^ (x & reg->linear.phi & 1);
+    uint64_t p = (uint64_t)1 << n;
+    for (uint8_t i = 0; i < n; ++i)
+        if ((b >> i) & 1) p |= (uint64_t)1 << (n - 1 - i);
+    uint8_t degree = n;
+    if (c) {
+        p ^= p << 1;
+        ++degree;
+    }
+    // Нужны v_0..v_{degree+n-2}, это не больше 64 битов.
+    uint64_t sequence = 0;
+    for (uint8_t m = 0; m < n; ++m)
+        sequence |= (uint64_t)((cursor->state >> (n - 1 - m)) & 1) << m;
+    for (uint8_t m = n; m + 1 < degree + n; ++m) {
+        uint64_t window = 0;
+        for (uint8_t i = 0; i < n; ++i) window |= ((sequence >> (m - 1 - i)) & 1) << i;
+        sequence |= (uint64_t)(c ^ __builtin_parityll(window & b)) << m;
+    }
+    // v_{steps+j} = sum r_k v_{k+j}, где r = t^steps mod p, новое состояние - v_{steps..steps+n-1}.
+    const uint64_t r = powerOfTModulo(steps, p, degree);
+    uint32_t state = 0;
+    for (uint8_t i = 0; i < n; ++i)
+        state |= (uint32_t)__builtin_parityll(r & (sequence >> (n - 1 - i))) << i;
+    cursor->state = state;
+}
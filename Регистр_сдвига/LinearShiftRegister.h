@@ -0,0 +1,24 @@
+#ifndef LINEAR_SHIFT_REGISTER_H
+#define LINEAR_SHIFT_REGISTER_H
+
+#include "ShiftRegister.h"
+
+// Проверяет, аффинны ли phi и psi, и заполняет reg->linear.
+// Вызывается при загрузке регистра, стоимость - один проход по таблице.
+void detectLinearFeedback(struct ShiftRegister *reg);
+// Движок для регистров с аффинными функциями: вместо обращения к таблице
+// бит обратной связи и выход считаются как чётность state & маска.
+void useLinearShiftRegisterOnWords(
+    struct ShiftRegisterCursor *cursor,
+    const uint64_t *input,
+    uint64_t *output,
+    uint64_t num_of_bits
+);
+// Переводит курсор на steps тактов вперёд при постоянном входе x. Для аффинного
+// phi это O(n log steps) операций над словами: последовательность вдвигаемых битов
+// линейно рекуррентна, и её член с номером steps выражается через начальные
+// коэффициентами t^steps по модулю характеристического многочлена.
+// Для остальных регистров такты выполняются по одному.
+void jumpShiftRegister(struct ShiftRegisterCursor *cursor, uint8_t x, uint64_t steps);
+
+#endif
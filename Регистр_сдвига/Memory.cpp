@@ -27,16 +27,16 @@ void disableOldSetsDeletion() {
     delete_old_sets = false;
 }
 
-static IOSets<IOTuple, uint32_t> initIOSets(MinimalShiftRegister &reg) {
+static IOSets<IOTuple, uint32_t> initIOSets(const MinimalShiftRegister &reg) {
     IOSets<IOTuple, uint32_t> sets(1);
-    for (uint32_t state = 0; state <= static_cast<uint32_t>(reg.numStates() - 1); ++state)
+    for (uint32_t state = 0; state <= static_cast<uint32_t>(reg.getMinimizedWeight() - 1); ++state)
         for (bool x : {false, true})
             sets.insert(*ctxes[0], reg.stateFunction(state, x), IOTuple(x, reg.outputFunction(state, x)));
     return sets;
 }
 
 
-static IOSets<IOTuple, uint32_t> updateIOSets(IOSets<IOTuple, uint32_t> &sets, MinimalShiftRegister &reg) {
+static IOSets<IOTuple, uint32_t> updateIOSets(IOSets<IOTuple, uint32_t> &sets, const MinimalShiftRegister &reg) {
     IOSets<IOTuple, uint32_t> new_sets(sets.getMemorySize() + 1);
     std::vector<uint32_t> active_states(sets.getActualStates().begin(), sets.getActualStates().end());
 
@@ -114,11 +114,11 @@ static bool checkMemoryCriteria(IOSets<IOTuple, uint32_t> &sets) {
 }
 
 static uint64_t countMemory(
-    MinimalShiftRegister &reg,
+    const MinimalShiftRegister &reg,
     uint64_t upper_bound
 ) {
     uint64_t memory_size;
-    initConnections(reg.numStates());
+    initConnections(reg.getMinimizedWeight());
     IOSets sets = initIOSets(reg);
     for (memory_size = 1; memory_size <= upper_bound; ++memory_size) {
         std::cerr << "countMemory memory_size = " << memory_size << std::endl;
@@ -130,7 +130,7 @@ static uint64_t countMemory(
     return memory_size;
 }
 
-void getMemoryShiftRegister(MinimalShiftRegister &reg) {
+void getMemoryShiftRegister(const MinimalShiftRegister &reg) {
     uint64_t upper_bound = (reg.getMinimizedWeight() * (reg.getMinimizedWeight() - 1)) >> 1;
     uint64_t memory_size = upper_bound == 0 ? 0 : countMemory(reg, upper_bound);
     if (memory_size > upper_bound)
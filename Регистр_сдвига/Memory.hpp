@@ -4,6 +4,6 @@
 #include "MinimalShiftRegister.hpp"
 
 void disableOldSetsDeletion();
-void getMemoryShiftRegister(MinimalShiftRegister &reg);
+void getMemoryShiftRegister(const MinimalShiftRegister &reg);
 
 #endif
\ No newline at end of file
@@ -1,83 +1,42 @@
 #include "MinimalShiftRegister.hpp"
-#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
 
-DSU::DSU(size_t size) : parent(size), rank(size, 1) {
-    for (std::uint32_t i = 0; i <= static_cast<std::uint32_t>(size - 1); ++i) this->parent[i] = i;
-}
-
-std::uint32_t DSU::operator[](std::uint32_t i) {
-    if (this->parent[i] != i) this->parent[i] = (*this)[this->parent[i]];
-    return this->parent[i];
-}
-
-void DSU::operator()(std::uint32_t a, std::uint32_t b) {
-    a = (*this)[a];
-    b = (*this)[b];
-    if (a == b) return;
-    if (this->rank[a] < this->rank[b]) std::swap(a, b);
-    this->parent[b] = a;
-    if (this->rank[a] == this->rank[b]) ++rank[a];
-}
-
-void MinimalShiftRegister::transformDSUFromEquivalenceClass(List *equivalence_class) {
-    if (!getListSize(equivalence_class)) return;
-    struct ListIterator it;
-    setListIteratorNode(&it, getListHead(equivalence_class));
-    uint32_t class_leader = *static_cast<uint32_t *>(getListIteratorValue(&it));
-    do {
-        this->equivalence_classes(class_leader, *static_cast<uint32_t *>(getListIteratorValue(&it)));
-        incListIterator(&it);
-    } while (!compareListIteratorNode(&it, getListHead(equivalence_class)));
-}
-
-void MinimalShiftRegister::copyFunctions(struct ShiftRegister *reg) {
-    uint64_t funcs_size = static_cast<uint64_t>(1) << (reg->length + 1);
-    this->phi.resize(funcs_size);
-    this->psi.resize(funcs_size);
-    for (uint64_t i = 0; i < funcs_size; ++i) {
-        this->phi[i] = static_cast<bool>(getBitArrayElement(&reg->phi, i));
-        this->psi[i] = static_cast<bool>(getBitArrayElement(&reg->psi, i));
-    }
-}
-
-MinimalShiftRegister::MinimalShiftRegister(struct ShiftRegister *reg)
-    : equivalence_classes(static_cast<uint64_t>(1) << reg->length),
-    length(reg->length),  mask(reg->mask) {
+MinimalShiftRegister::MinimalShiftRegister(const struct ShiftRegister *reg) : length(reg->length) {
     struct Minimized minimized;
-    if (minimizeShiftRegister(&minimized, reg))
+    const unsigned num_of_threads = std::max(1u, std::thread::hardware_concurrency());
+    if (minimizeShiftRegisterInThreads(&minimized, reg, num_of_threads, MINIMIZE_CLASS_ARRAY))
         throw std::runtime_error("Ошибка при попытке минимизации регистра сдвига.");
-    if (!getListSize(minimized.equivalence_classes))
-        throw std::runtime_error("Список классов эквивалентности пустой."); 
-    struct ListIterator it;
-    setListIteratorNode(&it, getListHead(minimized.equivalence_classes));
-    do {
-        this->transformDSUFromEquivalenceClass(static_cast<List *>(getListIteratorValue(&it)));
-        incListIterator(&it);
-    } while (!compareListIteratorNode(&it, getListHead(minimized.equivalence_classes)));
     this->degree_of_distinguishability = minimized.degree_of_distinguishability;
-    this->minimized_weight = getListSize(minimized.equivalence_classes);
+    this->next.assign(minimized.num_of_classes << 1, 0);
+    this->outputs.assign(minimized.num_of_classes, 0);
+    // Эквивалентные состояния дают одни и те же записи, так что хватает одного прохода.
+    for (uint64_t state = 0; state < minimized.num_of_states; ++state) {
+        const std::uint32_t class_id = minimized.class_of[state];
+        const std::uint8_t transitions = getShiftRegisterTransitions(reg, state);
+        for (std::uint8_t x = 0; x < 2; ++x) {
+            const std::uint8_t phi = (transitions >> x) & 1;
+            this->next[(static_cast<uint64_t>(class_id) << 1) | x] =
+                minimized.class_of[((state << 1) | phi) & reg->mask];
+            this->outputs[class_id] |= getShiftRegisterOutput(transitions, x) << x;
+        }
+    }
     freeMinimized(&minimized);
-    this->copyFunctions(reg);
 }
 
-std::uint32_t MinimalShiftRegister::stateFunction(std::uint32_t state, bool x) {
-    state <<= 1;
-    return this->equivalence_classes[(state | phi[state | x]) & mask];
+std::uint32_t MinimalShiftRegister::stateFunction(std::uint32_t state, bool x) const {
+    return this->next[(static_cast<uint64_t>(state) << 1) | x];
 }
 
-bool MinimalShiftRegister::outputFunction(std::uint32_t state, bool x) {
-    state <<= 1;
-    return psi[state | phi[state | x]];
+bool MinimalShiftRegister::outputFunction(std::uint32_t state, bool x) const {
+    return (this->outputs[state] >> x) & 1;
 }
 
 uint8_t MinimalShiftRegister::getLength() const {
     return length;
 }
 
-uint64_t MinimalShiftRegister::numStates() const {
-    return static_cast<uint64_t>(1) << length;
-}
-
 uint64_t MinimalShiftRegister::getMinimizedWeight() const {
-    return this->minimized_weight;
-}
\ No newline at end of file
+    return this->next.size() >> 1;
+}
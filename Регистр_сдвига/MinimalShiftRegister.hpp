@@ -11,34 +11,21 @@ extern "C" {
     #undef class
 }
 
-class DSU {
-    private:
-        std::vector<std::uint32_t> parent, rank;
-    public:
-        DSU(size_t size);
-        std::uint32_t operator[](std::uint32_t i);
-        void operator()(std::uint32_t a, std::uint32_t b);
-};
-
 class MinimalShiftRegister {
 private:
-    DSU equivalence_classes;
-    std::vector<bool> phi;
-    std::vector<bool> psi;
+    // Фактор-автомат: состояния - классы эквивалентности 0..w-1 в порядке списка классов,
+    // next[(state << 1) | x] - класс следующего состояния, бит x outputs[state] - выход.
+    std::vector<std::uint32_t> next;
+    std::vector<std::uint8_t> outputs;
     uint8_t length;
-    std::uint32_t mask;
     uint64_t degree_of_distinguishability;
-    uint64_t minimized_weight;
-
-    void copyFunctions(struct ShiftRegister *reg);
-    void transformDSUFromEquivalenceClass(List *equivalence_class);
 public:
-    MinimalShiftRegister(struct ShiftRegister *reg);
-    std::uint32_t stateFunction(std::uint32_t state, bool x);
-    bool outputFunction(std::uint32_t state, bool x);
+    MinimalShiftRegister(const struct ShiftRegister *reg);
+    // state - класс. Таблицы только читаются, так что вызывать можно из нескольких потоков.
+    std::uint32_t stateFunction(std::uint32_t state, bool x) const;
+    bool outputFunction(std::uint32_t state, bool x) const;
+    // Длина оригинального регистра.
     uint8_t getLength() const;
-    // Количество значений оригинального регистра.
-    uint64_t numStates() const;
     uint64_t getMinimizedWeight() const;
 };
 
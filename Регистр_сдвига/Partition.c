@@ -0,0 +1,1465 @@
+#include "Partition.h"
+#include "StateGraph.h"
+#include "Alloc.h"
+#include <inttypes.h>
+#include <stdlib.h>
+
+// Куски, на которые делится работа шага между потоками.
+#define PARTITION_CHUNK_STATES ((uint64_t)1 << 14)
+// Классы, в сумме не больше этого, обрабатываются вместе, каждый в одном потоке.
+// Класс больше сортируется сам, по блокам в разных потоках.
+#define PARTITION_BATCH_STATES ((uint64_t)1 << 20)
+#define BLOCKS_PER_THREAD 4
+#define RADIX_BITS 8
+#define RADIX_DIGITS (1 << RADIX_BITS)
+// Короткие классы быстрее отсортировать qsort.
+#define RADIX_MIN_SIZE 256
+
+// Непрерывный кусок states (класс или его часть) и его место offset в общем массиве
+// ключей. record - смещение записи о частях в pieces, count - число частей.
+struct StateSegment {
+    uint64_t offset;
+    uint64_t record;
+    uint32_t first;
+    uint32_t size;
+    uint32_t id;
+    uint32_t count;
+};
+
+typedef void (*PartitionJob)(void *context, uint64_t begin, uint64_t end);
+
+struct PartitionRun {
+    PartitionJob job;
+    void *context;
+    uint64_t size;
+    uint64_t grain;
+    uint64_t next;
+};
+
+static void *runPartitionJob(void *arg) {
+    struct PartitionRun *run = arg;
+    uint64_t begin;
+    while ((begin = __atomic_fetch_add(&run->next, run->grain, __ATOMIC_RELAXED)) < run->size)
+        run->job(run->context, begin, run->size - begin < run->grain ? run->size : begin + run->grain);
+    return NULL;
+}
+
+// Выполняет job над [0, size) кусками по grain, куски разбирают потоки partition.
+// Если поток не создаётся, его куски достаются остальным.
+static void runInParallel(
+    struct StatePartition *partition, uint64_t size, uint64_t grain, PartitionJob job, void *context
+) {
+    struct PartitionRun run = {job, context, size, grain, 0};
+    uint64_t num_of_threads = (size + grain - 1) / grain;
+    if (num_of_threads > partition->num_of_threads) num_of_threads = partition->num_of_threads;
+    unsigned started = 1;
+    for (; started < num_of_threads; ++started)
+        if (pthread_create(&partition->threads[started], NULL, runPartitionJob, &run)) break;
+    runPartitionJob(&run);
+    for (unsigned i = 1; i < started; ++i) pthread_join(partition->threads[i], NULL);
+}
+
+// Последние два массива (дерево разбиений) выделяет только minimizeStatePartition.
+#define NUM_OF_STATE_ARRAYS 9
+#define NUM_OF_TREE_ARRAYS 2
+
+static void getStateArrays(struct StatePartition *partition, uint32_t **arrays[NUM_OF_STATE_ARRAYS]) {
+    arrays[0] = &partition->class_of;
+    arrays[1] = &partition->states;
+    arrays[2] = &partition->first;
+    arrays[3] = &partition->size;
+    arrays[4] = &partition->order;
+    arrays[5] = &partition->position;
+    arrays[6] = &partition->pending;
+    arrays[7] = &partition->parent;
+    arrays[8] = &partition->born;
+}
+
+static int allocStatePartition(struct StatePartition *partition, uint64_t num_of_states, unsigned num_of_threads) {
+    memset(partition, 0, sizeof(struct StatePartition));
+    partition->num_of_states = num_of_states;
+    partition->num_of_threads = num_of_threads ? num_of_threads : 1;
+    if (!(partition->threads = malloc(partition->num_of_threads * sizeof(pthread_t)))) return -1;
+    uint32_t **arrays[NUM_OF_STATE_ARRAYS];
+    getStateArrays(partition, arrays);
+    for (int i = 0; i < NUM_OF_STATE_ARRAYS - NUM_OF_TREE_ARRAYS; ++i)
+        if (!(*arrays[i] = allocLarge(num_of_states * sizeof(uint32_t), &partition->kinds[i]))) {
+            freeStatePartition(partition);
+            return -1;
+        }
+    if (!(partition->is_pending = allocLarge(num_of_states, &partition->kinds[NUM_OF_STATE_ARRAYS]))) {
+        freeStatePartition(partition);
+        return -1;
+    }
+    return 0;
+}
+
+void freeStatePartition(struct StatePartition *partition) {
+    uint32_t **arrays[NUM_OF_STATE_ARRAYS];
+    getStateArrays(partition, arrays);
+    for (int i = 0; i < NUM_OF_STATE_ARRAYS; ++i) {
+        if (*arrays[i]) freeLarge(*arrays[i], partition->num_of_states * sizeof(uint32_t), partition->kinds[i]);
+        *arrays[i] = NULL;
+    }
+    if (partition->is_pending) freeLarge(partition->is_pending, partition->num_of_states, partition->kinds[NUM_OF_STATE_ARRAYS]);
+    partition->is_pending = NULL;
+    free(partition->threads);
+    free(partition->keys);
+    free(partition->sorted);
+    free(partition->segments);
+    free(partition->counts);
+    free(partition->pieces);
+    partition->threads = NULL;
+    partition->keys = partition->sorted = NULL;
+    partition->segments = NULL;
+    partition->counts = NULL;
+    partition->pieces = NULL;
+}
+
+static int reserve(void **buffer, uint64_t *capacity, uint64_t size, size_t element_size) {
+    if (size <= *capacity) return 0;
+    uint64_t new_capacity = *capacity ? *capacity : 64;
+    while (new_capacity < size) new_capacity <<= 1;
+    void *new_buffer = realloc(*buffer, new_capacity * element_size);
+    if (!new_buffer) return -1;
+    *buffer = new_buffer;
+    *capacity = new_capacity;
+    return 0;
+}
+
+static int reserveKeys(struct StatePartition *partition, uint64_t size) {
+    uint64_t capacity = partition->keys_capacity;
+    if (reserve((void **)&partition->keys, &capacity, size, sizeof(struct StateKey))) return -1;
+    return reserve((void **)&partition->sorted, &partition->keys_capacity, size, sizeof(struct StateKey));
+}
+
+struct OutputStep {
+    struct StatePartition *partition;
+    const struct ShiftRegister *reg;
+    // По 4 счётчика на кусок: сначала число состояний с данными выходами, затем
+    // место первого из них в states.
+    uint64_t *counts;
+    uint32_t class_of_outputs[4];
+};
+
+// Выходы 16 состояний слова перемежённой таблицы (младший полубайт - младшее
+// состояние): в полубайте (выход при x = 0) * 2 + выход при x = 1.
+static inline uint64_t getOutputNibbles(uint64_t word) {
+    const uint64_t ones = 0x1111111111111111ULL;
+    const uint64_t phi_0 = word & ones, phi_1 = (word >> 1) & ones;
+    const uint64_t psi_0 = (word >> 2) & ones, psi_1 = (word >> 3) & ones;
+    return ((psi_0 & ~phi_0) | (psi_1 & phi_0)) << 1 | (psi_0 & ~phi_1) | (psi_1 & phi_1);
+}
+
+static void countOutputs(void *context, uint64_t begin, uint64_t end) {
+    struct OutputStep *step = context;
+    const struct ShiftRegister *reg = step->reg;
+    uint32_t *class_of = step->partition->class_of;
+    for (uint64_t chunk = begin; chunk < end; ++chunk) {
+        uint64_t *counts = step->counts + 4 * chunk;
+        memset(counts, 0, 4 * sizeof(uint64_t));
+        uint64_t state = chunk * PARTITION_CHUNK_STATES;
+        const uint64_t last = step->partition->num_of_states - state < PARTITION_CHUNK_STATES ?
+            step->partition->num_of_states : state + PARTITION_CHUNK_STATES;
+        if (reg->transitions.bucket)
+            for (; state + 16 <= last; state += 16) {
+                uint64_t word;
+                memcpy(&word, reg->transitions.bucket + (state >> 1), sizeof(word));
+                word = getOutputNibbles(word);
+                for (unsigned i = 0; i < 16; ++i) {
+                    const uint8_t outputs = (word >> (i << 2)) & 3;
+                    class_of[state + i] = outputs;
+                    ++counts[outputs];
+                }
+            }
+        for (; state < last; ++state) {
+            const uint8_t outputs = getShiftRegisterOutputs(getShiftRegisterTransitions(reg, state));
+            class_of[state] = outputs;
+            ++counts[outputs];
+        }
+    }
+}
+
+static void placeOutputs(void *context, uint64_t begin, uint64_t end) {
+    struct OutputStep *step = context;
+    struct StatePartition *partition = step->partition;
+    for (uint64_t chunk = begin; chunk < end; ++chunk) {
+        uint64_t *counts = step->counts + 4 * chunk;
+        const uint64_t first = chunk * PARTITION_CHUNK_STATES;
+        const uint64_t last = partition->num_of_states - first < PARTITION_CHUNK_STATES ?
+            partition->num_of_states : first + PARTITION_CHUNK_STATES;
+        for (uint64_t state = first; state < last; ++state) {
+            const uint32_t outputs = partition->class_of[state];
+            partition->class_of[state] = step->class_of_outputs[outputs];
+            partition->states[counts[outputs]++] = (uint32_t)state;
+        }
+    }
+}
+
+int initOutputPartition(struct StatePartition *partition, const struct ShiftRegister *reg, unsigned num_of_threads) {
+    if (reg->length > PARTITION_MAX_LENGTH) return -2;
+    const uint64_t num_of_states = (uint64_t)1 << reg->length;
+    if (allocStatePartition(partition, num_of_states, num_of_threads)) return -1;
+    const uint64_t num_of_chunks = (num_of_states + PARTITION_CHUNK_STATES - 1) / PARTITION_CHUNK_STATES;
+    if (reserve((void **)&partition->counts, &partition->counts_capacity, 4 * num_of_chunks, sizeof(uint64_t))) {
+        freeStatePartition(partition);
+        return -1;
+    }
+    struct OutputStep step = {.partition = partition, .reg = reg, .counts = partition->counts};
+    runInParallel(partition, num_of_chunks, 1, countOutputs, &step);
+    // Номер первого шага - (выход при x = 0) * 2 + выход при x = 1, пустые пропускаются.
+    memset(partition->output_classes, 0xFF, sizeof(partition->output_classes));
+    uint64_t next = 0;
+    for (uint8_t outputs = 0; outputs < 4; ++outputs) {
+        uint64_t total = 0;
+        for (uint64_t chunk = 0; chunk < num_of_chunks; ++chunk) total += step.counts[4 * chunk + outputs];
+        if (!total) continue;
+        const uint32_t id = (uint32_t)partition->num_of_classes++;
+        step.class_of_outputs[outputs] = id;
+        partition->output_classes[outputs] = id;
+        partition->first[id] = (uint32_t)next;
+        partition->size[id] = (uint32_t)total;
+        partition->order[id] = partition->position[id] = id;
+        partition->pending[id] = id;
+        partition->is_pending[id] = 1;
+        for (uint64_t chunk = 0; chunk < num_of_chunks; ++chunk) {
+            const uint64_t count = step.counts[4 * chunk + outputs];
+            step.counts[4 * chunk + outputs] = next;
+            next += count;
+        }
+    }
+    partition->num_of_pending = partition->num_of_classes;
+    runInParallel(partition, num_of_chunks, 1, placeOutputs, &step);
+    return 0;
+}
+
+static int compareStateKeys(const void *a, const void *b) {
+    const struct StateKey *first = a, *second = b;
+    if (first->key != second->key) return first->key < second->key ? -1 : 1;
+    return (first->state > second->state) - (first->state < second->state);
+}
+
+// Сортировка ключей одного класса. Блоки [b * block_size, (b + 1) * block_size)
+// обрабатываются независимо - в потоках partition или, если partition = NULL, в
+// вызывающем. counts - по RADIX_DIGITS счётчиков на блок.
+struct ClassSort {
+    struct StatePartition *partition;
+    struct StateKey *keys;
+    struct StateKey *buffer;
+    uint64_t size;
+    uint64_t block_size;
+    uint64_t num_of_blocks;
+    uint64_t *counts;
+    uint64_t min;
+    uint8_t shift;
+    uint32_t *ends;
+};
+
+static void runOnBlocks(struct ClassSort *sort, PartitionJob job) {
+    if (sort->partition) runInParallel(sort->partition, sort->num_of_blocks, 1, job, sort);
+    else job(sort, 0, sort->num_of_blocks);
+}
+
+static inline uint64_t getBlockEnd(const struct ClassSort *sort, uint64_t block) {
+    return sort->size - block * sort->block_size < sort->block_size ? sort->size : (block + 1) * sort->block_size;
+}
+
+static void findKeyRange(void *context, uint64_t begin, uint64_t end) {
+    struct ClassSort *sort = context;
+    for (uint64_t block = begin; block < end; ++block) {
+        uint64_t min = UINT64_MAX, max = 0;
+        for (uint64_t i = block * sort->block_size; i < getBlockEnd(sort, block); ++i) {
+            if (sort->keys[i].key < min) min = sort->keys[i].key;
+            if (sort->keys[i].key > max) max = sort->keys[i].key;
+        }
+        sort->counts[block * RADIX_DIGITS] = min;
+        sort->counts[block * RADIX_DIGITS + 1] = max;
+    }
+}
+
+static inline uint8_t getDigit(const struct ClassSort *sort, uint64_t key) {
+    return (uint8_t)(((key - sort->min) >> sort->shift) & (RADIX_DIGITS - 1));
+}
+
+static void countDigits(void *context, uint64_t begin, uint64_t end) {
+    struct ClassSort *sort = context;
+    for (uint64_t block = begin; block < end; ++block) {
+        uint64_t *counts = sort->counts + block * RADIX_DIGITS;
+        memset(counts, 0, RADIX_DIGITS * sizeof(uint64_t));
+        for (uint64_t i = block * sort->block_size; i < getBlockEnd(sort, block); ++i)
+            ++counts[getDigit(sort, sort->keys[i].key)];
+    }
+}
+
+static void scatterDigits(void *context, uint64_t begin, uint64_t end) {
+    struct ClassSort *sort = context;
+    for (uint64_t block = begin; block < end; ++block) {
+        uint64_t *counts = sort->counts + block * RADIX_DIGITS;
+        for (uint64_t i = block * sort->block_size; i < getBlockEnd(sort, block); ++i)
+            sort->buffer[counts[getDigit(sort, sort->keys[i].key)]++] = sort->keys[i];
+    }
+}
+
+static void copyKeys(void *context, uint64_t begin, uint64_t end) {
+    struct ClassSort *sort = context;
+    for (uint64_t block = begin; block < end; ++block)
+        memcpy(
+            sort->keys + block * sort->block_size, sort->buffer + block * sort->block_size,
+            (getBlockEnd(sort, block) - block * sort->block_size) * sizeof(struct StateKey)
+        );
+}
+
+static inline uint8_t isPieceEnd(const struct ClassSort *sort, uint64_t i) {
+    return i + 1 == sort->size || sort->keys[i + 1].key != sort->keys[i].key;
+}
+
+static void countPieces(void *context, uint64_t begin, uint64_t end) {
+    struct ClassSort *sort = context;
+    for (uint64_t block = begin; block < end; ++block) {
+        uint64_t count = 0;
+        for (uint64_t i = block * sort->block_size; i < getBlockEnd(sort, block); ++i) count += isPieceEnd(sort, i);
+        sort->counts[block * RADIX_DIGITS] = count;
+    }
+}
+
+static void writePieceEnds(void *context, uint64_t begin, uint64_t end) {
+    struct ClassSort *sort = context;
+    for (uint64_t block = begin; block < end; ++block) {
+        uint32_t *ends = sort->ends + sort->counts[block * RADIX_DIGITS];
+        for (uint64_t i = block * sort->block_size; i < getBlockEnd(sort, block); ++i)
+            if (isPieceEnd(sort, i)) *ends++ = (uint32_t)(i + 1);
+    }
+}
+
+// Сортирует ключи по key, равные остаются по возрастанию state, как и шли. Возвращает
+// число частей - групп равных ключей; counts блоков после этого - номер первой части
+// блока (для writePieceEnds).
+static uint32_t sortClass(struct ClassSort *sort) {
+    runOnBlocks(sort, findKeyRange);
+    uint64_t min = UINT64_MAX, max = 0;
+    for (uint64_t block = 0; block < sort->num_of_blocks; ++block) {
+        if (sort->counts[block * RADIX_DIGITS] < min) min = sort->counts[block * RADIX_DIGITS];
+        if (sort->counts[block * RADIX_DIGITS + 1] > max) max = sort->counts[block * RADIX_DIGITS + 1];
+    }
+    if (min == max) return 1;
+    if (sort->size < RADIX_MIN_SIZE) qsort(sort->keys, sort->size, sizeof(struct StateKey), compareStateKeys);
+    else {
+        struct StateKey *keys = sort->keys;
+        sort->min = min;
+        for (sort->shift = 0; sort->shift < 64 && (max - min) >> sort->shift; sort->shift += RADIX_BITS) {
+            runOnBlocks(sort, countDigits);
+            uint64_t next = 0;
+            for (unsigned digit = 0; digit < RADIX_DIGITS; ++digit)
+                for (uint64_t block = 0; block < sort->num_of_blocks; ++block) {
+                    const uint64_t count = sort->counts[block * RADIX_DIGITS + digit];
+                    sort->counts[block * RADIX_DIGITS + digit] = next;
+                    next += count;
+                }
+            runOnBlocks(sort, scatterDigits);
+            struct StateKey *swap = sort->keys;
+            sort->keys = sort->buffer;
+            sort->buffer = swap;
+        }
+        if (sort->keys != keys) {
+            sort->buffer = sort->keys;
+            sort->keys = keys;
+            runOnBlocks(sort, copyKeys);
+        }
+    }
+    runOnBlocks(sort, countPieces);
+    uint64_t count = 0;
+    for (uint64_t block = 0; block < sort->num_of_blocks; ++block) {
+        const uint64_t block_count = sort->counts[block * RADIX_DIGITS];
+        sort->counts[block * RADIX_DIGITS] = count;
+        count += block_count;
+    }
+    return (uint32_t)count;
+}
+
+// Шаг над списком кусков segments, ключи которых лежат в partition->keys подряд.
+struct RefineStep {
+    struct StatePartition *partition;
+    const struct ShiftRegister *reg;
+    struct StateSegment *segments;
+    uint64_t num_of_segments;
+};
+
+static uint64_t findSegment(const struct RefineStep *step, uint64_t index) {
+    uint64_t low = 0, high = step->num_of_segments;
+    while (high - low > 1) {
+        const uint64_t middle = (low + high) >> 1;
+        if (step->segments[middle].offset <= index) low = middle;
+        else high = middle;
+    }
+    return low;
+}
+
+static void initSegmentSort(
+    struct ClassSort *sort, const struct RefineStep *step, const struct StateSegment *segment, uint64_t *counts
+) {
+    memset(sort, 0, sizeof(struct ClassSort));
+    sort->keys = step->partition->keys + segment->offset;
+    sort->buffer = step->partition->sorted + segment->offset;
+    sort->size = sort->block_size = segment->size;
+    sort->num_of_blocks = 1;
+    sort->counts = counts;
+}
+
+// Ключ состояния - пара позиций классов следующих состояний.
+static void computeKeys(void *context, uint64_t begin, uint64_t end) {
+    struct RefineStep *step = context;
+    struct StatePartition *partition = step->partition;
+    const struct ShiftRegister *reg = step->reg;
+    for (uint64_t s = findSegment(step, begin); begin < end; ++s) {
+        const struct StateSegment *segment = step->segments + s;
+        const uint64_t last = segment->offset + segment->size < end ? segment->offset + segment->size : end;
+        for (; begin < last; ++begin) {
+            const uint32_t state = partition->states[segment->first + (begin - segment->offset)];
+            const uint8_t transitions = getShiftRegisterTransitions(reg, state);
+            const uint32_t next_0 = (uint32_t)((((uint64_t)state << 1) | (transitions & 1)) & reg->mask);
+            const uint32_t next_1 = (uint32_t)((((uint64_t)state << 1) | ((transitions >> 1) & 1)) & reg->mask);
+            partition->keys[begin].key =
+                partition->position[partition->class_of[next_0]] * partition->num_of_classes +
+                partition->position[partition->class_of[next_1]];
+            partition->keys[begin].state = state;
+        }
+    }
+}
+
+static void sortSegments(void *context, uint64_t begin, uint64_t end) {
+    struct RefineStep *step = context;
+    for (uint64_t s = begin; s < end; ++s) {
+        uint64_t counts[RADIX_DIGITS];
+        struct ClassSort sort;
+        initSegmentSort(&sort, step, step->segments + s, counts);
+        step->segments[s].count = sortClass(&sort);
+    }
+}
+
+static void writeSegmentEnds(void *context, uint64_t begin, uint64_t end) {
+    struct RefineStep *step = context;
+    for (uint64_t s = begin; s < end; ++s) {
+        const struct StateSegment *segment = step->segments + s;
+        if (segment->count < 2) continue;
+        uint64_t counts[RADIX_DIGITS] = {0};
+        struct ClassSort sort;
+        initSegmentSort(&sort, step, segment, counts);
+        sort.ends = step->partition->pieces + segment->record + 2;
+        writePieceEnds(&sort, 0, 1);
+    }
+}
+
+static void writeSegmentStates(void *context, uint64_t begin, uint64_t end) {
+    struct RefineStep *step = context;
+    struct StatePartition *partition = step->partition;
+    for (uint64_t s = findSegment(step, begin); begin < end; ++s) {
+        const struct StateSegment *segment = step->segments + s;
+        const uint64_t last = segment->offset + segment->size < end ? segment->offset + segment->size : end;
+        if (segment->count < 2) {
+            begin = last;
+            continue;
+        }
+        for (; begin < last; ++begin)
+            partition->states[segment->first + (begin - segment->offset)] = partition->keys[begin].state;
+    }
+}
+
+// Сортирует классы из segments по ключам. Для каждого разделившегося класса в
+// pieces дописывается запись [id, число частей, номера частей по возрастанию ключа];
+// номер id остаётся у самой большой части, остальные получают номера с *next_id.
+// class_of, position и num_of_classes не меняются, так что ключи остальных классов
+// этого шага считаются по старому разбиению.
+static int splitSegments(
+    struct RefineStep *step, uint64_t num_of_states, uint64_t *next_id, uint64_t *num_of_pieces
+) {
+    struct StatePartition *partition = step->partition;
+    runInParallel(partition, num_of_states, PARTITION_CHUNK_STATES, computeKeys, step);
+    struct ClassSort sort;
+    const uint8_t single = num_of_states > PARTITION_BATCH_STATES;
+    if (single) {
+        // Один большой класс: блоки сортируются в разных потоках.
+        uint64_t num_of_blocks = (uint64_t)partition->num_of_threads * BLOCKS_PER_THREAD;
+        if (num_of_blocks > num_of_states / PARTITION_CHUNK_STATES) num_of_blocks = num_of_states / PARTITION_CHUNK_STATES;
+        if (reserve(
+            (void **)&partition->counts, &partition->counts_capacity, num_of_blocks * RADIX_DIGITS, sizeof(uint64_t)
+        )) return -1;
+        initSegmentSort(&sort, step, step->segments, partition->counts);
+        sort.partition = partition;
+        sort.block_size = (num_of_states + num_of_blocks - 1) / num_of_blocks;
+        sort.num_of_blocks = (num_of_states + sort.block_size - 1) / sort.block_size;
+        step->segments[0].count = sortClass(&sort);
+    } else runInParallel(partition, step->num_of_segments, 16, sortSegments, step);
+    uint64_t size = *num_of_pieces;
+    for (uint64_t s = 0; s < step->num_of_segments; ++s) {
+        if (step->segments[s].count < 2) continue;
+        step->segments[s].record = size;
+        size += 2 + step->segments[s].count;
+    }
+    if (size == *num_of_pieces) return 0;
+    if (reserve((void **)&partition->pieces, &partition->pieces_capacity, size, sizeof(uint32_t))) return -1;
+    *num_of_pieces = size;
+    if (single) {
+        sort.ends = partition->pieces + step->segments[0].record + 2;
+        runOnBlocks(&sort, writePieceEnds);
+    } else runInParallel(partition, step->num_of_segments, 16, writeSegmentEnds, step);
+    for (uint64_t s = 0; s < step->num_of_segments; ++s) {
+        const struct StateSegment *segment = step->segments + s;
+        if (segment->count < 2) continue;
+        uint32_t *record = partition->pieces + segment->record;
+        uint32_t largest = 0, largest_size = 0, start = 0;
+        for (uint32_t piece = 0; piece < segment->count; ++piece) {
+            if (record[2 + piece] - start > largest_size) {
+                largest_size = record[2 + piece] - start;
+                largest = piece;
+            }
+            start = record[2 + piece];
+        }
+        record[0] = segment->id;
+        record[1] = segment->count;
+        start = 0;
+        for (uint32_t piece = 0; piece < segment->count; ++piece) {
+            uint32_t piece_id = segment->id;
+            if (piece != largest) {
+                piece_id = (uint32_t)(*next_id)++;
+                if (partition->parent) {
+                    partition->parent[piece_id] = segment->id;
+                    partition->born[piece_id] = (uint32_t)partition->num_of_rounds;
+                }
+            }
+            partition->first[piece_id] = segment->first + start;
+            partition->size[piece_id] = record[2 + piece] - start;
+            start = record[2 + piece];
+            record[2 + piece] = piece_id;
+        }
+    }
+    runInParallel(partition, num_of_states, PARTITION_CHUNK_STATES, writeSegmentStates, step);
+    return 0;
+}
+
+static void updatePositions(void *context, uint64_t begin, uint64_t end) {
+    struct StatePartition *partition = context;
+    for (uint64_t i = begin; i < end; ++i) partition->position[partition->order[i]] = (uint32_t)i;
+}
+
+static void updateClasses(void *context, uint64_t begin, uint64_t end) {
+    struct RefineStep *step = context;
+    struct StatePartition *partition = step->partition;
+    for (uint64_t s = findSegment(step, begin); begin < end; ++s) {
+        const struct StateSegment *segment = step->segments + s;
+        const uint64_t last = segment->offset + segment->size < end ? segment->offset + segment->size : end;
+        for (; begin < last; ++begin)
+            partition->class_of[partition->states[segment->first + (begin - segment->offset)]] = segment->id;
+    }
+}
+
+static void markPredecessors(void *context, uint64_t begin, uint64_t end) {
+    struct RefineStep *step = context;
+    struct StatePartition *partition = step->partition;
+    for (uint64_t s = findSegment(step, begin); begin < end; ++s) {
+        const struct StateSegment *segment = step->segments + s;
+        const uint64_t last = segment->offset + segment->size < end ? segment->offset + segment->size : end;
+        for (; begin < last; ++begin) {
+            uint32_t predecessors[2];
+            const uint8_t count = getShiftRegisterPredecessors(
+                step->reg, partition->states[segment->first + (begin - segment->offset)], predecessors
+            );
+            for (uint8_t j = 0; j < count; ++j) {
+                uint8_t *is_pending = partition->is_pending + partition->class_of[predecessors[j]];
+                if (!__atomic_load_n(is_pending, __ATOMIC_RELAXED)) __atomic_store_n(is_pending, 1, __ATOMIC_RELAXED);
+            }
+        }
+    }
+}
+
+// Отмеченные в is_pending классы куска (по PARTITION_CHUNK_STATES номеров) - сначала
+// их число, затем они сами, в pending с места из counts.
+static void scanPending(struct StatePartition *partition, uint64_t chunk, uint8_t write) {
+    const uint64_t first = chunk * PARTITION_CHUNK_STATES;
+    const uint64_t last = partition->num_of_classes - first < PARTITION_CHUNK_STATES ?
+        partition->num_of_classes : first + PARTITION_CHUNK_STATES;
+    uint64_t count = write ? partition->counts[chunk] : 0;
+    for (uint64_t id = first; id < last;) {
+        uint64_t word;
+        if (last - id >= sizeof(word)) {
+            memcpy(&word, partition->is_pending + id, sizeof(word));
+            if (!word) {
+                id += sizeof(word);
+                continue;
+            }
+        }
+        if (partition->is_pending[id]) {
+            if (write) partition->pending[count] = (uint32_t)id;
+            ++count;
+        }
+        ++id;
+    }
+    partition->counts[chunk] = count;
+}
+
+static void countPending(void *context, uint64_t begin, uint64_t end) {
+    for (uint64_t chunk = begin; chunk < end; ++chunk) scanPending(context, chunk, 0);
+}
+
+static void writePending(void *context, uint64_t begin, uint64_t end) {
+    for (uint64_t chunk = begin; chunk < end; ++chunk) scanPending(context, chunk, 1);
+}
+
+static int collectPending(struct StatePartition *partition) {
+    const uint64_t num_of_chunks = (partition->num_of_classes + PARTITION_CHUNK_STATES - 1) / PARTITION_CHUNK_STATES;
+    if (reserve((void **)&partition->counts, &partition->counts_capacity, num_of_chunks, sizeof(uint64_t))) return -1;
+    runInParallel(partition, num_of_chunks, 1, countPending, partition);
+    uint64_t next = 0;
+    for (uint64_t chunk = 0; chunk < num_of_chunks; ++chunk) {
+        const uint64_t count = partition->counts[chunk];
+        partition->counts[chunk] = next;
+        next += count;
+    }
+    runInParallel(partition, num_of_chunks, 1, writePending, partition);
+    partition->num_of_pending = next;
+    return 0;
+}
+
+int64_t refineStatePartition(struct StatePartition *partition, const struct ShiftRegister *reg) {
+    const uint64_t old_num_of_classes = partition->num_of_classes;
+    uint64_t next_id = old_num_of_classes, num_of_pieces = 0;
+    struct RefineStep step = {.partition = partition, .reg = reg};
+    ++partition->num_of_rounds;
+    // Классы из pending разбиваются пачками не больше PARTITION_BATCH_STATES состояний
+    // (или по одному, если класс больше).
+    for (uint64_t i = 0; i < partition->num_of_pending;) {
+        uint64_t num_of_states = 0;
+        step.num_of_segments = 0;
+        for (; i < partition->num_of_pending; ++i) {
+            const uint32_t id = partition->pending[i], size = partition->size[id];
+            if (step.num_of_segments && num_of_states + size > PARTITION_BATCH_STATES) break;
+            partition->is_pending[id] = 0;
+            if (size == 1) continue;
+            if (reserve(
+                (void **)&partition->segments, &partition->segments_capacity,
+                step.num_of_segments + 1, sizeof(struct StateSegment)
+            )) return -1;
+            partition->segments[step.num_of_segments++] = (struct StateSegment){
+                .offset = num_of_states, .first = partition->first[id], .size = size, .id = id, .count = 1
+            };
+            num_of_states += size;
+            if (num_of_states > PARTITION_BATCH_STATES) {
+                ++i;
+                break;
+            }
+        }
+        if (!step.num_of_segments) continue;
+        step.segments = partition->segments;
+        if (reserveKeys(partition, num_of_states)) return -1;
+        if (splitSegments(&step, num_of_states, &next_id, &num_of_pieces)) return -1;
+    }
+    partition->num_of_pending = 0;
+    partition->num_of_classes = next_id;
+    const uint64_t added = next_id - old_num_of_classes;
+    if (!added) return 0;
+    // Разделившиеся классы помечаются смещением их записи в pieces.
+    for (uint64_t offset = 0; offset < num_of_pieces; offset += 2 + partition->pieces[offset + 1]) {
+        partition->is_pending[partition->pieces[offset]] = 1;
+        partition->position[partition->pieces[offset]] = (uint32_t)offset;
+    }
+    // Новый порядок: части - на месте своего класса. Запись идёт с конца, так что
+    // order расширяется на месте.
+    uint64_t write = partition->num_of_classes;
+    for (uint64_t read = old_num_of_classes; read-- > 0;) {
+        const uint32_t id = partition->order[read];
+        if (!partition->is_pending[id]) {
+            partition->order[--write] = id;
+            continue;
+        }
+        partition->is_pending[id] = 0;
+        const uint32_t *record = partition->pieces + partition->position[id];
+        for (uint32_t piece = record[1]; piece-- > 0;) partition->order[--write] = record[2 + piece];
+    }
+    runInParallel(partition, partition->num_of_classes, PARTITION_CHUNK_STATES, updatePositions, partition);
+    // Состояния новых частей получают их номера, после чего их предшественники
+    // попадают в pending.
+    uint64_t num_of_states = 0;
+    step.num_of_segments = 0;
+    for (uint64_t offset = 0; offset < num_of_pieces; offset += 2 + partition->pieces[offset + 1]) {
+        const uint32_t *record = partition->pieces + offset;
+        for (uint32_t piece = 0; piece < record[1]; ++piece) {
+            const uint32_t piece_id = record[2 + piece];
+            if (piece_id == record[0]) continue;
+            if (reserve(
+                (void **)&partition->segments, &partition->segments_capacity,
+                step.num_of_segments + 1, sizeof(struct StateSegment)
+            )) return -1;
+            partition->segments[step.num_of_segments++] = (struct StateSegment){
+                .offset = num_of_states, .first = partition->first[piece_id],
+                .size = partition->size[piece_id], .id = piece_id
+            };
+            num_of_states += partition->size[piece_id];
+        }
+    }
+    step.segments = partition->segments;
+    runInParallel(partition, num_of_states, PARTITION_CHUNK_STATES, updateClasses, &step);
+    runInParallel(partition, num_of_states, PARTITION_CHUNK_STATES, markPredecessors, &step);
+    if (collectPending(partition)) return -1;
+    return (int64_t)added;
+}
+
+int minimizeStatePartition(struct StatePartition *partition, const struct ShiftRegister *reg, unsigned num_of_threads) {
+    if (initOutputPartition(partition, reg, num_of_threads)) return -1;
+    if (
+        !(partition->parent = allocLarge(partition->num_of_states * sizeof(uint32_t), &partition->kinds[7])) ||
+        !(partition->born = allocLarge(partition->num_of_states * sizeof(uint32_t), &partition->kinds[8]))
+    ) {
+        freeStatePartition(partition);
+        return -1;
+    }
+    for (uint64_t id = 0; id < partition->num_of_classes; ++id) {
+        partition->parent[id] = (uint32_t)id;
+        partition->born[id] = 0;
+    }
+    if (partition->num_of_classes > 1)
+        for (int64_t added = 1; added;)
+            if ((added = refineStatePartition(partition, reg)) < 0) {
+                freeStatePartition(partition);
+                return -1;
+            }
+    // При одном классе его отметка с первого шага остаётся.
+    for (uint64_t i = 0; i < partition->num_of_pending; ++i) partition->is_pending[partition->pending[i]] = 0;
+    partition->num_of_pending = 0;
+    return 0;
+}
+
+uint64_t getStatePartitionDegree(const struct StatePartition *partition) {
+    if (partition->num_of_classes < 2) return 0;
+    uint32_t last = 0;
+    for (uint64_t id = 0; id < partition->num_of_classes; ++id)
+        if (partition->born[id] > last) last = partition->born[id];
+    return (uint64_t)last + 1;
+}
+
+#define NO_NODE UINT32_MAX
+
+// Узел дерева разбиений на шаге level (класс после level шагов) ищется по узлу node
+// шага level - 1 и узлам next_0, next_1 следующих состояний на шаге level - 1.
+// Запись с next_0 = next_1 = NO_NODE отмечает, что старые узлы шага level под node
+// уже внесены в таблицу.
+struct NodeKey {
+    uint32_t node;
+    uint32_t level;
+    uint32_t next_0;
+    uint32_t next_1;
+};
+
+// value = NO_NODE - пустая ячейка.
+struct NodeEntry {
+    struct NodeKey key;
+    uint32_t value;
+};
+
+struct NodeTable {
+    struct NodeEntry *entries;
+    uint64_t capacity;
+    uint64_t size;
+};
+
+// Узел, которого не было в старом дереве. Номер - num_of_classes старого разбиения
+// плюс место в списке; level - последний шаг, на котором узел продолжен сам.
+struct NewNode {
+    uint32_t parent;
+    uint32_t born;
+    uint32_t level;
+    uint32_t size;
+};
+
+struct PartitionUpdate {
+    struct StatePartition *partition;
+    const struct ShiftRegister *reg;
+    uint64_t num_of_classes;
+    // Изменённые состояния по возрастанию с полубайтами до изменения.
+    struct TransitionChange *changed;
+    uint64_t num_of_changed;
+    // Затронутые состояния - изменённые, состояния, узел которых на каком-либо шаге
+    // отличается от старого, и их предшественники. Первыми идут изменённые. Место
+    // состояния в этом списке - в partition->pending, отметка - в partition->is_pending.
+    // Если затронутых становится больше limit, разбиение строится заново.
+    uint32_t *affected;
+    uint64_t num_of_affected;
+    uint64_t affected_capacity;
+    uint64_t limit;
+    // Узлы затронутых состояний на текущем шаге и на следующем.
+    uint32_t *node;
+    uint32_t *next_node;
+    // Отличается ли узел затронутого состояния от старого узла того же шага:
+    // бит 0 - на текущем шаге, бит 1 - на следующем.
+    uint8_t *differs;
+    // Пересчитанные на шаге состояния в виде (старый узел << 32) | место среди
+    // затронутых, старые узлы, в которые они попали, и число состояний в каждом из
+    // созданных на шаге новых узлов (см. keepOldNodes).
+    uint64_t *recomputed;
+    uint32_t *landed;
+    uint64_t recomputed_capacity;
+    uint32_t *arrivals;
+    uint64_t arrivals_capacity;
+    struct NewNode *new_nodes;
+    uint64_t num_of_new_nodes;
+    uint64_t new_nodes_capacity;
+    // Потомки узла id - children[child_first[id]] ... children[child_first[id + 1] - 1].
+    uint32_t *child_first;
+    uint32_t *children;
+    struct NodeTable table;
+};
+
+static inline uint64_t hashNodeKey(const struct NodeKey *key) {
+    uint64_t hash = ((uint64_t)key->node << 32 | key->level) * 0x9E3779B97F4A7C15ULL;
+    hash ^= ((uint64_t)key->next_0 << 32 | key->next_1) * 0xC2B2AE3D27D4EB4FULL;
+    return hash ^ (hash >> 29);
+}
+
+static struct NodeEntry *findNodeEntry(const struct NodeTable *table, const struct NodeKey *key) {
+    for (uint64_t i = hashNodeKey(key) & (table->capacity - 1);; i = (i + 1) & (table->capacity - 1)) {
+        struct NodeEntry *entry = table->entries + i;
+        if (entry->value == NO_NODE || !memcmp(&entry->key, key, sizeof(struct NodeKey))) return entry;
+    }
+}
+
+// Ячейка key: найденная или новая с value = NO_NODE. Указатель годен до следующего вызова.
+static struct NodeEntry *getNodeEntry(struct NodeTable *table, const struct NodeKey *key) {
+    if (2 * (table->size + 1) > table->capacity) {
+        struct NodeTable grown = {.capacity = table->capacity ? 2 * table->capacity : 1024, .size = table->size};
+        if (!(grown.entries = malloc(grown.capacity * sizeof(struct NodeEntry)))) return NULL;
+        memset(grown.entries, 0xFF, grown.capacity * sizeof(struct NodeEntry));
+        for (uint64_t i = 0; i < table->capacity; ++i)
+            if (table->entries[i].value != NO_NODE) *findNodeEntry(&grown, &table->entries[i].key) = table->entries[i];
+        free(table->entries);
+        *table = grown;
+    }
+    struct NodeEntry *entry = findNodeEntry(table, key);
+    if (entry->value == NO_NODE) {
+        entry->key = *key;
+        ++table->size;
+    }
+    return entry;
+}
+
+static uint8_t getOldTransitions(const struct PartitionUpdate *update, uint32_t state) {
+    uint64_t low = 0, high = update->num_of_changed;
+    while (low < high) {
+        const uint64_t middle = (low + high) / 2;
+        if (update->changed[middle].state < state) low = middle + 1;
+        else high = middle;
+    }
+    if (low < update->num_of_changed && update->changed[low].state == state) return update->changed[low].transitions;
+    return getShiftRegisterTransitions(update->reg, state);
+}
+
+// Узел шага level, в котором был класс id старого разбиения.
+static inline uint32_t getAncestor(const struct StatePartition *partition, uint32_t id, uint32_t level) {
+    while (partition->born[id] > level) id = partition->parent[id];
+    return id;
+}
+
+// Узлы следующих состояний на шаге level - 1 для первого состояния класса id
+// старого разбиения по старой таблице.
+static void getOldKey(const struct PartitionUpdate *update, uint32_t id, uint32_t level, struct NodeKey *key) {
+    const struct StatePartition *partition = update->partition;
+    const uint32_t state = partition->states[partition->first[id]];
+    const uint8_t transitions = getOldTransitions(update, state);
+    const uint32_t mask = update->reg->mask;
+    key->level = level;
+    key->next_0 = getAncestor(partition, partition->class_of[((state << 1) | (transitions & 1)) & mask], level - 1);
+    key->next_1 = getAncestor(partition, partition->class_of[((state << 1) | ((transitions >> 1) & 1)) & mask], level - 1);
+}
+
+// Вносит в таблицу старые узлы шага level под старым узлом id: сам id и части,
+// выделившиеся из него на этом шаге.
+static int addOldChildren(struct PartitionUpdate *update, uint32_t id, uint32_t level) {
+    struct NodeKey key = {id, level, NO_NODE, NO_NODE};
+    struct NodeEntry *entry = getNodeEntry(&update->table, &key);
+    if (!entry) return -1;
+    if (entry->value != NO_NODE) return 0;
+    entry->value = id;
+    getOldKey(update, id, level, &key);
+    if (!(entry = getNodeEntry(&update->table, &key))) return -1;
+    entry->value = id;
+    for (uint32_t i = update->child_first[id]; i < update->child_first[id + 1]; ++i) {
+        const uint32_t child = update->children[i];
+        if (update->partition->born[child] != level) continue;
+        getOldKey(update, child, level, &key);
+        if (!(entry = getNodeEntry(&update->table, &key))) return -1;
+        entry->value = child;
+    }
+    return 0;
+}
+
+static uint32_t addNewNode(struct PartitionUpdate *update, uint32_t parent, uint32_t level) {
+    if (reserve(
+        (void **)&update->new_nodes, &update->new_nodes_capacity,
+        update->num_of_new_nodes + 1, sizeof(struct NewNode)
+    )) return NO_NODE;
+    const uint32_t id = (uint32_t)(update->num_of_classes + update->num_of_new_nodes);
+    update->new_nodes[update->num_of_new_nodes++] = (struct NewNode){
+        .parent = parent == NO_NODE ? id : parent, .born = level, .level = level
+    };
+    return id;
+}
+
+// Узел шага level для состояния из узла id шага level - 1.
+static uint32_t findNode(struct PartitionUpdate *update, uint32_t id, uint32_t level, uint32_t next_0, uint32_t next_1) {
+    if (id < update->num_of_classes && addOldChildren(update, id, level)) return NO_NODE;
+    const struct NodeKey key = {id, level, next_0, next_1};
+    struct NodeEntry *entry = getNodeEntry(&update->table, &key);
+    if (!entry || entry->value != NO_NODE) return entry ? entry->value : NO_NODE;
+    // Первые пришедшие состояния нового узла остаются в нём самом.
+    if (id >= update->num_of_classes && update->new_nodes[id - update->num_of_classes].level < level) {
+        update->new_nodes[id - update->num_of_classes].level = level;
+        return entry->value = id;
+    }
+    return entry->value = addNewNode(update, id, level);
+}
+
+static inline uint32_t getNextNode(const struct PartitionUpdate *update, uint32_t state, uint32_t level) {
+    const struct StatePartition *partition = update->partition;
+    if (partition->is_pending[state]) return update->node[partition->pending[state]];
+    return getAncestor(partition, partition->class_of[state], level - 1);
+}
+
+// Отличался ли узел state от старого на предыдущем шаге.
+static inline uint8_t isNodeDifferent(const struct PartitionUpdate *update, uint32_t state) {
+    const struct StatePartition *partition = update->partition;
+    return partition->is_pending[state] && (update->differs[partition->pending[state]] & 1);
+}
+
+static int reserveAffected(struct PartitionUpdate *update, uint64_t size) {
+    uint64_t capacity = update->affected_capacity;
+    if (reserve((void **)&update->node, &capacity, size, sizeof(uint32_t))) return -1;
+    capacity = update->affected_capacity;
+    if (reserve((void **)&update->next_node, &capacity, size, sizeof(uint32_t))) return -1;
+    capacity = update->affected_capacity;
+    if (reserve((void **)&update->differs, &capacity, size, sizeof(uint8_t))) return -1;
+    return reserve((void **)&update->affected, &update->affected_capacity, size, sizeof(uint32_t));
+}
+
+// Добавляет state к затронутым с узлом node. Возвращает 1, если затронутых
+// стало бы больше limit.
+static int addAffected(struct PartitionUpdate *update, uint32_t state, uint32_t node, uint8_t differs) {
+    struct StatePartition *partition = update->partition;
+    if (partition->is_pending[state]) return 0;
+    if (update->num_of_affected == update->limit) return 1;
+    if (reserveAffected(update, update->num_of_affected + 1)) return -1;
+    partition->is_pending[state] = 1;
+    partition->pending[state] = (uint32_t)update->num_of_affected;
+    update->affected[update->num_of_affected] = state;
+    update->node[update->num_of_affected] = node;
+    update->differs[update->num_of_affected++] = differs;
+    return 0;
+}
+
+// Предшественники затронутого состояния i со старыми узлами шага level.
+static int addPredecessors(struct PartitionUpdate *update, uint64_t i, uint32_t level) {
+    const struct StatePartition *partition = update->partition;
+    uint32_t predecessors[2];
+    const uint8_t count = getShiftRegisterPredecessors(update->reg, update->affected[i], predecessors);
+    for (uint8_t j = 0; j < count; ++j) {
+        const int rc = addAffected(
+            update, predecessors[j], getAncestor(partition, partition->class_of[predecessors[j]], level), 0
+        );
+        if (rc) return rc;
+    }
+    return 0;
+}
+
+// Потомки старых классов.
+static int buildChildren(struct PartitionUpdate *update) {
+    const struct StatePartition *partition = update->partition;
+    const uint64_t num_of_classes = update->num_of_classes;
+    update->child_first = calloc(num_of_classes + 1, sizeof(uint32_t));
+    update->children = malloc(num_of_classes * sizeof(uint32_t));
+    if (!update->child_first || !update->children) return -1;
+    for (uint64_t id = 0; id < num_of_classes; ++id)
+        if (partition->parent[id] != id) ++update->child_first[partition->parent[id] + 1];
+    for (uint64_t id = 0; id < num_of_classes; ++id) update->child_first[id + 1] += update->child_first[id];
+    for (uint64_t id = 0; id < num_of_classes; ++id)
+        if (partition->parent[id] != id) update->children[update->child_first[partition->parent[id]]++] = (uint32_t)id;
+    for (uint64_t id = num_of_classes; id > 0; --id) update->child_first[id] = update->child_first[id - 1];
+    update->child_first[0] = 0;
+    return 0;
+}
+
+// Больше ли limit состояний было в старом узле id на шаге level. В *count
+// накапливается их число, пока оно не превысит limit.
+static uint8_t countOldStates(
+    const struct PartitionUpdate *update, uint32_t id, uint32_t level, uint64_t limit, uint64_t *count
+) {
+    const struct StatePartition *partition = update->partition;
+    if ((*count += partition->size[id]) > limit) return 1;
+    for (uint32_t i = update->child_first[id]; i < update->child_first[id + 1]; ++i) {
+        const uint32_t child = update->children[i];
+        if (partition->born[child] > level && countOldStates(update, child, partition->born[child], limit, count))
+            return 1;
+    }
+    return 0;
+}
+
+static int reserveRecomputed(struct PartitionUpdate *update, uint64_t size) {
+    uint64_t capacity = update->recomputed_capacity;
+    if (reserve((void **)&update->landed, &capacity, size, sizeof(uint32_t))) return -1;
+    return reserve((void **)&update->recomputed, &update->recomputed_capacity, size, sizeof(uint64_t));
+}
+
+static int containsId(const uint32_t *sorted, uint64_t size, uint32_t value) {
+    uint64_t low = 0, high = size;
+    while (low < high) {
+        const uint64_t middle = (low + high) / 2;
+        if (sorted[middle] < value) low = middle + 1;
+        else high = middle;
+    }
+    return low < size && sorted[low] == value;
+}
+
+static int compareWords(const void *a, const void *b) {
+    const uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int compareIds(const void *a, const void *b) {
+    const uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Если все состояния старого узла шага level пересчитаны, попали в один новый узел,
+// созданный на этом шаге, и больше в нём никого нет, а в сам старый узел никто не
+// попал, то класс не изменился, поменялся только ключ (например, у класса из одного
+// состояния, следующее которого сменило узел). Тогда состояния остаются в старом
+// узле, а новый удаляется. Иначе такие состояния отличались бы от старых узлов на
+// всех следующих шагах, а с ними и их предшественники. Созданные на шаге новые узлы
+// идут с first_new; оставшиеся сдвигаются на место удалённых.
+static int keepOldNodes(struct PartitionUpdate *update, uint32_t level, uint64_t first_new, uint64_t num_of_recomputed) {
+    const struct StatePartition *partition = update->partition;
+    const uint64_t num_of_created = update->num_of_new_nodes - first_new;
+    const uint32_t base = (uint32_t)(update->num_of_classes + first_new);
+    if (!num_of_created) return 0;
+    if (reserve((void **)&update->arrivals, &update->arrivals_capacity, num_of_created, sizeof(uint32_t))) return -1;
+    memset(update->arrivals, 0, num_of_created * sizeof(uint32_t));
+    uint64_t num_of_landed = 0;
+    for (uint64_t r = 0; r < num_of_recomputed; ++r) {
+        const uint32_t id = update->next_node[(uint32_t)update->recomputed[r]];
+        if (id >= base) ++update->arrivals[id - base];
+        else if (id < update->num_of_classes) update->landed[num_of_landed++] = id;
+    }
+    qsort(update->recomputed, num_of_recomputed, sizeof(uint64_t), compareWords);
+    qsort(update->landed, num_of_landed, sizeof(uint32_t), compareIds);
+    for (uint64_t begin = 0, end; begin < num_of_recomputed; begin = end) {
+        const uint32_t old = (uint32_t)(update->recomputed[begin] >> 32);
+        const uint32_t id = update->next_node[(uint32_t)update->recomputed[begin]];
+        uint8_t together = id >= base;
+        for (end = begin + 1; end < num_of_recomputed && update->recomputed[end] >> 32 == old; ++end)
+            together &= update->next_node[(uint32_t)update->recomputed[end]] == id;
+        uint64_t count = 0;
+        if (
+            !together || update->arrivals[id - base] != end - begin ||
+            update->new_nodes[id - update->num_of_classes].parent != getAncestor(partition, old, level - 1) ||
+            containsId(update->landed, num_of_landed, old) ||
+            countOldStates(update, old, level, end - begin, &count)
+        ) continue;
+        for (uint64_t r = begin; r < end; ++r) update->next_node[(uint32_t)update->recomputed[r]] = old;
+        update->arrivals[id - base] = 0;
+    }
+    uint64_t kept = 0;
+    for (uint64_t j = 0; j < num_of_created; ++j) {
+        if (!update->arrivals[j]) {
+            update->arrivals[j] = NO_NODE;
+            continue;
+        }
+        update->new_nodes[first_new + kept] = update->new_nodes[first_new + j];
+        update->arrivals[j] = (uint32_t)(base + kept++);
+    }
+    update->num_of_new_nodes = first_new + kept;
+    for (uint64_t r = 0; r < num_of_recomputed; ++r) {
+        uint32_t *id = update->next_node + (uint32_t)update->recomputed[r];
+        if (*id >= base) *id = update->arrivals[*id - base];
+    }
+    return 0;
+}
+
+// Узлы затронутых состояний по шагам. Узел состояния на шаге level может отличаться
+// от старого, только если состояние изменено или на шаге level - 1 отличался его
+// узел или узел следующего состояния. Поэтому затронутые набираются по ходу шагов:
+// сначала это изменённые, а когда узел состояния начинает отличаться, к ним
+// добавляются его предшественники (узел, раз начав отличаться, отличается и дальше).
+// Узлы остальных состояний берутся из старого дерева. Узел пересчитываемого
+// состояния - старый, если его ключ совпал с ключом старого узла того же шага под
+// тем же узлом (ключ старого узла считается по его первому состоянию и старой
+// таблице), иначе новый. Возвращает 1, если затронутых стало больше limit.
+static int computeNodes(struct PartitionUpdate *update) {
+    struct StatePartition *partition = update->partition;
+    const struct ShiftRegister *reg = update->reg;
+    if (buildChildren(update)) return -1;
+    uint32_t last_born = 0;
+    for (uint64_t id = 0; id < update->num_of_classes; ++id)
+        if (partition->born[id] > last_born) last_born = partition->born[id];
+    for (uint64_t i = 0; i < update->num_of_changed; ++i) {
+        const uint32_t state = update->changed[i].state;
+        const uint8_t outputs = getShiftRegisterOutputs(getShiftRegisterTransitions(reg, state));
+        if (partition->output_classes[outputs] == NO_NODE)
+            partition->output_classes[outputs] = addNewNode(update, NO_NODE, 0);
+        const uint32_t id = partition->output_classes[outputs];
+        if (id == NO_NODE) return -1;
+        const int rc = addAffected(update, state, id, id != getAncestor(partition, partition->class_of[state], 0));
+        if (rc) return rc;
+    }
+    for (uint64_t i = 0; i < update->num_of_changed; ++i)
+        if (update->differs[i]) {
+            const int rc = addPredecessors(update, i, 0);
+            if (rc) return rc;
+        }
+    // Когда старые узлы больше не делятся, а затронутые состояния остались на месте,
+    // разбиение устойчиво.
+    for (uint32_t level = 1;; ++level) {
+        const uint64_t num_of_affected = update->num_of_affected, first_new = update->num_of_new_nodes;
+        uint64_t num_of_recomputed = 0;
+        if (reserveRecomputed(update, num_of_affected)) return -1;
+        for (uint64_t i = 0; i < num_of_affected; ++i) {
+            const uint32_t state = update->affected[i];
+            const uint8_t transitions = getShiftRegisterTransitions(reg, state);
+            const uint32_t next_0 = ((state << 1) | (transitions & 1)) & reg->mask;
+            const uint32_t next_1 = ((state << 1) | ((transitions >> 1) & 1)) & reg->mask;
+            const uint32_t old = getAncestor(partition, partition->class_of[state], level);
+            uint32_t id = old;
+            if (
+                i < update->num_of_changed || (update->differs[i] & 1) ||
+                isNodeDifferent(update, next_0) || isNodeDifferent(update, next_1)
+            ) {
+                id = findNode(
+                    update, update->node[i], level, getNextNode(update, next_0, level), getNextNode(update, next_1, level)
+                );
+                if (id == NO_NODE) return -1;
+                update->recomputed[num_of_recomputed++] = (uint64_t)old << 32 | i;
+            }
+            update->next_node[i] = id;
+        }
+        if (keepOldNodes(update, level, first_new, num_of_recomputed)) return -1;
+        uint8_t moved = 0;
+        for (uint64_t r = 0; r < num_of_recomputed; ++r) {
+            const uint32_t i = (uint32_t)update->recomputed[r];
+            update->differs[i] |= (update->next_node[i] != (uint32_t)(update->recomputed[r] >> 32)) << 1;
+        }
+        for (uint64_t i = 0; i < num_of_affected; ++i) moved |= update->next_node[i] != update->node[i];
+        uint32_t *node = update->node;
+        update->node = update->next_node;
+        update->next_node = node;
+        for (uint64_t i = 0; i < num_of_affected; ++i) {
+            const uint8_t differs = update->differs[i];
+            update->differs[i] = differs >> 1;
+            if (differs != 2) continue;
+            const int rc = addPredecessors(update, i, level);
+            if (rc) return rc;
+        }
+        if (!moved && level > last_born) return 0;
+    }
+}
+
+// Начало диапазона слов sorted, у которых старшая половина равна id.
+static uint64_t findWords(const uint64_t *sorted, uint64_t size, uint32_t id) {
+    uint64_t low = 0, high = size;
+    while (low < high) {
+        const uint64_t middle = (low + high) / 2;
+        if (sorted[middle] >> 32 < id) low = middle + 1;
+        else high = middle;
+    }
+    return low;
+}
+
+static inline uint32_t *getParent(struct PartitionUpdate *update, uint32_t id) {
+    return id < update->num_of_classes ?
+        update->partition->parent + id : &update->new_nodes[id - update->num_of_classes].parent;
+}
+
+static inline uint32_t *getBorn(struct PartitionUpdate *update, uint32_t id) {
+    return id < update->num_of_classes ?
+        update->partition->born + id : &update->new_nodes[id - update->num_of_classes].born;
+}
+
+// Опустевший старый класс убирается из дерева: его место занимает потомок,
+// выделившийся последним, к которому переходят остальные потомки. Классы
+// разбираются от выделившихся позже, так что потомок уже сам на месте.
+// В replacement[id] пишется занявший место id класс или NO_NODE. new_children -
+// новые узлы в виде (parent << 32) | номер по возрастанию.
+static void removeEmptyClasses(
+    struct PartitionUpdate *update, const uint64_t *empty, uint64_t num_of_empty,
+    const uint64_t *new_children, uint32_t *replacement
+) {
+    struct StatePartition *partition = update->partition;
+    for (uint64_t i = num_of_empty; i-- > 0;) {
+        const uint32_t id = (uint32_t)empty[i];
+        const uint64_t begin = findWords(new_children, update->num_of_new_nodes, id);
+        uint64_t end = begin;
+        while (end < update->num_of_new_nodes && new_children[end] >> 32 == id) ++end;
+        const uint64_t num_of_old = update->child_first[id + 1] - update->child_first[id];
+        uint32_t best = NO_NODE;
+        for (uint64_t j = 0; j < num_of_old + end - begin; ++j) {
+            const uint32_t child = replacement[
+                j < num_of_old ? update->children[update->child_first[id] + j] : (uint32_t)new_children[begin + j - num_of_old]
+            ];
+            if (child != NO_NODE && (best == NO_NODE || *getBorn(update, child) > *getBorn(update, best))) best = child;
+        }
+        replacement[id] = best;
+        for (uint8_t outputs = 0; outputs < 4; ++outputs)
+            if (partition->output_classes[outputs] == id) partition->output_classes[outputs] = best;
+        if (best == NO_NODE) continue;
+        *getBorn(update, best) = partition->born[id];
+        *getParent(update, best) = partition->parent[id] == id ? best : partition->parent[id];
+        for (uint64_t j = 0; j < num_of_old + end - begin; ++j) {
+            const uint32_t child = replacement[
+                j < num_of_old ? update->children[update->child_first[id] + j] : (uint32_t)new_children[begin + j - num_of_old]
+            ];
+            if (child != NO_NODE && child != best) *getParent(update, child) = best;
+        }
+    }
+}
+
+// Переносит результат computeNodes в разбиение. Номера опустевших классов занимают
+// новые классы, а если их не хватает - классы с последними номерами. Блоки states
+// до первого затронутого класса (в порядке order) остаются на месте, дальше
+// блоки переписываются через pending.
+static int applyNodes(struct PartitionUpdate *update) {
+    struct StatePartition *partition = update->partition;
+    const uint64_t num_of_classes = update->num_of_classes, num_of_new_nodes = update->num_of_new_nodes;
+    const uint64_t num_of_nodes = num_of_classes + num_of_new_nodes, num_of_affected = update->num_of_affected;
+    // old_size - старый размер плюс один у затронутых старых классов, arrivals -
+    // (узел << 32) | состояние для затронутых состояний, empty - опустевшие классы.
+    uint32_t *final = malloc(num_of_nodes * sizeof(uint32_t));
+    uint32_t *old_size = calloc(num_of_nodes, sizeof(uint32_t));
+    uint64_t *arrivals = malloc(num_of_affected * sizeof(uint64_t));
+    uint64_t *empty = malloc(num_of_affected * sizeof(uint64_t));
+    uint64_t *new_children = malloc((num_of_new_nodes ? num_of_new_nodes : 1) * sizeof(uint64_t));
+    int rc = final && old_size && arrivals && empty && new_children ? 0 : -1;
+    if (rc) goto end;
+    uint64_t first_changed = num_of_classes;
+    for (uint64_t i = 0; i < num_of_affected; ++i) {
+        const uint32_t ids[2] = {partition->class_of[update->affected[i]], update->node[i]};
+        for (int j = 0; j < 2; ++j) {
+            if (ids[j] >= num_of_classes || old_size[ids[j]]) continue;
+            old_size[ids[j]] = partition->size[ids[j]] + 1;
+            if (partition->position[ids[j]] < first_changed) first_changed = partition->position[ids[j]];
+        }
+    }
+    const uint32_t start = partition->first[partition->order[first_changed]];
+    for (uint64_t i = 0; i < num_of_affected; ++i) {
+        const uint32_t state = update->affected[i], id = update->node[i];
+        update->next_node[i] = partition->class_of[state];
+        --partition->size[partition->class_of[state]];
+        if (id < num_of_classes) ++partition->size[id];
+        else ++update->new_nodes[id - num_of_classes].size;
+        arrivals[i] = (uint64_t)id << 32 | state;
+        partition->class_of[state] = id;
+    }
+    qsort(arrivals, num_of_affected, sizeof(uint64_t), compareWords);
+    // Опустевшие классы убираются из order (помечаются NO_NODE).
+    uint64_t num_of_empty = 0;
+    for (uint64_t i = 0; i < num_of_affected; ++i) {
+        const uint32_t id = update->next_node[i];
+        if (partition->size[id] || partition->order[partition->position[id]] == NO_NODE) continue;
+        partition->order[partition->position[id]] = NO_NODE;
+        empty[num_of_empty++] = (uint64_t)partition->born[id] << 32 | id;
+    }
+    for (uint64_t id = 0; id < num_of_nodes; ++id) final[id] = (uint32_t)id;
+    for (uint64_t i = 0; i < num_of_new_nodes; ++i)
+        new_children[i] = (uint64_t)update->new_nodes[i].parent << 32 | (num_of_classes + i);
+    qsort(new_children, num_of_new_nodes, sizeof(uint64_t), compareWords);
+    qsort(empty, num_of_empty, sizeof(uint64_t), compareWords);
+    removeEmptyClasses(update, empty, num_of_empty, new_children, final);
+    // Новые номера. Отличаются от старых только номера от threshold.
+    for (uint64_t i = 0; i < num_of_empty; ++i) empty[i] &= UINT32_MAX;
+    qsort(empty, num_of_empty, sizeof(uint64_t), compareWords);
+    const uint64_t new_num_of_classes = num_of_nodes - num_of_empty;
+    const uint64_t threshold = new_num_of_classes < num_of_classes ? new_num_of_classes : num_of_classes;
+    for (uint64_t id = num_of_classes; id < num_of_nodes; ++id)
+        final[id] = id - num_of_classes < num_of_empty ?
+            (uint32_t)empty[id - num_of_classes] : (uint32_t)(id - num_of_empty);
+    for (uint64_t i = num_of_new_nodes, top = num_of_classes; i < num_of_empty && empty[i] < new_num_of_classes; ++i) {
+        do --top; while (!partition->size[top]);
+        final[top] = (uint32_t)empty[i];
+    }
+    // Дерево. Переезжающие классы сохраняют блок, пока states не переписан.
+    for (uint64_t id = 0; id < num_of_classes; ++id)
+        if (partition->parent[id] >= threshold && partition->size[id]) partition->parent[id] = final[partition->parent[id]];
+    for (uint64_t id = threshold; id < num_of_classes; ++id) {
+        if (!partition->size[id] || final[id] == id) continue;
+        const uint32_t target = final[id];
+        partition->parent[target] = partition->parent[id];
+        partition->born[target] = partition->born[id];
+        partition->size[target] = partition->size[id];
+        partition->first[target] = partition->first[id];
+        if (partition->position[id] < first_changed) {
+            partition->order[partition->position[id]] = target;
+            partition->position[target] = partition->position[id];
+        }
+    }
+    for (uint64_t i = 0; i < num_of_new_nodes; ++i) {
+        const uint32_t target = final[num_of_classes + i];
+        partition->parent[target] = final[update->new_nodes[i].parent];
+        partition->born[target] = update->new_nodes[i].born;
+    }
+    for (uint8_t outputs = 0; outputs < 4; ++outputs)
+        if (partition->output_classes[outputs] != NO_NODE)
+            partition->output_classes[outputs] = final[partition->output_classes[outputs]];
+    // Порядок: сохранившиеся классы на прежних местах, новые в конце.
+    uint64_t count = first_changed;
+    for (uint64_t i = first_changed; i < num_of_classes; ++i)
+        if (partition->order[i] != NO_NODE) partition->order[count++] = partition->order[i];
+    for (uint64_t id = num_of_classes; id < num_of_nodes; ++id) partition->order[count++] = (uint32_t)id;
+    // Блоки: нетронутые копируются целиком, в затронутых остаются незатронутые
+    // состояния и добавляются пришедшие, по возрастанию.
+    uint32_t *buffer = partition->pending, next = start;
+    for (uint64_t i = first_changed; i < new_num_of_classes; ++i) {
+        const uint32_t id = partition->order[i], target = final[id], begin = next;
+        if (id < num_of_classes && !old_size[id]) {
+            memcpy(buffer + next, partition->states + partition->first[id], partition->size[id] * sizeof(uint32_t));
+            next += partition->size[id];
+        } else {
+            uint64_t arrival = findWords(arrivals, num_of_affected, id);
+            const uint32_t *old = partition->states + (id < num_of_classes ? partition->first[id] : 0);
+            const uint32_t old_count = id < num_of_classes ? old_size[id] - 1 : 0;
+            for (uint32_t j = 0; j < old_count || (arrival < num_of_affected && arrivals[arrival] >> 32 == id);) {
+                if (j < old_count && partition->is_pending[old[j]]) {
+                    ++j;
+                    continue;
+                }
+                if (
+                    arrival < num_of_affected && arrivals[arrival] >> 32 == id &&
+                    (j == old_count || (uint32_t)arrivals[arrival] < old[j])
+                ) buffer[next++] = (uint32_t)arrivals[arrival++];
+                else buffer[next++] = old[j++];
+            }
+        }
+        partition->first[target] = begin;
+        partition->size[target] = next - begin;
+        partition->order[i] = target;
+        partition->position[target] = (uint32_t)i;
+    }
+    memcpy(partition->states + start, buffer + start, (next - start) * sizeof(uint32_t));
+    for (uint64_t i = 0; i < num_of_affected; ++i)
+        partition->class_of[update->affected[i]] = final[partition->class_of[update->affected[i]]];
+    for (uint64_t id = threshold; id < num_of_classes; ++id) {
+        if (!partition->size[id] || final[id] == id) continue;
+        const uint32_t target = final[id];
+        for (uint32_t j = partition->first[target]; j < partition->first[target] + partition->size[target]; ++j)
+            partition->class_of[partition->states[j]] = target;
+    }
+    partition->num_of_classes = new_num_of_classes;
+    partition->num_of_rounds = getStatePartitionDegree(partition);
+end:
+    free(final);
+    free(old_size);
+    free(arrivals);
+    free(empty);
+    free(new_children);
+    return rc;
+}
+
+int updateStatePartition(
+    struct StatePartition *partition, struct ShiftRegister *reg,
+    const struct TransitionChange *changes, uint64_t num_of_changes, uint64_t *num_of_affected
+) {
+    *num_of_affected = 0;
+    if (
+        (!reg->transitions.bucket && !isShiftRegisterSparse(reg)) || !partition->parent ||
+        partition->num_of_states != (uint64_t)1 << reg->length
+    ) return -2;
+    for (uint64_t i = 0; i < num_of_changes; ++i)
+        if (changes[i].state >= partition->num_of_states) return -3;
+    struct PartitionUpdate update = {.partition = partition, .reg = reg, .num_of_classes = partition->num_of_classes};
+    int rc = 0;
+    // Старые полубайты берутся до записи; из повторов состояния важен первый.
+    uint64_t *sorted = malloc((num_of_changes ? num_of_changes : 1) * sizeof(uint64_t));
+    update.changed = malloc((num_of_changes ? num_of_changes : 1) * sizeof(struct TransitionChange));
+    if (!sorted || !update.changed) {
+        rc = -1;
+        goto end;
+    }
+    for (uint64_t i = 0; i < num_of_changes; ++i) sorted[i] = (uint64_t)changes[i].state << 32 | i;
+    qsort(sorted, num_of_changes, sizeof(uint64_t), compareWords);
+    for (uint64_t i = 0; i < num_of_changes; ++i) {
+        const uint32_t state = (uint32_t)(sorted[i] >> 32);
+        if (update.num_of_changed && update.changed[update.num_of_changed - 1].state == state) continue;
+        update.changed[update.num_of_changed++] = (struct TransitionChange){
+            .state = state, .transitions = getShiftRegisterTransitions(reg, state)
+        };
+    }
+    if (changeShiftRegisterTransitions(reg, changes, num_of_changes)) {
+        rc = -1;
+        goto end;
+    }
+    uint64_t num_of_changed = 0;
+    for (uint64_t i = 0; i < update.num_of_changed; ++i)
+        if (update.changed[i].transitions != getShiftRegisterTransitions(reg, update.changed[i].state))
+            update.changed[num_of_changed++] = update.changed[i];
+    update.num_of_changed = num_of_changed;
+    if (!update.num_of_changed) goto end;
+    update.limit = partition->num_of_states >> PARTITION_UPDATE_SHARE_SHIFT;
+    const int computed = computeNodes(&update);
+    *num_of_affected = update.num_of_affected;
+    if (computed < 0 || (!computed && applyNodes(&update))) {
+        rc = -1;
+        goto end;
+    }
+    for (uint64_t i = 0; i < update.num_of_affected; ++i) partition->is_pending[update.affected[i]] = 0;
+    if (computed) {
+        const unsigned num_of_threads = partition->num_of_threads;
+        freeStatePartition(partition);
+        rc = minimizeStatePartition(partition, reg, num_of_threads) ? -1 : 1;
+    }
+end:
+    free(sorted);
+    free(update.changed);
+    free(update.affected);
+    free(update.node);
+    free(update.next_node);
+    free(update.differs);
+    free(update.recomputed);
+    free(update.landed);
+    free(update.arrivals);
+    free(update.new_nodes);
+    free(update.child_first);
+    free(update.children);
+    free(update.table.entries);
+    return rc;
+}
+
+void printStatePartition(const struct StatePartition *partition) {
+    for (uint64_t i = 0; i < partition->num_of_classes; ++i) {
+        const uint32_t id = partition->order[i];
+        printf("\t{ ");
+        for (uint32_t j = partition->first[id]; j < partition->first[id] + partition->size[id]; ++j)
+            printf("%" PRIu32 " ", partition->states[j]);
+        printf("}\n");
+    }
+}
+
+int statePartitionToList(const struct StatePartition *partition, List *classes) {
+    initList(classes);
+    for (uint64_t i = 0; i < partition->num_of_classes; ++i) {
+        const uint32_t id = partition->order[i];
+        List class;
+        initList(&class);
+        for (uint32_t j = partition->first[id]; j < partition->first[id] + partition->size[id]; ++j)
+            if (pushList(&class, &partition->states[j], sizeof(uint32_t))) {
+                clearList(&class);
+                deepClearList(classes, (FreeValueFunction)clearList);
+                return -1;
+            }
+        if (pushList(classes, &class, sizeof(List))) {
+            clearList(&class);
+            deepClearList(classes, (FreeValueFunction)clearList);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+uint32_t *takeStatePartitionClasses(struct StatePartition *partition, uint8_t *kind) {
+    uint32_t *class_of = partition->class_of;
+    for (uint64_t state = 0; state < partition->num_of_states; ++state)
+        class_of[state] = partition->position[class_of[state]];
+    *kind = partition->kinds[0];
+    partition->class_of = NULL;
+    return class_of;
+}
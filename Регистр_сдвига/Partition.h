@@ -0,0 +1,103 @@
+#ifndef PARTITION_H
+#define PARTITION_H
+
+#include "ShiftRegister.h"
+#include <pthread.h>
+
+struct StateKey {
+    uint64_t key;
+    uint32_t state;
+};
+
+struct StateSegment;
+
+// Разбиение состояний регистра на классы в массивах. Состояния одного класса лежат
+// в states подряд (по возрастанию), блок класса id начинается с first[id] и имеет
+// длину size[id]. order - порядок классов при выводе, position - обратная к нему
+// перестановка. Номер класса id за время минимизации не меняется: при разбиении
+// класса его сохраняет самая большая часть, остальные получают новые номера.
+// Разбиение, построенное minimizeStatePartition, помнит и дерево разбиений: часть id
+// выделилась из класса parent[id] на шаге born[id], у классов первого шага born = 0
+// и parent[id] = id. Иначе parent и born пусты.
+struct StatePartition {
+    uint64_t num_of_states;
+    uint64_t num_of_classes;
+    uint32_t *class_of;
+    uint32_t *states;
+    uint32_t *first;
+    uint32_t *size;
+    uint32_t *order;
+    uint32_t *position;
+    // Классы, которые могут разделиться на следующем шаге: те, где есть
+    // предшественник состояния, сменившего класс на предыдущем. Идут по
+    // возрастанию номера, так что номера частей не зависят от числа потоков.
+    uint32_t *pending;
+    uint64_t num_of_pending;
+    uint8_t *is_pending;
+    uint32_t *parent;
+    uint32_t *born;
+    uint64_t num_of_rounds;
+    // Класс первого шага с данными выходами (см. initOutputPartition) или UINT32_MAX.
+    uint32_t output_classes[4];
+    uint8_t kinds[10];
+    // Потоки, между которыми делятся куски каждого шага (см. PARTITION_CHUNK_STATES).
+    unsigned num_of_threads;
+    pthread_t *threads;
+    // Рабочие буферы шага: ключи состояний разбиваемых классов (и второй массив
+    // для поразрядной сортировки), куски, счётчики и части разделившихся классов.
+    struct StateKey *keys;
+    struct StateKey *sorted;
+    uint64_t keys_capacity;
+    struct StateSegment *segments;
+    uint64_t segments_capacity;
+    uint64_t *counts;
+    uint64_t counts_capacity;
+    uint32_t *pieces;
+    uint64_t pieces_capacity;
+};
+
+// Размеры и начала блоков классов - uint32_t, так что класс из 2^32 состояний
+// регистра длины 32 в них не помещается. Такие регистры минимизирует
+// minimizeShiftRegisterExternally (см. ExternalPartition.h).
+#define PARTITION_MAX_LENGTH 31
+
+// Первый шаг минимизации: классы по выходам при x = 0 и x = 1. Для регистра длиннее
+// PARTITION_MAX_LENGTH возвращает -2.
+int initOutputPartition(struct StatePartition *partition, const struct ShiftRegister *reg, unsigned num_of_threads);
+// Шаг минимизации: состояния класса разделяются по классам следующих состояний,
+// подклассы идут на месте исходного класса по возрастанию пары позиций этих классов
+// (как в minimizeShiftRegister). Просматриваются только классы из pending.
+// Возвращает число новых классов или отрицательное число при нехватке памяти.
+int64_t refineStatePartition(struct StatePartition *partition, const struct ShiftRegister *reg);
+// Минимизация целиком, без вывода шагов.
+int minimizeStatePartition(struct StatePartition *partition, const struct ShiftRegister *reg, unsigned num_of_threads);
+// Степень различимости по дереву разбиений: номер последнего шага, на котором
+// разделился класс, плюс один (0, если класс один).
+uint64_t getStatePartitionDegree(const struct StatePartition *partition);
+// Если затронутых состояний становится больше 1/2^PARTITION_UPDATE_SHARE_SHIFT,
+// разбиение строится заново.
+#define PARTITION_UPDATE_SHARE_SHIFT 3
+// Вносит изменения changes в таблицу reg (см. changeShiftRegisterTransitions) и
+// приводит к новому регистру разбиение, построенное minimizeStatePartition или
+// предыдущим обновлением. Шаги дерева разбиений проходятся заново, но пересчитываются
+// только затронутые состояния: изменённые, те, чей класс на каком-то шаге стал
+// другим, и их предшественники. Их число пишется в *num_of_affected (если разбиение
+// построено заново - число, на котором пересчёт остановлен). Остальные состояния
+// берутся из дерева. Номера сохранившихся классов не меняются, кроме тех, что
+// переезжают на место исчезнувших; новые классы идут в order последними.
+// Возвращает 0, 1, если разбиение построено заново, или отрицательное число при
+// ошибке (тогда разбиение надо строить заново).
+int updateStatePartition(
+    struct StatePartition *partition, struct ShiftRegister *reg,
+    const struct TransitionChange *changes, uint64_t num_of_changes, uint64_t *num_of_affected
+);
+// В формате printListOfEquivalenceClasses с printState.
+void printStatePartition(const struct StatePartition *partition);
+// Список классов в порядке order, как у struct Minimized.
+int statePartitionToList(const struct StatePartition *partition, List *classes);
+// Забирает class_of, перенумеровав классы в порядке order (как в списке). Дальше
+// разбиение годится только для freeStatePartition.
+uint32_t *takeStatePartitionClasses(struct StatePartition *partition, uint8_t *kind);
+void freeStatePartition(struct StatePartition *partition);
+
+#endif
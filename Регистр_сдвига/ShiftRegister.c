@@ -1,18 +1,75 @@
 #include "ShiftRegister.h"
+#include "ANFShiftRegister.h"
+#include "LinearShiftRegister.h"
+#include "SmallShiftRegister.h"
+#include "GeneratedShiftRegister.h"
+#include "Partition.h"
+#include "Alloc.h"
 #include <inttypes.h>
 #include <stdlib.h>
 #include <pthread.h>
 #include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-int initShiftRegisterFromFile(struct ShiftRegister* reg, char* settings_file) {
-    FILE *fp = fopen(settings_file, "r");
-    if (!fp) {
-        printf("Не открывается файл %s\n", settings_file);
+// Двоичный формат: заголовок, затем с SHIFT_REGISTER_FILE_DATA_OFFSET - перемежённая
+// таблица transitions как есть. Смещение кратно любой странице до 64 КиБ,
+// поэтому таблица отображается в память без копирования.
+#define SHIFT_REGISTER_FILE_MAGIC "SHIFTREG"
+#define SHIFT_REGISTER_FILE_VERSION 1
+#define SHIFT_REGISTER_FILE_DATA_OFFSET ((uint64_t)1 << 16)
+
+struct ShiftRegisterFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t length;
+    uint64_t table_size;
+    uint64_t checksum;
+};
+
+static uint64_t getTransitionsSize(uint8_t length) {
+    return (((uint64_t)1 << (length + 2)) + 7) / 8;
+}
+
+// Читает таблицу функции и раскладывает её пары значений по полубайтам состояний.
+static int readFunctionIntoTransitions(
+    struct ShiftRegister *reg,
+    uint8_t shift,
+    const char *data,
+    size_t size,
+    size_t *position
+) {
+    BitArray function;
+    if (initBitArray(&function, (uint64_t)1 << (reg->length + 1))) return -1;
+    if (readArrayFromBuffer(&function, (uint64_t)1 << (reg->length + 1), data, size, position)) {
+        freeBitArray(&function);
+        return -2;
+    }
+    for (uint64_t state = 0; state < (uint64_t)1 << reg->length; ++state) {
+        uint8_t pair = (function.bucket[state >> 2] >> ((state & 3) << 1)) & 3;
+        reg->transitions.bucket[state >> 1] |= pair << (((state & 1) << 2) + shift);
+    }
+    freeBitArray(&function);
+    return 0;
+}
+
+static int initShiftRegisterFromText(struct ShiftRegister *reg, int fd, size_t size) {
+    const char *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        printf("Не удаётся отобразить файл в память\n");
         return -1;
     }
+    madvise((void *)data, size, MADV_SEQUENTIAL);
     int rc = 0;
-    char buf[3];
-    fgets(buf, 3, fp);
+    // Как и раньше, размер регистра берётся из первых двух символов.
+    char buf[3] = {0};
+    size_t position = 0;
+    while (position < 2 && position < size) {
+        buf[position] = data[position];
+        if (data[position++] == '\n') break;
+    }
     unsigned temp;
     if (sscanf(buf, "%u", &temp) != 1) {
         printf("Не считывается размер регистра \n");
@@ -24,42 +81,242 @@ int initShiftRegisterFromFile(struct ShiftRegister* reg, char* settings_file) {
         rc = -3;
         goto end;
     }
-    reg->mask = (1 << reg->length) - 1;
-    if (initBitArray(&reg->phi, (uint64_t)1 << (reg->length + 1))) {
+    reg->mask = (uint32_t)(((uint64_t)1 << reg->length) - 1);
+    if (initBitArray(&reg->transitions, (uint64_t)1 << (reg->length + 2))) {
         rc = -4;
         goto end;
     }
-    if (readArrayFromFile(&reg->phi, (uint64_t)1 << (reg->length + 1), fp)) {
-        freeBitArray(&reg->phi);
-        rc = -5;
-        goto end;
-    }
-    if (initBitArray(&reg->psi, (uint64_t)1 << (reg->length + 1))) {
-        freeBitArray(&reg->phi);
-        rc = -6;
-        goto end;
+    switch (readFunctionIntoTransitions(reg, 0, data, size, &position)) {
+        case 0: break;
+        case -1: rc = -4; break;
+        default: rc = -5;
     }
-    if (readArrayFromFile(&reg->psi, (uint64_t)1 << (reg->length + 1), fp)) {
-        freeBitArray(&reg->phi);
-        freeBitArray(&reg->psi);
-        rc = -7;
-        goto end;
+    if (!rc) switch (readFunctionIntoTransitions(reg, 2, data, size, &position)) {
+        case 0: break;
+        case -1: rc = -6; break;
+        default: rc = -7;
     }
+    if (rc) freeBitArray(&reg->transitions);
 end:
-    fclose(fp);
+    munmap((void *)data, size);
     return rc;
 }
 
-int readState(struct ShiftRegister* reg) {
+static int initShiftRegisterFromBinary(
+    struct ShiftRegister *reg,
+    int fd,
+    struct ShiftRegisterFileHeader *header,
+    uint64_t size
+) {
+    if (
+        header->version != SHIFT_REGISTER_FILE_VERSION ||
+        header->length > 32 ||
+        header->table_size != getTransitionsSize(header->length) ||
+        size < SHIFT_REGISTER_FILE_DATA_OFFSET + header->table_size
+    ) {
+        printf("Повреждён заголовок двоичного файла регистра\n");
+        return -8;
+    }
+    reg->length = (uint8_t)header->length;
+    reg->mask = (uint32_t)(((uint64_t)1 << reg->length) - 1);
+    if (isLargeAllocationEnabled()) {
+        // Страничный кэш файла огромными страницами не отображается - читаем в анонимную память.
+        if (initBitArray(&reg->transitions, (uint64_t)1 << (reg->length + 2))) return -4;
+        for (uint64_t done = 0; done < header->table_size;) {
+            ssize_t got = pread(
+                fd, reg->transitions.bucket + done, header->table_size - done,
+                (off_t)(SHIFT_REGISTER_FILE_DATA_OFFSET + done)
+            );
+            if (got <= 0) {
+                freeBitArray(&reg->transitions);
+                return -4;
+            }
+            done += (uint64_t)got;
+        }
+    } else {
+        if (mapBitArray(
+            &reg->transitions, (uint64_t)1 << (reg->length + 2),
+            fd, SHIFT_REGISTER_FILE_DATA_OFFSET
+        )) return -4;
+        madvise(reg->transitions.bucket, header->table_size, MADV_WILLNEED);
+    }
+    if (hashBlocks(reg->transitions.bucket, header->table_size) != header->checksum) {
+        printf("Не совпадает контрольная сумма двоичного файла регистра\n");
+        freeBitArray(&reg->transitions);
+        return -9;
+    }
+    return 0;
+}
+
+static int initShiftRegisterFromANF(struct ShiftRegister *reg, char *settings_file) {
+    struct ANFShiftRegister anf;
+    int rc = initANFShiftRegisterFromFile(&anf, settings_file);
+    if (rc) return rc == -1 ? -1 : -10;
+    rc = anfToShiftRegister(reg, &anf) ? -3 : 0;
+    freeANFShiftRegister(&anf);
+    return rc;
+}
+
+int initShiftRegisterFromFile(struct ShiftRegister* reg, char* settings_file) {
+    memset(&reg->kernel, 0, sizeof(reg->kernel));
+    if (isANFShiftRegisterFile(settings_file)) return initShiftRegisterFromANF(reg, settings_file);
+    if (isShiftRegisterKernelFile(settings_file)) {
+        if (initShiftRegisterFromKernel(reg, settings_file)) return -11;
+        detectLinearFeedback(reg);
+        initSmallEngine(reg);
+        initSparseTransitions(reg);
+        return 0;
+    }
+    int fd = open(settings_file, O_RDONLY);
+    if (fd < 0) {
+        printf("Не открывается файл %s\n", settings_file);
+        return -1;
+    }
+    int rc;
+    struct stat st;
+    struct ShiftRegisterFileHeader header;
+    if (fstat(fd, &st) || !st.st_size) {
+        printf("Не считывается размер регистра \n");
+        rc = -2;
+    } else if (
+        pread(fd, &header, sizeof(header), 0) == sizeof(header) &&
+        !memcmp(header.magic, SHIFT_REGISTER_FILE_MAGIC, sizeof(header.magic))
+    ) rc = initShiftRegisterFromBinary(reg, fd, &header, (uint64_t)st.st_size);
+    else rc = initShiftRegisterFromText(reg, fd, (size_t)st.st_size);
+    close(fd);
+    if (!rc) {
+        detectLinearFeedback(reg);
+        initSmallEngine(reg);
+        initSparseTransitions(reg);
+    }
+    return rc;
+}
+
+static uint64_t getLastLevelCacheSize() {
+    long size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (size <= 0) size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    return size > 0 ? (uint64_t)size : (uint64_t)8 << 20;
+}
+
+void initSparseTransitions(struct ShiftRegister *reg) {
+    memset(&reg->sparse, 0, sizeof(reg->sparse));
+    if (
+        !reg->transitions.bucket ||
+        reg->small.engine ||
+        getTransitionsSize(reg->length) <= getLastLevelCacheSize() ||
+        countBitArrayOnes(&reg->transitions) >
+            getBitArrayLength(&reg->transitions) >> SPARSE_TRANSITIONS_DENSITY_SHIFT
+    ) return;
+    // Не хватило памяти на разреженную копию - остаётся плотная таблица.
+    if (initSparseBitArray(&reg->sparse, &reg->transitions)) return;
+    freeBitArray(&reg->transitions);
+}
+
+int changeShiftRegisterTransitions(
+    struct ShiftRegister *reg, const struct TransitionChange *changes, uint64_t num_of_changes
+) {
+    // Разреженную таблицу на месте не изменить: она разворачивается в плотную.
+    if (isShiftRegisterSparse(reg)) {
+        if (sparseBitArrayToBitArray(&reg->transitions, &reg->sparse)) return -1;
+        freeSparseBitArray(&reg->sparse);
+    }
+    if (!reg->transitions.bucket) return -1;
+    for (uint64_t i = 0; i < num_of_changes; ++i) {
+        uint8_t *byte = reg->transitions.bucket + (changes[i].state >> 1);
+        const unsigned shift = (changes[i].state & 1) << 2;
+        *byte = (uint8_t)((*byte & ~(0xF << shift)) | ((changes[i].transitions & 0xF) << shift));
+    }
+    // Нелинейный регистр от правки линейным почти никогда не становится, а проверка
+    // проходит всю таблицу.
+    if (reg->linear.is_linear) detectLinearFeedback(reg);
+    if (reg->small.engine) initSmallEngine(reg);
+    return 0;
+}
+
+static int writeFunctionAsText(const struct ShiftRegister *reg, uint8_t shift, FILE *fp) {
+    char buf[1 << 16];
+    size_t filled = 0;
+    for (uint64_t index = 0; index < (uint64_t)1 << (reg->length + 1); ++index) {
+        if (filled + 2 > sizeof(buf)) {
+            if (fwrite(buf, 1, filled, fp) != filled) return -1;
+            filled = 0;
+        }
+        buf[filled++] = (char)('0' + ((getShiftRegisterTransitions(reg, index >> 1) >> (shift + (index & 1))) & 1));
+        buf[filled++] = ' ';
+    }
+    buf[filled - 1] = '\n';
+    return fwrite(buf, 1, filled, fp) == filled ? 0 : -1;
+}
+
+static int writeTransitionsAsBinary(uint8_t length, const BitArray *transitions, FILE *fp) {
+    struct ShiftRegisterFileHeader header = {
+        .version = SHIFT_REGISTER_FILE_VERSION,
+        .length = length,
+        .table_size = getTransitionsSize(length),
+        .checksum = hashBlocks(transitions->bucket, getTransitionsSize(length))
+    };
+    memcpy(header.magic, SHIFT_REGISTER_FILE_MAGIC, sizeof(header.magic));
+    if (fwrite(&header, sizeof(header), 1, fp) != 1) return -1;
+    static const char zeros[4096];
+    for (uint64_t written = sizeof(header); written < SHIFT_REGISTER_FILE_DATA_OFFSET;) {
+        size_t chunk = SHIFT_REGISTER_FILE_DATA_OFFSET - written < sizeof(zeros) ?
+            SHIFT_REGISTER_FILE_DATA_OFFSET - written : sizeof(zeros);
+        if (fwrite(zeros, 1, chunk, fp) != chunk) return -1;
+        written += chunk;
+    }
+    return fwrite(transitions->bucket, 1, header.table_size, fp) == header.table_size ? 0 : -1;
+}
+
+// В файле таблица всегда плотная.
+static int writeShiftRegisterAsBinary(const struct ShiftRegister *reg, FILE *fp) {
+    if (reg->transitions.bucket) return writeTransitionsAsBinary(reg->length, &reg->transitions, fp);
+    BitArray transitions;
+    if (isShiftRegisterSparse(reg)) {
+        if (sparseBitArrayToBitArray(&transitions, &reg->sparse)) return -1;
+    } else {
+        if (initBitArray(&transitions, (uint64_t)1 << (reg->length + 2))) return -1;
+        for (uint64_t state = 0; state < (uint64_t)1 << reg->length; ++state)
+            transitions.bucket[state >> 1] |= getShiftRegisterTransitions(reg, state) << ((state & 1) << 2);
+    }
+    int rc = writeTransitionsAsBinary(reg->length, &transitions, fp);
+    freeBitArray(&transitions);
+    return rc;
+}
+
+int saveShiftRegisterToFile(const struct ShiftRegister* reg, char* settings_file, uint8_t binary) {
+    FILE *fp = fopen(settings_file, "wb");
+    if (!fp) {
+        printf("Не открывается файл %s\n", settings_file);
+        return -1;
+    }
+    int rc;
+    if (binary) rc = writeShiftRegisterAsBinary(reg, fp);
+    else rc = (
+        fprintf(fp, "%" PRIu8 "\n\n", reg->length) < 0 ||
+        writeFunctionAsText(reg, 0, fp) ||
+        fputc('\n', fp) == EOF ||
+        writeFunctionAsText(reg, 2, fp)
+    ) ? -1 : 0;
+    if (fclose(fp)) rc = -1;
+    if (rc) printf("Ошибка при записи файла %s\n", settings_file);
+    return rc;
+}
+
+void initShiftRegisterCursor(struct ShiftRegisterCursor *cursor, const struct ShiftRegister *reg, uint32_t state) {
+    cursor->reg = reg;
+    cursor->state = state & reg->mask;
+}
+
+int readState(struct ShiftRegisterCursor *cursor) {
     printf("Введите начальное состояние: ");
-    reg->state = 0;
-    for (uint8_t i = 0; i < reg->length; ++i) {
+    cursor->state = 0;
+    for (uint8_t i = 0; i < cursor->reg->length; ++i) {
         switch (fgetc(stdin)) {
             case '1':
-                reg->state = (reg->state << 1) | 1;
+                cursor->state = (cursor->state << 1) | 1;
                 break;
             case '0':
-                reg->state = (reg->state << 1);
+                cursor->state = (cursor->state << 1);
                 break;
             case ' ':
             case '\t':
@@ -73,130 +330,81 @@ int readState(struct ShiftRegister* reg) {
     return 0;
 }
 
-uint32_t getState(struct ShiftRegister* reg) {
-    return reg->state;
+uint32_t getState(const struct ShiftRegisterCursor *cursor) {
+    return cursor->state;
 }
 
-uint8_t useShiftRegister(struct ShiftRegister* reg, uint8_t x) {
-    reg->state <<= 1;
-    uint8_t phi = getBitArrayElement(&reg->phi, reg->state | x);
-    uint8_t y = getBitArrayElement(&reg->psi, reg->state | phi);
-    reg->state = (reg->state | phi) & reg->mask;
-    return y;
+uint8_t useShiftRegister(struct ShiftRegisterCursor *cursor, uint8_t x) {
+    const struct ShiftRegister *reg = cursor->reg;
+    uint8_t transitions = getShiftRegisterTransitions(reg, cursor->state);
+    uint8_t phi = (transitions >> x) & 1;
+    cursor->state = (uint32_t)((((uint64_t)cursor->state << 1) | phi) & reg->mask);
+    return getShiftRegisterOutput(transitions, x);
 }
 
-void freeShiftRegister(struct ShiftRegister* reg) {
-    reg->length = 0;
-    freeBitArray(&reg->phi);
-    freeBitArray(&reg->psi);
-}
-
-static uint32_t getStateFunctionValue(struct ShiftRegister* reg, uint32_t state, uint8_t x) {
-    state <<= 1;
-    uint8_t phi = getBitArrayElement(&reg->phi, state | x);
-    return (state | phi) & reg->mask;
-}
-
-static uint8_t getOutputFunctionValue(struct ShiftRegister* reg, uint32_t state, uint8_t x) {
-    state <<= 1;
-    uint8_t phi = getBitArrayElement(&reg->phi, state | x);
-    return getBitArrayElement(&reg->psi, state | phi);
-}
-
-static int minimizationFirstStep(struct ShiftRegister* original, List* first_step) {
-    List **classes = initArrayOfEquivalenceClasses(4);
-    if (!classes) return -1;
-    for (
-        uint32_t state = 0;
-        state <= ((uint32_t)1 << original->length) - 1;
-        ++state
-    ) {
-        uint8_t state_ouput_mask =
-            (getOutputFunctionValue(original, state, 0) << 1) |
-            getOutputFunctionValue(original, state, 1);
-        if (pushList(classes[state_ouput_mask], &state, sizeof(uint32_t))) {
-            freeArrayOfEquivalenceClasses(classes, 4, NULL);
-            return -2;
+// sparse - константа, так что для каждого хранения таблицы получается свой цикл без ветвлений.
+static inline __attribute__((always_inline)) void useTableOnWords(
+    struct ShiftRegisterCursor *cursor,
+    const uint64_t *input,
+    uint64_t *output,
+    uint64_t num_of_bits,
+    uint8_t sparse
+) {
+    const uint8_t *transitions = cursor->reg->transitions.bucket;
+    const SparseBitArray *sparse_transitions = &cursor->reg->sparse;
+    const uint64_t mask = cursor->reg->mask;
+    uint64_t state = cursor->state;
+    for (uint64_t word = 0; word < (num_of_bits + 63) / 64; ++word) {
+        const uint64_t x = input[word];
+        const unsigned bits = num_of_bits - word * 64 < 64 ? (unsigned)(num_of_bits - word * 64) : 64;
+        uint64_t y = 0;
+        for (unsigned i = 0; i < bits; ++i) {
+            const uint8_t nibble = sparse ?
+                getSparseBitArrayNibble(sparse_transitions, state << 2) :
+                transitions[state >> 1] >> ((state & 1) << 2);
+            const uint8_t bit = (x >> i) & 1;
+            const uint64_t phi = (nibble >> bit) & 1;
+            y |= (uint64_t)getShiftRegisterOutput(nibble, bit) << i;
+            state = ((state << 1) | phi) & mask;
         }
+        output[word] = y;
     }
-    if (arrayToListEquivalenceClasses(first_step, classes, 4)) return -3;
-    return 0;
+    cursor->state = (uint32_t)state;
 }
 
-static int putStateIntoNewClass(
-    struct ShiftRegister* original,
-    List *current_step,
-    List **classes,
-    uint32_t state
+void useShiftRegisterOnWords(
+    struct ShiftRegisterCursor *cursor,
+    const uint64_t *input,
+    uint64_t *output,
+    uint64_t num_of_bits
 ) {
-    uint32_t next_state_0 = getStateFunctionValue(original, state, 0);
-    uint32_t next_state_1 = getStateFunctionValue(original, state, 1);
-    uint64_t state_transition_mask = getListSize(current_step) *
-        findEquivalenceClassOfState(current_step, &next_state_0, sizeof(uint32_t)) +
-        findEquivalenceClassOfState(current_step, &next_state_1, sizeof(uint32_t));
-        if (pushList(classes[state_transition_mask], &state, sizeof(uint32_t))) {
-            return -1;
-        }
-    return 0;
-}
-
-static int copyOneStateClass(List *next_step, List *class) {
-    List copy;
-    if (copyList(&copy, class)) return -1;
-    if (pushList(next_step, &copy, sizeof(List))) {
-        clearList(&copy);
-        return -2;
+    if (cursor->reg->small.engine) {
+        cursor->reg->small.engine->useOnWords(cursor, input, output, num_of_bits);
+        return;
     }
-    return 0;
+    if (cursor->reg->linear.is_linear) {
+        useLinearShiftRegisterOnWords(cursor, input, output, num_of_bits);
+        return;
+    }
+    if (cursor->reg->kernel.handle) {
+        cursor->reg->kernel.useOnWords(&cursor->state, input, output, num_of_bits);
+        return;
+    }
+    if (isShiftRegisterSparse(cursor->reg)) useTableOnWords(cursor, input, output, num_of_bits, 1);
+    else useTableOnWords(cursor, input, output, num_of_bits, 0);
 }
 
-static int divideClass(
-    struct ShiftRegister* original,
-    List *current_step,
-    List *next_step,
-    List *class
-) {
-    uint64_t num_of_new_classes =
-        getListSize(current_step) *
-        getListSize(current_step);
-    List **classes = initArrayOfEquivalenceClasses(num_of_new_classes);
-    if (!classes) return -1;
-    struct ListIterator it;
-    setListIteratorNode(&it, getListHead(class));
-    do {
-        if (putStateIntoNewClass(original, current_step, classes, *(uint32_t *)getListIteratorValue(&it))) {
-            freeArrayOfEquivalenceClasses(classes, num_of_new_classes, NULL);
-            return -2;
-        }
-        incListIterator(&it);
-    } while (!compareListIteratorNode(&it, getListHead(class)));
-    List list_of_new_classes;
-    if (arrayToListEquivalenceClasses(
-        &list_of_new_classes, classes, num_of_new_classes
-    )) return -3;
-    transfer(&list_of_new_classes, next_step);
-    return 0;
+void freeShiftRegister(struct ShiftRegister* reg) {
+    reg->length = 0;
+    reg->small.engine = NULL;
+    freeBitArray(&reg->transitions);
+    freeSparseBitArray(&reg->sparse);
+    freeShiftRegisterKernel(&reg->kernel);
 }
 
-static int minimizationStep(
-    struct ShiftRegister* original,
-    List *current_step,
-    List *next_step
-) {
-    struct ListIterator it;
-    setListIteratorNode(&it, getListHead(current_step));
-    do {
-        List *class = getListIteratorValue(&it);
-        if (getListSize(class) == 1) {
-            if (copyOneStateClass(next_step, class)) goto err;
-        } 
-        else if (divideClass(original, current_step, next_step, class)) goto err;
-        incListIterator(&it);
-    } while (!compareListIteratorNode(&it, getListHead(current_step)));
-    return 0;
-err:
-    deepClearList(next_step, (FreeValueFunction)clearList);
-    return -1;
+static uint32_t getStateFunctionValue(const struct ShiftRegister* reg, uint32_t state, uint8_t x) {
+    uint8_t phi = (getShiftRegisterTransitions(reg, state) >> x) & 1;
+    return (uint32_t)((((uint64_t)state << 1) | phi) & reg->mask);
 }
 
 void printState(uint32_t *state) {
@@ -205,59 +413,71 @@ void printState(uint32_t *state) {
 
 int minimizeShiftRegister(
     struct Minimized *minimized,
-    struct ShiftRegister* original
+    const struct ShiftRegister* original
+) {
+    return minimizeShiftRegisterInThreads(minimized, original, 1, MINIMIZE_CLASS_LIST);
+}
+
+int minimizeShiftRegisterInThreads(
+    struct Minimized *minimized,
+    const struct ShiftRegister* original,
+    unsigned num_of_threads,
+    uint8_t flags
 ) {
-    List *current_step = malloc(sizeof(List));
-    if (!current_step) return -1;
-    if (minimizationFirstStep(original, current_step)) {
-        free(current_step);
+    if (original->length > PARTITION_MAX_LENGTH) return -6;
+    initMinimized(minimized, (uint64_t)1 << original->length);
+    minimized->printState = (PrintValue)printState;
+    minimized->freeValue = NULL;
+    if (original->small.engine) {
+        if (!original->small.engine->minimize(minimized, original, flags)) return 0;
+        freeMinimized(minimized);
         return -2;
     }
-    if (getListSize(current_step) == 1) {
-        minimized->equivalence_classes = current_step;
-        minimized->degree_of_distinguishability = 0;
-        minimized->original_is_minimal = 0;
-        minimized->printState = (PrintValue)printState;
-        minimized->freeValue = NULL;
-        return 0;
-    }
+    struct StatePartition partition;
+    if (initOutputPartition(&partition, original, num_of_threads)) return -2;
     int rc = 0;
-    List *next_step = malloc(sizeof(List));
-    if (!next_step) {
-        rc = -4;
-        goto end;
-    }
-    initList(next_step);
-    uint64_t degree_of_distinguishability = 0;
-    while(1)  {
-        ++degree_of_distinguishability;
-        printf("Классы %" PRIu64 " эквивалентности:\n", degree_of_distinguishability);
-        printListOfEquivalenceClasses(current_step, (PrintValue)printState);
-        if (minimizationStep(original, current_step, next_step)) {
-            free(next_step);
-            rc = -5;
+    if (partition.num_of_classes > 1)
+        while (1) {
+            if (addMinimizedRound(minimized, partition.num_of_classes)) {
+                rc = -1;
+                goto end;
+            }
+            if (flags & MINIMIZE_PRINT_ROUNDS) {
+                printf("Классы %" PRIu64 " эквивалентности:\n", minimized->degree_of_distinguishability);
+                printStatePartition(&partition);
+            }
+            const int64_t added = refineStatePartition(&partition, original);
+            if (added < 0) {
+                rc = -5;
+                goto end;
+            }
+            if (!added) break;
+        }
+    minimized->num_of_classes = partition.num_of_classes;
+    minimized->original_is_minimal =
+        minimized->degree_of_distinguishability && partition.num_of_classes == minimized->num_of_states;
+    if (flags & MINIMIZE_CLASS_LIST) {
+        if (!(minimized->equivalence_classes = malloc(sizeof(List)))) {
+            rc = -1;
+            goto end;
+        }
+        if (statePartitionToList(&partition, minimized->equivalence_classes)) {
+            free(minimized->equivalence_classes);
+            minimized->equivalence_classes = NULL;
+            rc = -4;
             goto end;
         }
-        if (getListSize(next_step) == getListSize(current_step)) break;
-        deepClearList(current_step, (FreeValueFunction)clearList);
-        List *temp = current_step;
-        current_step = next_step;
-        next_step = temp;
     }
-    minimized->equivalence_classes = next_step;
-    minimized->degree_of_distinguishability = degree_of_distinguishability;
-    minimized->original_is_minimal =
-        getListSize(minimized->equivalence_classes) ==
-        (uint64_t)1 << original->length;
-    minimized->printState = (PrintValue)printState;
-    minimized->freeValue = NULL;
+    if (flags & MINIMIZE_CLASS_ARRAY)
+        minimized->class_of = takeStatePartitionClasses(&partition, &minimized->class_of_kind);
 end:
-    deepClearList(current_step, (FreeValueFunction)clearList);
-    free(current_step);
+    freeStatePartition(&partition);
+    if (rc) freeMinimized(minimized);
     return rc;
 }
 
-int shiftRegisterToGraph(struct ShiftRegister *reg, struct Graph *graph) {
+int shiftRegisterToGraph(const struct ShiftRegister *reg, struct Graph *graph) {
+    if (reg->small.engine) return reg->small.engine->toGraph(reg, graph);
     if (initGraph(graph, (uint64_t)1 << reg->length)) return -1;
     for (uint32_t i = 0; i <= ((uint32_t)1 << reg->length) - 1; ++i) {
         setOrDeleteEdge(graph, i, getStateFunctionValue(reg, i, 0), 1);
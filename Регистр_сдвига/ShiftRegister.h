@@ -2,24 +2,139 @@
 #define SHIFT_REGISTER_H
 
 #include "BitArray.h"
+#include "SparseBitArray.h"
 #include "Graph.h"
 #include "Minimized.h"
 
+// Коэффициенты аффинных phi и psi: бит 0 - при втором аргументе, бит i + 1 - при
+// бите i состояния (см. LinearShiftRegister.h).
+struct LinearFeedback {
+    uint8_t is_linear;
+    uint8_t phi_constant;
+    uint8_t psi_constant;
+    uint64_t phi;
+    uint64_t psi;
+};
+
+// Для коротких регистров таблицы дополнительно хранятся в словах (бит state
+// слова phi[x] - phi(state, x), то же для psi), а engine указывает на
+// специализацию под длину (см. SmallShiftRegister.h). Для остальных engine = NULL.
+struct SmallEngine;
+struct SmallTables {
+    const struct SmallEngine *engine;
+    uint64_t phi[2];
+    uint64_t psi[2];
+};
+
+// Функции, вычисляемые кодом, сгенерированным под конкретный регистр и загруженным
+// из разделяемой библиотеки (см. GeneratedShiftRegister.h). Если handle != NULL,
+// таблица не строится вовсе.
+struct ShiftRegisterKernel {
+    void *handle;
+    uint8_t (*transitions)(uint32_t state);
+    void (*useOnWords)(uint32_t *state, const uint64_t *input, uint64_t *output, uint64_t num_of_bits);
+};
+
+// Таблицы phi и psi хранятся перемежёнными: для каждого состояния state
+// полубайт содержит phi(state, 0), phi(state, 1), psi(state, 0), psi(state, 1),
+// так что одно обращение к памяти даёт и следующий бит, и оба кандидата на выход.
+// Если единиц в таблице мало, она хранится в sparse (см. initSparseTransitions),
+// а transitions пуст. Пуст он и у регистра, заданного kernel.
 struct ShiftRegister {
     uint8_t length;
-    BitArray phi;
-    BitArray psi;
-    uint32_t state;
+    BitArray transitions;
+    SparseBitArray sparse;
+    struct ShiftRegisterKernel kernel;
     uint32_t mask;
+    struct LinearFeedback linear;
+    struct SmallTables small;
+};
+
+// Изменение таблицы: новый полубайт transitions состояния state.
+struct TransitionChange {
+    uint32_t state;
+    uint8_t transitions;
 };
 
+// Изменяемая часть регистра. Сам регистр после загрузки только читается,
+// поэтому одним загруженным регистром могут одновременно пользоваться
+// курсоры разных потоков.
+struct ShiftRegisterCursor {
+    const struct ShiftRegister *reg;
+    uint32_t state;
+};
+
+static inline uint8_t isShiftRegisterSparse(const struct ShiftRegister *reg) {
+    return reg->sparse.ranks != NULL;
+}
+
+static inline uint8_t getShiftRegisterTransitions(const struct ShiftRegister *reg, uint64_t state) {
+    if (reg->transitions.bucket) return (reg->transitions.bucket[state >> 1] >> ((state & 1) << 2)) & 0xF;
+    if (isShiftRegisterSparse(reg)) return getSparseBitArrayNibble(&reg->sparse, state << 2);
+    return reg->kernel.transitions((uint32_t)state);
+}
+
+// Выход в состоянии с набором переходов transitions при входе x.
+static inline uint8_t getShiftRegisterOutput(uint8_t transitions, uint8_t x) {
+    return (transitions >> (2 + ((transitions >> x) & 1))) & 1;
+}
+
+// (выход при x = 0) * 2 + выход при x = 1.
+static inline uint8_t getShiftRegisterOutputs(uint8_t transitions) {
+    return (uint8_t)(getShiftRegisterOutput(transitions, 0) << 1 | getShiftRegisterOutput(transitions, 1));
+}
+
+// Значения phi и psi на индексе (state << 1) | bit.
+static inline uint8_t getPhiValue(const struct ShiftRegister *reg, uint64_t index) {
+    return (getShiftRegisterTransitions(reg, index >> 1) >> (index & 1)) & 1;
+}
+
+static inline uint8_t getPsiValue(const struct ShiftRegister *reg, uint64_t index) {
+    return (getShiftRegisterTransitions(reg, index >> 1) >> (2 + (index & 1))) & 1;
+}
+
+// Принимает как текстовый файл настроек, так и двоичный (см. saveShiftRegisterToFile),
+// файл многочленов (см. ANFShiftRegister.h) длины не более 32 или разделяемую
+// библиотеку со сгенерированным кодом (см. GeneratedShiftRegister.h).
 int initShiftRegisterFromFile(struct ShiftRegister* reg, char* settings_file);
-int readState(struct ShiftRegister* reg);
-uint32_t getState(struct ShiftRegister* reg);
-uint8_t useShiftRegister(struct ShiftRegister* reg, uint8_t x);
+// Сохраняет регистр в текстовом формате или, если binary != 0, в двоичном, таблица
+// которого при загрузке отображается в память напрямую.
+int saveShiftRegisterToFile(const struct ShiftRegister* reg, char* settings_file, uint8_t binary);
+// Переводит таблицу в разреженное хранение, если она не помещается в кэш последнего
+// уровня, а доля единиц в ней не больше 1/2^SPARSE_TRANSITIONS_DENSITY_SHIFT.
+// Пока плотная таблица помещается в кэш, она быстрее. Вызывается при загрузке.
+#define SPARSE_TRANSITIONS_DENSITY_SHIFT 6
+void initSparseTransitions(struct ShiftRegister *reg);
+// Записывает изменения в плотную таблицу (разреженная сначала разворачивается) и
+// обновляет то, что из неё выведено при загрузке (короткие таблицы, признак
+// линейности). Курсоры регистра в это время работать не должны. Для регистра из
+// kernel и при нехватке памяти возвращает -1.
+int changeShiftRegisterTransitions(
+    struct ShiftRegister *reg, const struct TransitionChange *changes, uint64_t num_of_changes
+);
+void initShiftRegisterCursor(struct ShiftRegisterCursor *cursor, const struct ShiftRegister *reg, uint32_t state);
+int readState(struct ShiftRegisterCursor *cursor);
+uint32_t getState(const struct ShiftRegisterCursor *cursor);
+uint8_t useShiftRegister(struct ShiftRegisterCursor *cursor, uint8_t x);
+// Обрабатывает num_of_bits входных битов, упакованных по 64 в слово (младший бит первый).
+// Выход упаковывается так же, неиспользованные старшие биты последнего слова обнуляются.
+void useShiftRegisterOnWords(
+    struct ShiftRegisterCursor *cursor,
+    const uint64_t *input,
+    uint64_t *output,
+    uint64_t num_of_bits
+);
 void freeShiftRegister(struct ShiftRegister* reg);
-int shiftRegisterToGraph(struct ShiftRegister *reg, struct Graph *graph);
-int minimizeShiftRegister(struct Minimized *minimized, struct ShiftRegister* original);
+int shiftRegisterToGraph(const struct ShiftRegister *reg, struct Graph *graph);
+// Без вывода шагов, строится только список классов.
+int minimizeShiftRegister(struct Minimized *minimized, const struct ShiftRegister* original);
+// То же, но каждый шаг (ключи состояний, их сортировка, новые номера классов)
+// делится между num_of_threads потоками. Результат от числа потоков не зависит.
+// flags - MINIMIZE_* из Minimized.h. Регистр длины 32 не принимается (возвращается -6),
+// его минимизирует minimizeShiftRegisterExternally.
+int minimizeShiftRegisterInThreads(
+    struct Minimized *minimized, const struct ShiftRegister* original, unsigned num_of_threads, uint8_t flags
+);
 void printState(uint32_t *state);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,224 @@
+#include "SmallShiftRegister.h"
+#include "Alloc.h"
+#include <inttypes.h>
+#include <stdlib.h>
+
+// Общие тела движков. Вызываются только из специализаций ниже с постоянной
+// length, так что после встраивания маски и границы циклов становятся константами.
+#define SMALL_INLINE static inline __attribute__((always_inline))
+
+SMALL_INLINE uint64_t getAllStates(uint8_t length) {
+    return length == 6 ? ~(uint64_t)0 : ((uint64_t)1 << (1u << length)) - 1;
+}
+
+SMALL_INLINE void useSmallOnWords(
+    uint8_t length,
+    struct ShiftRegisterCursor *cursor,
+    const uint64_t *input,
+    uint64_t *output,
+    uint64_t num_of_bits
+) {
+    const struct SmallTables *small = &cursor->reg->small;
+    const uint64_t phi0 = small->phi[0], phi_difference = small->phi[0] ^ small->phi[1];
+    const uint64_t psi0 = small->psi[0], psi_difference = small->psi[0] ^ small->psi[1];
+    const uint64_t mask = ((uint64_t)1 << length) - 1;
+    uint64_t state = cursor->state;
+    for (uint64_t word = 0; word < num_of_bits / 64; ++word) {
+        const uint64_t x = input[word];
+        uint64_t y = 0;
+        for (unsigned i = 0; i < 64; ++i) {
+            const uint64_t phi = ((phi0 ^ (phi_difference & -((x >> i) & 1))) >> state) & 1;
+            y |= (((psi0 ^ (psi_difference & -phi)) >> state) & 1) << i;
+            state = ((state << 1) | phi) & mask;
+        }
+        output[word] = y;
+    }
+    if (num_of_bits % 64) {
+        const uint64_t x = input[num_of_bits / 64];
+        uint64_t y = 0;
+        for (unsigned i = 0; i < num_of_bits % 64; ++i) {
+            const uint64_t phi = ((phi0 ^ (phi_difference & -((x >> i) & 1))) >> state) & 1;
+            y |= (((psi0 ^ (psi_difference & -phi)) >> state) & 1) << i;
+            state = ((state << 1) | phi) & mask;
+        }
+        output[num_of_bits / 64] = y;
+    }
+    cursor->state = (uint32_t)state;
+}
+
+SMALL_INLINE void getNextStates(uint8_t length, const struct SmallTables *small, uint8_t next[2][64]) {
+    for (unsigned state = 0; state < 1u << length; ++state)
+        for (unsigned x = 0; x < 2; ++x)
+            next[x][state] = (uint8_t)(((state << 1) | ((small->phi[x] >> state) & 1)) & ((1u << length) - 1));
+}
+
+static void printSmallClasses(const uint64_t *classes, unsigned num_of_classes) {
+    for (unsigned i = 0; i < num_of_classes; ++i) {
+        printf("\t{ ");
+        for (uint64_t m = classes[i]; m; m &= m - 1) printf("%d ", __builtin_ctzll(m));
+        printf("}\n");
+    }
+}
+
+static int smallClassesToList(List **list, const uint64_t *classes, unsigned num_of_classes) {
+    if (!(*list = malloc(sizeof(List)))) return -1;
+    initList(*list);
+    for (unsigned i = 0; i < num_of_classes; ++i) {
+        List class;
+        initList(&class);
+        for (uint64_t m = classes[i]; m; m &= m - 1) {
+            uint32_t state = (uint32_t)__builtin_ctzll(m);
+            if (pushList(&class, &state, sizeof(uint32_t))) {
+                clearList(&class);
+                goto error;
+            }
+        }
+        if (pushList(*list, &class, sizeof(List))) {
+            clearList(&class);
+            goto error;
+        }
+    }
+    return 0;
+error:
+    deepClearList(*list, (FreeValueFunction)clearList);
+    free(*list);
+    *list = NULL;
+    return -1;
+}
+
+unsigned getSmallOutputClasses(uint8_t length, const struct SmallTables *small, uint64_t *classes) {
+    const uint64_t all = getAllStates(length);
+    // Выход при входе x: psi(state, phi(state, x)).
+    const uint64_t out0 = (small->psi[0] & ~small->phi[0]) | (small->psi[1] & small->phi[0]);
+    const uint64_t out1 = (small->psi[0] & ~small->phi[1]) | (small->psi[1] & small->phi[1]);
+    const uint64_t first_step[4] = {
+        ~out0 & ~out1 & all, ~out0 & out1 & all, out0 & ~out1 & all, out0 & out1 & all
+    };
+    unsigned num_of_classes = 0;
+    for (unsigned i = 0; i < 4; ++i)
+        if (first_step[i]) classes[num_of_classes++] = first_step[i];
+    return num_of_classes;
+}
+
+unsigned refineSmallClasses(
+    const uint8_t next[2][64],
+    const uint64_t *classes,
+    unsigned num_of_classes,
+    uint64_t *next_classes
+) {
+    uint8_t class_of[64];
+    uint16_t keys[64];
+    unsigned num_of_next_classes = 0;
+    for (unsigned c = 0; c < num_of_classes; ++c)
+        for (uint64_t m = classes[c]; m; m &= m - 1) class_of[__builtin_ctzll(m)] = (uint8_t)c;
+    for (unsigned c = 0; c < num_of_classes; ++c) {
+        uint64_t rest = classes[c];
+        for (uint64_t m = rest; m; m &= m - 1) {
+            const unsigned state = __builtin_ctzll(m);
+            keys[state] = (uint16_t)(class_of[next[0][state]] * num_of_classes + class_of[next[1][state]]);
+        }
+        while (rest) {
+            uint16_t key = UINT16_MAX;
+            for (uint64_t m = rest; m; m &= m - 1)
+                if (keys[__builtin_ctzll(m)] < key) key = keys[__builtin_ctzll(m)];
+            uint64_t subclass = 0;
+            for (uint64_t m = rest; m; m &= m - 1)
+                if (keys[__builtin_ctzll(m)] == key) subclass |= m & -m;
+            next_classes[num_of_next_classes++] = subclass;
+            rest &= ~subclass;
+        }
+    }
+    return num_of_next_classes;
+}
+
+static int smallClassesToArray(struct Minimized *minimized, const uint64_t *classes, unsigned num_of_classes) {
+    if (!(minimized->class_of = allocLarge(minimized->num_of_states * sizeof(uint32_t), &minimized->class_of_kind)))
+        return -1;
+    for (unsigned i = 0; i < num_of_classes; ++i)
+        for (uint64_t m = classes[i]; m; m &= m - 1) minimized->class_of[__builtin_ctzll(m)] = i;
+    return 0;
+}
+
+// То же разбиение и тот же вывод, что у minimizeShiftRegister: классы - маски
+// состояний, порядок подклассов - по номеру пары классов следующих состояний.
+SMALL_INLINE int minimizeSmall(
+    uint8_t length, struct Minimized *minimized, const struct ShiftRegister *reg, uint8_t flags
+) {
+    uint8_t next[2][64];
+    uint64_t classes[64], next_classes[64];
+    unsigned num_of_classes, num_of_next_classes;
+    getNextStates(length, &reg->small, next);
+    num_of_classes = num_of_next_classes = getSmallOutputClasses(length, &reg->small, classes);
+    const uint64_t *result = classes;
+    if (num_of_classes > 1) {
+        while (1) {
+            if (addMinimizedRound(minimized, num_of_classes)) return -1;
+            if (flags & MINIMIZE_PRINT_ROUNDS) {
+                printf("Классы %" PRIu64 " эквивалентности:\n", minimized->degree_of_distinguishability);
+                printSmallClasses(classes, num_of_classes);
+            }
+            num_of_next_classes = refineSmallClasses(next, classes, num_of_classes, next_classes);
+            if (num_of_next_classes == num_of_classes) break;
+            memcpy(classes, next_classes, num_of_next_classes * sizeof(uint64_t));
+            num_of_classes = num_of_next_classes;
+        }
+        result = next_classes;
+    }
+    minimized->num_of_classes = num_of_next_classes;
+    minimized->original_is_minimal =
+        minimized->degree_of_distinguishability && num_of_next_classes == 1u << length;
+    if ((flags & MINIMIZE_CLASS_LIST) && smallClassesToList(&minimized->equivalence_classes, result, num_of_next_classes))
+        return -1;
+    if ((flags & MINIMIZE_CLASS_ARRAY) && smallClassesToArray(minimized, result, num_of_next_classes)) return -1;
+    return 0;
+}
+
+SMALL_INLINE int smallToGraph(uint8_t length, const struct ShiftRegister *reg, struct Graph *graph) {
+    uint8_t next[2][64];
+    getNextStates(length, &reg->small, next);
+    if (initGraph(graph, (uint64_t)1 << length)) return -1;
+    for (unsigned state = 0; state < 1u << length; ++state) {
+        setOrDeleteEdge(graph, state, next[0][state], 1);
+        setOrDeleteEdge(graph, state, next[1][state], 1);
+    }
+    return 0;
+}
+
+#define DEFINE_SMALL_ENGINE(L) \
+    static void useOnWords##L( \
+        struct ShiftRegisterCursor *cursor, const uint64_t *input, uint64_t *output, uint64_t num_of_bits \
+    ) { useSmallOnWords(L, cursor, input, output, num_of_bits); } \
+    static int minimize##L(struct Minimized *minimized, const struct ShiftRegister *reg, uint8_t flags) { \
+        return minimizeSmall(L, minimized, reg, flags); \
+    } \
+    static int toGraph##L(const struct ShiftRegister *reg, struct Graph *graph) { \
+        return smallToGraph(L, reg, graph); \
+    }
+
+DEFINE_SMALL_ENGINE(0)
+DEFINE_SMALL_ENGINE(1)
+DEFINE_SMALL_ENGINE(2)
+DEFINE_SMALL_ENGINE(3)
+DEFINE_SMALL_ENGINE(4)
+DEFINE_SMALL_ENGINE(5)
+DEFINE_SMALL_ENGINE(6)
+
+#define SMALL_ENGINE(L) {L, useOnWords##L, minimize##L, toGraph##L}
+
+static const struct SmallEngine small_engines[SMALL_SHIFT_REGISTER_MAX_LENGTH + 1] = {
+    SMALL_ENGINE(0), SMALL_ENGINE(1), SMALL_ENGINE(2), SMALL_ENGINE(3),
+    SMALL_ENGINE(4), SMALL_ENGINE(5), SMALL_ENGINE(6)
+};
+
+void initSmallEngine(struct ShiftRegister *reg) {
+    memset(&reg->small, 0, sizeof(reg->small));
+    if (reg->length > SMALL_SHIFT_REGISTER_MAX_LENGTH) return;
+    for (uint64_t state = 0; state < (uint64_t)1 << reg->length; ++state) {
+        const uint8_t nibble = getShiftRegisterTransitions(reg, state);
+        for (uint8_t x = 0; x < 2; ++x) {
+            reg->small.phi[x] |= (uint64_t)((nibble >> x) & 1) << state;
+            reg->small.psi[x] |= (uint64_t)((nibble >> (2 + x)) & 1) << state;
+        }
+    }
+    reg->small.engine = &small_engines[reg->length];
+}
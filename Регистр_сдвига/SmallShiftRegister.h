@@ -0,0 +1,38 @@
+#ifndef SMALL_SHIFT_REGISTER_H
+#define SMALL_SHIFT_REGISTER_H
+
+#include "ShiftRegister.h"
+
+// При length <= 6 каждая из функций phi(., x), psi(., x) - одно 64-битное слово.
+#define SMALL_SHIFT_REGISTER_MAX_LENGTH 6
+
+// Движок, собранный под конкретную длину: маски и размеры массивов - константы
+// времени компиляции, таблицы лежат в регистрах процессора, куча не используется.
+struct SmallEngine {
+    uint8_t length;
+    void (*useOnWords)(
+        struct ShiftRegisterCursor *cursor,
+        const uint64_t *input,
+        uint64_t *output,
+        uint64_t num_of_bits
+    );
+    int (*minimize)(struct Minimized *minimized, const struct ShiftRegister *reg, uint8_t flags);
+    int (*toGraph)(const struct ShiftRegister *reg, struct Graph *graph);
+};
+
+// Заполняет reg->small по таблице transitions. Вызывается при загрузке регистра;
+// useShiftRegisterOnWords, minimizeShiftRegister и shiftRegisterToGraph
+// переключаются на специализацию сами.
+void initSmallEngine(struct ShiftRegister *reg);
+// Шаги минимизации без вывода, классы - маски состояний. Первый делит состояния по
+// выходам при x = 0 и x = 1, второй - по классам следующих состояний (next[x][state]).
+// Возвращают число классов.
+unsigned getSmallOutputClasses(uint8_t length, const struct SmallTables *small, uint64_t *classes);
+unsigned refineSmallClasses(
+    const uint8_t next[2][64],
+    const uint64_t *classes,
+    unsigned num_of_classes,
+    uint64_t *next_classes
+);
+
+#endif
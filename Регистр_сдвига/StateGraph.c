@@ -0,0 +1,235 @@
+#include "StateGraph.h"
+#include "Graph.h"
+#include <stdlib.h>
+#include <inttypes.h>
+
+enum Direction {
+    DIRECTION_FORWARD,
+    DIRECTION_BACKWARD,
+    DIRECTION_BOTH
+};
+
+// Соседи в порядке возрастания, как их перебирает обход по матрице смежности.
+static uint8_t getNeighbours(
+    const struct ShiftRegister *reg, uint32_t state, enum Direction direction, uint32_t *neighbours
+) {
+    if (direction == DIRECTION_FORWARD) return getShiftRegisterSuccessors(reg, state, neighbours);
+    if (direction == DIRECTION_BACKWARD) return getShiftRegisterPredecessors(reg, state, neighbours);
+    uint32_t successors[2], predecessors[2];
+    const uint8_t num_of_successors = getShiftRegisterSuccessors(reg, state, successors);
+    const uint8_t num_of_predecessors = getShiftRegisterPredecessors(reg, state, predecessors);
+    uint8_t count = 0, i = 0, j = 0;
+    while (i < num_of_successors || j < num_of_predecessors) {
+        uint32_t next;
+        if (j == num_of_predecessors || (i < num_of_successors && successors[i] < predecessors[j]))
+            next = successors[i++];
+        else if (i == num_of_successors || predecessors[j] < successors[i])
+            next = predecessors[j++];
+        else {
+            next = successors[i++];
+            ++j;
+        }
+        neighbours[count++] = next;
+    }
+    return count;
+}
+
+// Кадр обхода в глубину: соседи не хранятся, а пересчитываются при возврате,
+// поэтому стек занимает 8 байт на уровень.
+struct Frame {
+    uint32_t state;
+    uint32_t next;
+};
+
+struct Search {
+    const struct ShiftRegister *reg;
+    enum Direction direction;
+    BitArray visited;
+    struct Frame *stack;
+    uint64_t capacity;
+    // Для обхода, строящего порядок выхода (см. invertedDeepFirstSearch в Graph.c).
+    uint32_t *finished;
+    uint64_t num_of_finished;
+};
+
+static int initSearch(struct Search *search, const struct ShiftRegister *reg, uint8_t with_order) {
+    const uint64_t num_of_states = (uint64_t)1 << reg->length;
+    search->reg = reg;
+    search->capacity = 1024;
+    search->stack = malloc(search->capacity * sizeof(struct Frame));
+    search->finished = with_order ? malloc(num_of_states * sizeof(uint32_t)) : NULL;
+    search->num_of_finished = 0;
+    if (!search->stack || (with_order && !search->finished) || initBitArray(&search->visited, num_of_states)) {
+        free(search->stack);
+        free(search->finished);
+        return -1;
+    }
+    return 0;
+}
+
+static void freeSearch(struct Search *search) {
+    freeBitArray(&search->visited);
+    free(search->stack);
+    free(search->finished);
+}
+
+static void clearVisited(struct Search *search) {
+    memset(search->visited.bucket, 0, (search->visited.length + 7) / 8);
+}
+
+// Повторяет рекурсивные deepFirstSearch и invertedDeepFirstSearch из Graph.c без
+// рекурсии: тот же порядок посещения, те же строки журнала. Если component != NULL,
+// состояния добавляются в него при входе, иначе - в finished при выходе.
+static int searchFrom(struct Search *search, uint32_t start, List *component, const char *name) {
+    uint64_t depth = 0;
+    search->stack[depth++] = (struct Frame){start, 0};
+    setBitArrayElement(&search->visited, start, 1);
+    uint64_t node = start;
+    if (component && pushList(component, &node, sizeof(uint64_t))) return -1;
+    printSearchLog("%s вход. Текущее состояение: %" PRIu64 "\n", name, node);
+    while (depth) {
+        struct Frame *frame = search->stack + depth - 1;
+        uint32_t neighbours[4];
+        const uint8_t count = getNeighbours(search->reg, frame->state, search->direction, neighbours);
+        while (frame->next < count && getBitArrayElement(&search->visited, neighbours[frame->next])) ++frame->next;
+        if (frame->next == count) {
+            node = frame->state;
+            printSearchLog("%s выход. Текущее состояение: %" PRIu64 "\n", name, node);
+            if (!component) search->finished[search->num_of_finished++] = frame->state;
+            --depth;
+            continue;
+        }
+        const uint32_t next = neighbours[frame->next++];
+        if (depth == search->capacity) {
+            struct Frame *stack = realloc(search->stack, 2 * search->capacity * sizeof(struct Frame));
+            if (!stack) return -2;
+            search->stack = stack;
+            search->capacity *= 2;
+        }
+        search->stack[depth++] = (struct Frame){next, 0};
+        setBitArrayElement(&search->visited, next, 1);
+        node = next;
+        if (component && pushList(component, &node, sizeof(uint64_t))) return -1;
+        printSearchLog("%s вход. Текущее состояение: %" PRIu64 "\n", name, node);
+    }
+    return 0;
+}
+
+// Компоненты в порядке order (или по возрастанию, если order = NULL).
+static int collectComponents(
+    struct Search *search,
+    const uint32_t *order,
+    uint64_t num_of_states,
+    List *components
+) {
+    initList(components);
+    for (uint64_t i = 0; i < num_of_states; ++i) {
+        const uint64_t state = order ? order[num_of_states - 1 - i] : i;
+        if (order) printSearchLog("getStronglyConnectedComponents. Текущее состояние: %" PRIu64 "\n", state);
+        if (getBitArrayElement(&search->visited, state)) continue;
+        List component;
+        initList(&component);
+        if (
+            searchFrom(search, (uint32_t)state, &component, "deepFirstSearch") ||
+            pushList(components, &component, sizeof(List))
+        ) {
+            clearList(&component);
+            deepClearList(components, (FreeValueFunction)clearList);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int getShiftRegisterStronglyConnectedComponents(const struct ShiftRegister *reg, List *components) {
+    const uint64_t num_of_states = (uint64_t)1 << reg->length;
+    struct Search search;
+    if (initSearch(&search, reg, 1)) return -1;
+    int rc = 0;
+    search.direction = DIRECTION_FORWARD;
+    for (uint64_t state = 0; state < num_of_states; ++state)
+        if (
+            !getBitArrayElement(&search.visited, state) &&
+            searchFrom(&search, (uint32_t)state, NULL, "invertedDeepFirstSearch")
+        ) {
+            rc = -2;
+            goto end;
+        }
+    clearVisited(&search);
+    search.direction = DIRECTION_BACKWARD;
+    if (collectComponents(&search, search.finished, num_of_states, components)) rc = -3;
+end:
+    freeSearch(&search);
+    return rc;
+}
+
+int getShiftRegisterComponents(const struct ShiftRegister *reg, List *components) {
+    struct Search search;
+    if (initSearch(&search, reg, 0)) return -1;
+    search.direction = DIRECTION_BOTH;
+    int rc = collectComponents(&search, NULL, (uint64_t)1 << reg->length, components) ? -2 : 0;
+    freeSearch(&search);
+    return rc;
+}
+
+int getBackwardReachableStates(
+    const struct ShiftRegister *reg,
+    const uint32_t *targets,
+    uint64_t num_of_targets,
+    BitArray *reachable
+) {
+    const uint64_t num_of_states = (uint64_t)1 << reg->length;
+    if (initBitArray(reachable, num_of_states)) return -1;
+    // Каждое состояние попадает в очередь не больше одного раза.
+    uint32_t *queue = malloc(num_of_states * sizeof(uint32_t));
+    if (!queue) {
+        freeBitArray(reachable);
+        return -2;
+    }
+    uint64_t head = 0, tail = 0;
+    for (uint64_t i = 0; i < num_of_targets; ++i)
+        if (!getBitArrayElement(reachable, targets[i] & reg->mask)) {
+            setBitArrayElement(reachable, targets[i] & reg->mask, 1);
+            queue[tail++] = targets[i] & reg->mask;
+        }
+    while (head < tail) {
+        uint32_t predecessors[2];
+        const uint8_t count = getShiftRegisterPredecessors(reg, queue[head++], predecessors);
+        for (uint8_t i = 0; i < count; ++i)
+            if (!getBitArrayElement(reachable, predecessors[i])) {
+                setBitArrayElement(reachable, predecessors[i], 1);
+                queue[tail++] = predecessors[i];
+            }
+    }
+    free(queue);
+    return 0;
+}
+
+int getGardenOfEdenStates(const struct ShiftRegister *reg, BitArray *states, uint64_t *count) {
+    const uint64_t num_of_states = (uint64_t)1 << reg->length;
+    if (initBitArray(states, num_of_states)) return -1;
+    *count = 0;
+    for (uint64_t state = 0; state < num_of_states; ++state) {
+        uint32_t predecessors[2];
+        if (!getShiftRegisterPredecessors(reg, (uint32_t)state, predecessors)) {
+            setBitArrayElement(states, state, 1);
+            ++*count;
+        }
+    }
+    return 0;
+}
+
+void printShiftRegisterGraph(const struct ShiftRegister *reg) {
+    const uint64_t num_of_states = (uint64_t)1 << reg->length;
+    for (uint64_t state = 0; state < num_of_states; ++state) {
+        uint32_t successors[2];
+        const uint8_t count = getShiftRegisterSuccessors(reg, (uint32_t)state, successors);
+        uint8_t k = 0;
+        for (uint64_t j = 0; j < num_of_states; ++j) {
+            uint8_t edge = k < count && successors[k] == j;
+            if (edge) ++k;
+            printf("%" PRIu8 "", edge);
+        }
+        printf("\n");
+    }
+}
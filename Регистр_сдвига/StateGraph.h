@@ -0,0 +1,81 @@
+#ifndef STATE_GRAPH_H
+#define STATE_GRAPH_H
+
+#include "ShiftRegister.h"
+
+// Граф переходов регистра не строится: из state ведут рёбра только в
+// (state << 1) | phi(state, x), а входят только из state >> 1 и
+// (state >> 1) | 1 << (length - 1), так что соседи любого состояния вычисляются
+// по таблице за O(1), а обходы графа занимают O(2^length) времени и памяти
+// вместо O(4^length) у матрицы смежности (см. Graph.h).
+
+// Предшественники state при входе x (не больше двух, по возрастанию).
+static inline uint8_t getShiftRegisterPredecessorsOnInput(
+    const struct ShiftRegister *reg, uint32_t state, uint8_t x, uint32_t *predecessors
+) {
+    if (!reg->length) {
+        predecessors[0] = 0;
+        return 1;
+    }
+    uint8_t count = 0;
+    for (uint32_t b = 0; b < 2; ++b) {
+        const uint32_t predecessor = (state >> 1) | (b << (reg->length - 1));
+        if (getPhiValue(reg, ((uint64_t)predecessor << 1) | x) == (state & 1))
+            predecessors[count++] = predecessor;
+    }
+    return count;
+}
+
+// Предшественники при каком-либо входе (не больше двух, по возрастанию).
+static inline uint8_t getShiftRegisterPredecessors(
+    const struct ShiftRegister *reg, uint32_t state, uint32_t *predecessors
+) {
+    if (!reg->length) {
+        predecessors[0] = 0;
+        return 1;
+    }
+    uint8_t count = 0;
+    for (uint32_t b = 0; b < 2; ++b) {
+        const uint32_t predecessor = (state >> 1) | (b << (reg->length - 1));
+        const uint8_t phi = getShiftRegisterTransitions(reg, predecessor) & 3;
+        // phi(predecessor, 0) и phi(predecessor, 1) - биты 0 и 1, нужен бит state & 1.
+        if (state & 1 ? phi : phi != 3) predecessors[count++] = predecessor;
+    }
+    return count;
+}
+
+// Последователи (не больше двух, по возрастанию).
+static inline uint8_t getShiftRegisterSuccessors(
+    const struct ShiftRegister *reg, uint32_t state, uint32_t *successors
+) {
+    const uint8_t phi = getShiftRegisterTransitions(reg, state) & 3;
+    const uint32_t base = (uint32_t)(((uint64_t)state << 1) & reg->mask);
+    if (phi == 0 || phi == 3) {
+        successors[0] = base | (phi & 1 & reg->mask);
+        return 1;
+    }
+    successors[0] = base;
+    successors[1] = base | (1 & reg->mask);
+    return successors[0] == successors[1] ? 1 : 2;
+}
+
+// Отмечает в reachable (массив инициализируется здесь) состояния, из которых при
+// каких-либо входах достижимо хотя бы одно из targets, включая сами targets.
+int getBackwardReachableStates(
+    const struct ShiftRegister *reg,
+    const uint32_t *targets,
+    uint64_t num_of_targets,
+    BitArray *reachable
+);
+// Отмечает состояния, в которые нельзя попасть ни из какого состояния ни при каком
+// входе ("Сад Эдема"). Возвращает их число в *count.
+int getGardenOfEdenStates(const struct ShiftRegister *reg, BitArray *states, uint64_t *count);
+// То же, что getStronglyConnectedComponents и getComponents над графом из
+// shiftRegisterToGraph (включая порядок компонент, состояний в них и журнал поиска),
+// но без матрицы смежности. Элементы компонент - uint64_t.
+int getShiftRegisterStronglyConnectedComponents(const struct ShiftRegister *reg, List *components);
+int getShiftRegisterComponents(const struct ShiftRegister *reg, List *components);
+// Матрица смежности в формате printGraph.
+void printShiftRegisterGraph(const struct ShiftRegister *reg);
+
+#endif
@@ -0,0 +1,371 @@
+#include "SymbolicShiftRegister.h"
+#include <inttypes.h>
+#include <math.h>
+#include <stdlib.h>
+
+#define SYMBOLIC_INITIAL_NODES ((uint32_t)1 << 20)
+#define SYMBOLIC_INITIAL_CACHE ((uint32_t)1 << 18)
+
+static inline uint32_t getNumOfVars(const struct SymbolicShiftRegister *sym) {
+    return 2u * sym->length + 1;
+}
+
+static inline uint32_t getInputVar(const struct SymbolicShiftRegister *sym) {
+    return 2u * sym->length;
+}
+
+// Заменяет захваченное *target на value, захватывая его.
+static int replaceBDD(BDDManager *manager, BDD *target, BDD value) {
+    if (value == BDD_ERROR) return -1;
+    refBDD(manager, value);
+    derefBDD(manager, *target);
+    *target = value;
+    return 0;
+}
+
+static BDD *copyMap(const struct SymbolicShiftRegister *sym, const BDD *map) {
+    BDD *copy = malloc(getNumOfVars(sym) * sizeof(BDD));
+    if (copy) memcpy(copy, map, getNumOfVars(sym) * sizeof(BDD));
+    return copy;
+}
+
+static int makeCube(struct SymbolicShiftRegister *sym, BDD *cube, uint8_t primed, uint8_t with_state) {
+    uint32_t vars[2 * ANF_SHIFT_REGISTER_MAX_LENGTH + 1], num_of_vars = 0;
+    if (with_state)
+        for (uint8_t i = 0; i < sym->length; ++i) vars[num_of_vars++] = 2u * i + primed;
+    vars[num_of_vars++] = getInputVar(sym);
+    return replaceBDD(&sym->manager, cube, makeBDDCube(&sym->manager, vars, num_of_vars));
+}
+
+static int initEmptySymbolicShiftRegister(struct SymbolicShiftRegister *sym, uint8_t length) {
+    sym->length = length;
+    sym->phi = sym->psi = sym->output = sym->transition = BDD_FALSE;
+    sym->state_input_cube = sym->primed_input_cube = sym->input_cube = BDD_FALSE;
+    sym->variables = sym->to_primed = sym->from_primed = NULL;
+    if (initBDDManager(&sym->manager, getNumOfVars(sym), SYMBOLIC_INITIAL_NODES, SYMBOLIC_INITIAL_CACHE)) return -1;
+    sym->variables = malloc(getNumOfVars(sym) * sizeof(BDD));
+    if (!sym->variables) return -1;
+    for (uint32_t var = 0; var < getNumOfVars(sym); ++var) {
+        sym->variables[var] = refBDD(&sym->manager, getBDDVariable(&sym->manager, var));
+        if (sym->variables[var] == BDD_ERROR) return -1;
+    }
+    sym->to_primed = copyMap(sym, sym->variables);
+    sym->from_primed = copyMap(sym, sym->variables);
+    if (!sym->to_primed || !sym->from_primed) return -1;
+    for (uint8_t i = 0; i < length; ++i) {
+        sym->to_primed[2 * i] = sym->variables[2 * i + 1];
+        sym->from_primed[2 * i + 1] = sym->variables[2 * i];
+    }
+    if (
+        makeCube(sym, &sym->state_input_cube, 0, 1) ||
+        makeCube(sym, &sym->primed_input_cube, 1, 1) ||
+        makeCube(sym, &sym->input_cube, 0, 0)
+    ) return -1;
+    return 0;
+}
+
+// Выход и отношение переходов по уже заданным phi и psi.
+static int finishSymbolicShiftRegister(struct SymbolicShiftRegister *sym) {
+    BDDManager *manager = &sym->manager;
+    BDD *map = copyMap(sym, sym->variables);
+    if (!map) return -1;
+    map[getInputVar(sym)] = sym->phi;
+    int rc = replaceBDD(manager, &sym->output, composeBDD(manager, sym->psi, map));
+    free(map);
+    if (rc) return -1;
+    // s'0 = phi(s, x), s'i = s(i - 1).
+    if (replaceBDD(manager, &sym->transition, xnorBDD(manager, sym->variables[1], sym->phi))) return -1;
+    for (uint8_t i = 1; i < sym->length; ++i) {
+        const BDD shifted = xnorBDD(manager, sym->variables[2 * i + 1], sym->variables[2 * i - 2]);
+        if (replaceBDD(manager, &sym->transition, andBDD(manager, sym->transition, shifted))) return -1;
+    }
+    return 0;
+}
+
+// Сумма мономов; моном - конъюнкция битов состояния.
+static BDD anfToBDD(struct SymbolicShiftRegister *sym, const ANF *anf) {
+    BDDManager *manager = &sym->manager;
+    BDD result = BDD_FALSE;
+    uint32_t vars[ANF_SHIFT_REGISTER_MAX_LENGTH];
+    for (uint64_t i = 0; i < anf->size; ++i) {
+        uint32_t num_of_vars = 0;
+        for (uint64_t m = anf->monomials[i]; m; m &= m - 1) vars[num_of_vars++] = 2u * __builtin_ctzll(m);
+        const BDD monomial = makeBDDCube(manager, vars, num_of_vars);
+        if (replaceBDD(manager, &result, xorBDD(manager, result, monomial))) {
+            derefBDD(manager, result);
+            return BDD_ERROR;
+        }
+    }
+    derefBDD(manager, result);
+    return result;
+}
+
+// f0 + x * f1.
+static int anfPairToBDD(struct SymbolicShiftRegister *sym, const ANF *anf, BDD *function) {
+    BDDManager *manager = &sym->manager;
+    BDD f0 = BDD_FALSE, f1 = BDD_FALSE;
+    int rc = 0;
+    if (
+        replaceBDD(manager, &f0, anfToBDD(sym, &anf[0])) ||
+        replaceBDD(manager, &f1, anfToBDD(sym, &anf[1])) ||
+        replaceBDD(manager, function, xorBDD(manager, f0, andBDD(manager, sym->variables[getInputVar(sym)], f1)))
+    ) rc = -1;
+    derefBDD(manager, f0);
+    derefBDD(manager, f1);
+    return rc;
+}
+
+int initSymbolicShiftRegisterFromANF(struct SymbolicShiftRegister *sym, const struct ANFShiftRegister *reg) {
+    if (
+        initEmptySymbolicShiftRegister(sym, reg->length) ||
+        anfPairToBDD(sym, reg->phi, &sym->phi) ||
+        anfPairToBDD(sym, reg->psi, &sym->psi) ||
+        finishSymbolicShiftRegister(sym)
+    ) {
+        freeSymbolicShiftRegister(sym);
+        return -1;
+    }
+    return 0;
+}
+
+// Функция (phi при shift = 0, psi при shift = 2) на состояниях с битами младше bit,
+// равными битам state. Биты состояния - переменные от младшего к старшему.
+static BDD tableToBDD(struct SymbolicShiftRegister *sym, const struct ShiftRegister *reg, uint8_t shift, uint8_t bit, uint64_t state) {
+    BDDManager *manager = &sym->manager;
+    if (bit == sym->length) {
+        const uint8_t transitions = getShiftRegisterTransitions(reg, state) >> shift;
+        return makeBDDNode(manager, getInputVar(sym), transitions & 1, (transitions >> 1) & 1);
+    }
+    const BDD low = refBDD(manager, tableToBDD(sym, reg, shift, bit + 1, state));
+    if (low == BDD_ERROR) return BDD_ERROR;
+    const BDD high = tableToBDD(sym, reg, shift, bit + 1, state | (uint64_t)1 << bit);
+    const BDD result = high == BDD_ERROR ? BDD_ERROR : makeBDDNode(manager, 2u * bit, low, high);
+    derefBDD(manager, low);
+    return result;
+}
+
+int initSymbolicShiftRegister(struct SymbolicShiftRegister *sym, const struct ShiftRegister *reg) {
+    if (
+        initEmptySymbolicShiftRegister(sym, reg->length) ||
+        replaceBDD(&sym->manager, &sym->phi, tableToBDD(sym, reg, 0, 0, 0)) ||
+        replaceBDD(&sym->manager, &sym->psi, tableToBDD(sym, reg, 2, 0, 0)) ||
+        finishSymbolicShiftRegister(sym)
+    ) {
+        freeSymbolicShiftRegister(sym);
+        return -1;
+    }
+    return 0;
+}
+
+int initSymbolicShiftRegisterFromFile(struct SymbolicShiftRegister *sym, char *settings_file) {
+    int rc = 0;
+    if (isANFShiftRegisterFile(settings_file)) {
+        struct ANFShiftRegister reg;
+        if (initANFShiftRegisterFromFile(&reg, settings_file)) return -1;
+        if (initSymbolicShiftRegisterFromANF(sym, &reg)) rc = -2;
+        freeANFShiftRegister(&reg);
+    } else {
+        struct ShiftRegister reg;
+        if (initShiftRegisterFromFile(&reg, settings_file)) return -1;
+        if (initSymbolicShiftRegister(sym, &reg)) rc = -2;
+        freeShiftRegister(&reg);
+    }
+    if (rc) printf("Не хватает памяти для диаграмм решений\n");
+    return rc;
+}
+
+void freeSymbolicShiftRegister(struct SymbolicShiftRegister *sym) {
+    freeBDDManager(&sym->manager);
+    free(sym->variables);
+    free(sym->to_primed);
+    free(sym->from_primed);
+    sym->variables = sym->to_primed = sym->from_primed = NULL;
+}
+
+BDD getSymbolicState(struct SymbolicShiftRegister *sym, uint64_t state) {
+    BDD result = BDD_TRUE;
+    for (uint8_t i = sym->length; i-- > 0 && result != BDD_ERROR;)
+        result = (state >> i) & 1
+            ? makeBDDNode(&sym->manager, 2u * i, BDD_FALSE, result)
+            : makeBDDNode(&sym->manager, 2u * i, result, BDD_FALSE);
+    return result;
+}
+
+double countSymbolicStates(struct SymbolicShiftRegister *sym, BDD states) {
+    const double count = countBDD(&sym->manager, states);
+    return count < 0 ? count : ldexp(count, -(int)(sym->length + 1));
+}
+
+BDD getSymbolicImage(struct SymbolicShiftRegister *sym, BDD states) {
+    const BDD primed = andExistsBDD(&sym->manager, states, sym->transition, sym->state_input_cube);
+    return composeBDD(&sym->manager, primed, sym->from_primed);
+}
+
+BDD getSymbolicPreimage(struct SymbolicShiftRegister *sym, BDD states) {
+    const BDD primed = composeBDD(&sym->manager, states, sym->to_primed);
+    return andExistsBDD(&sym->manager, sym->transition, primed, sym->primed_input_cube);
+}
+
+int getSymbolicReachable(
+    struct SymbolicShiftRegister *sym, BDD from, uint8_t directions, BDD *reached, uint64_t *num_of_steps
+) {
+    BDDManager *manager = &sym->manager;
+    BDD frontier = refBDD(manager, from), next = BDD_FALSE;
+    *reached = refBDD(manager, from);
+    *num_of_steps = 0;
+    int rc = 0;
+    while (frontier != BDD_FALSE) {
+        if (
+            replaceBDD(manager, &next, directions & SYMBOLIC_FORWARD ? getSymbolicImage(sym, frontier) : BDD_FALSE) ||
+            (
+                (directions & SYMBOLIC_BACKWARD) &&
+                replaceBDD(manager, &next, orBDD(manager, next, getSymbolicPreimage(sym, frontier)))
+            ) ||
+            replaceBDD(manager, &frontier, andBDD(manager, next, notBDD(manager, *reached))) ||
+            replaceBDD(manager, reached, orBDD(manager, *reached, frontier))
+        ) {
+            rc = -1;
+            break;
+        }
+        if (frontier != BDD_FALSE) ++*num_of_steps;
+    }
+    derefBDD(manager, frontier);
+    derefBDD(manager, next);
+    if (rc) {
+        derefBDD(manager, *reached);
+        *reached = BDD_ERROR;
+    }
+    return rc;
+}
+
+int getSymbolicConnectivity(struct SymbolicShiftRegister *sym, uint8_t *strongly, uint8_t *weakly) {
+    BDDManager *manager = &sym->manager;
+    const BDD zero = refBDD(manager, getSymbolicState(sym, 0));
+    BDD reached;
+    uint64_t num_of_steps;
+    int rc = 0;
+    *strongly = 1;
+    for (uint8_t directions = SYMBOLIC_FORWARD; directions <= SYMBOLIC_BACKWARD && *strongly; ++directions) {
+        if (getSymbolicReachable(sym, zero, directions, &reached, &num_of_steps)) {
+            rc = -1;
+            goto end;
+        }
+        *strongly = reached == BDD_TRUE;
+        derefBDD(manager, reached);
+    }
+    if (getSymbolicReachable(sym, zero, SYMBOLIC_FORWARD | SYMBOLIC_BACKWARD, &reached, &num_of_steps)) {
+        rc = -2;
+        goto end;
+    }
+    *weakly = reached == BDD_TRUE;
+    derefBDD(manager, reached);
+end:
+    derefBDD(manager, zero);
+    return rc;
+}
+
+// less(s, s') = s' < s как числа: сравнение от младшего бита к старшему.
+static BDD getLessRelation(struct SymbolicShiftRegister *sym) {
+    BDDManager *manager = &sym->manager;
+    BDD less = BDD_FALSE, primed_one = BDD_FALSE;
+    for (uint8_t i = 0; i < sym->length; ++i) {
+        const BDD state = sym->variables[2 * i], primed = sym->variables[2 * i + 1];
+        if (
+            replaceBDD(manager, &primed_one, iteBDD(manager, primed, less, BDD_TRUE)) ||
+            replaceBDD(manager, &less, iteBDD(manager, state, primed_one, iteBDD(manager, primed, BDD_FALSE, less)))
+        ) {
+            less = BDD_ERROR;
+            break;
+        }
+    }
+    derefBDD(manager, primed_one);
+    return less;
+}
+
+// Число классов - число состояний, не эквивалентных ни одному меньшему.
+static double countClasses(struct SymbolicShiftRegister *sym, BDD equivalence, BDD less) {
+    BDDManager *manager = &sym->manager;
+    const BDD representatives = notBDD(manager, andExistsBDD(manager, less, equivalence, sym->primed_input_cube));
+    return representatives == BDD_ERROR ? -1 : countSymbolicStates(sym, representatives);
+}
+
+int minimizeSymbolicShiftRegister(struct SymbolicShiftRegister *sym, struct SymbolicMinimized *minimized) {
+    BDDManager *manager = &sym->manager;
+    BDD primed = BDD_FALSE, less = BDD_FALSE, identity = BDD_TRUE, next;
+    BDD *step = copyMap(sym, sym->variables);
+    int rc = 0;
+    minimized->equivalence = BDD_FALSE;
+    minimized->degree_of_distinguishability = 0;
+    minimized->original_is_minimal = 0;
+    minimized->num_of_classes = 1;
+    if (!step) return -1;
+    if (
+        replaceBDD(manager, &primed, composeBDD(manager, sym->output, sym->to_primed)) ||
+        replaceBDD(
+            manager, &minimized->equivalence,
+            forallBDD(manager, xnorBDD(manager, sym->output, primed), sym->input_cube)
+        )
+    ) {
+        rc = -2;
+        goto end;
+    }
+    if (minimized->equivalence == BDD_TRUE) goto end;
+    // Подстановка next(s, x) вместо s и next(s', x) вместо s'.
+    if (replaceBDD(manager, &primed, composeBDD(manager, sym->phi, sym->to_primed))) {
+        rc = -3;
+        goto end;
+    }
+    step[0] = sym->phi;
+    step[1] = primed;
+    for (uint8_t i = 1; i < sym->length; ++i) {
+        step[2 * i] = sym->variables[2 * i - 2];
+        step[2 * i + 1] = sym->variables[2 * i - 1];
+    }
+    if (replaceBDD(manager, &less, getLessRelation(sym))) {
+        rc = -4;
+        goto end;
+    }
+    while (1) {
+        ++minimized->degree_of_distinguishability;
+        minimized->num_of_classes = countClasses(sym, minimized->equivalence, less);
+        if (minimized->num_of_classes < 0) {
+            rc = -5;
+            goto end;
+        }
+        printf(
+            "Классов %" PRIu64 " эквивалентности: %.0f\n",
+            minimized->degree_of_distinguishability, minimized->num_of_classes
+        );
+        const BDD shifted = composeBDD(manager, minimized->equivalence, step);
+        next = andBDD(manager, minimized->equivalence, forallBDD(manager, shifted, sym->input_cube));
+        if (next == BDD_ERROR) {
+            rc = -6;
+            goto end;
+        }
+        if (next == minimized->equivalence) break;
+        replaceBDD(manager, &minimized->equivalence, next);
+    }
+    for (uint8_t i = 0; i < sym->length; ++i) {
+        const BDD equal = xnorBDD(manager, sym->variables[2 * i], sym->variables[2 * i + 1]);
+        if (replaceBDD(manager, &identity, andBDD(manager, identity, equal))) {
+            rc = -7;
+            goto end;
+        }
+    }
+    minimized->original_is_minimal = minimized->equivalence == identity;
+end:
+    derefBDD(manager, primed);
+    derefBDD(manager, less);
+    derefBDD(manager, identity);
+    free(step);
+    if (rc) {
+        freeSymbolicMinimized(sym, minimized);
+        printf("Не хватает памяти для диаграмм решений\n");
+    }
+    return rc;
+}
+
+void freeSymbolicMinimized(struct SymbolicShiftRegister *sym, struct SymbolicMinimized *minimized) {
+    derefBDD(&sym->manager, minimized->equivalence);
+    minimized->equivalence = BDD_FALSE;
+}
@@ -0,0 +1,70 @@
+#ifndef SYMBOLIC_SHIFT_REGISTER_H
+#define SYMBOLIC_SHIFT_REGISTER_H
+
+#include "BDD.h"
+#include "ANFShiftRegister.h"
+
+// Регистр, функции, множества состояний и отношение переходов которого заданы
+// диаграммами решений (см. BDD.h): для длин, при которых массивы на 2^length
+// состояний не помещаются в память. Переменная 2i - бит i состояния s, 2i + 1 -
+// бит i второго состояния s' (следующего в отношении переходов или парного в
+// отношении эквивалентности), 2 * length - вход x. Множество состояний - функция
+// только от битов s.
+struct SymbolicShiftRegister {
+    uint8_t length;
+    BDDManager manager;
+    // phi(s, x), psi(s, x) (второй аргумент psi - бит phi) и выход psi(s, phi(s, x)).
+    BDD phi;
+    BDD psi;
+    BDD output;
+    // T(s, x, s'): s' = (s << 1) | phi(s, x).
+    BDD transition;
+    BDD state_input_cube;
+    BDD primed_input_cube;
+    BDD input_cube;
+    // variables[var] - сама переменная var. Подстановки s -> s' и s' -> s
+    // (остальные переменные на месте).
+    BDD *variables;
+    BDD *to_primed;
+    BDD *from_primed;
+};
+
+#define SYMBOLIC_FORWARD 1
+#define SYMBOLIC_BACKWARD 2
+
+struct SymbolicMinimized {
+    // E(s, s') - отношение эквивалентности состояний (захвачено refBDD).
+    BDD equivalence;
+    double num_of_classes;
+    uint64_t degree_of_distinguishability;
+    uint8_t original_is_minimal;
+};
+
+// Файл многочленов (см. ANFShiftRegister.h) переводится в диаграммы напрямую, без
+// таблиц, поэтому длина может быть до ANF_SHIFT_REGISTER_MAX_LENGTH. Остальные
+// форматы загружаются как ShiftRegister.
+int initSymbolicShiftRegisterFromFile(struct SymbolicShiftRegister *sym, char *settings_file);
+int initSymbolicShiftRegisterFromANF(struct SymbolicShiftRegister *sym, const struct ANFShiftRegister *reg);
+int initSymbolicShiftRegister(struct SymbolicShiftRegister *sym, const struct ShiftRegister *reg);
+void freeSymbolicShiftRegister(struct SymbolicShiftRegister *sym);
+// Множество из одного состояния.
+BDD getSymbolicState(struct SymbolicShiftRegister *sym, uint64_t state);
+double countSymbolicStates(struct SymbolicShiftRegister *sym, BDD states);
+// Состояния, в которые переходят из states за такт, и из которых переходят в states.
+BDD getSymbolicImage(struct SymbolicShiftRegister *sym, BDD states);
+BDD getSymbolicPreimage(struct SymbolicShiftRegister *sym, BDD states);
+// Всё, что достижимо из from по рёбрам в направлениях directions (SYMBOLIC_FORWARD,
+// SYMBOLIC_BACKWARD или оба). *reached захвачено refBDD.
+int getSymbolicReachable(
+    struct SymbolicShiftRegister *sym, BDD from, uint8_t directions, BDD *reached, uint64_t *num_of_steps
+);
+// Связность в тех же определениях, что у task3: сильная - из состояния 0 достижимы
+// все и все достигают его, слабая - то же без учёта направления рёбер.
+int getSymbolicConnectivity(struct SymbolicShiftRegister *sym, uint8_t *strongly, uint8_t *weakly);
+// Те же шаги, что у minimizeShiftRegister, но над отношением эквивалентности:
+// E0(s, s') = для всех x выходы равны, E(k + 1) = Ek и для всех x
+// Ek(next(s, x), next(s', x)). На каждом шаге печатается число классов.
+int minimizeSymbolicShiftRegister(struct SymbolicShiftRegister *sym, struct SymbolicMinimized *minimized);
+void freeSymbolicMinimized(struct SymbolicShiftRegister *sym, struct SymbolicMinimized *minimized);
+
+#endif
@@ -0,0 +1,244 @@
+#include "ShiftRegister.h"
+#include "BitslicedShiftRegister.h"
+#include "CompiledShiftRegister.h"
+#include "LinearShiftRegister.h"
+#include "Alloc.h"
+#include <stdlib.h>
+#include <inttypes.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void fillRandom(uint64_t *words, uint64_t num_of_words) {
+    uint64_t x = 0x9E3779B97F4A7C15;
+    for (uint64_t i = 0; i < num_of_words; ++i) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        words[i] = x;
+    }
+}
+
+static void printResult(const char *name, uint64_t num_of_bits, double seconds, int matches) {
+    printf("%s: %.1f Мбит/с%s\n", name, num_of_bits / seconds / 1e6, matches ? "" : "  (выход не совпадает!)");
+}
+
+static void benchSerial(const struct ShiftRegister *reg, const uint64_t *input, uint64_t *output, uint64_t num_of_bits) {
+    struct ShiftRegisterCursor cursor;
+    initShiftRegisterCursor(&cursor, reg, 0);
+    memset(output, 0, (num_of_bits + 63) / 64 * sizeof(uint64_t));
+    double start = now();
+    for (uint64_t i = 0; i < num_of_bits; ++i)
+        output[i / 64] |= (uint64_t)useShiftRegister(&cursor, (input[i / 64] >> (i % 64)) & 1) << (i % 64);
+    printResult("useShiftRegister", num_of_bits, now() - start, 1);
+}
+
+static void benchWords(
+    const struct ShiftRegister *reg, const uint64_t *input,
+    const uint64_t *expected, uint64_t *output, uint64_t num_of_bits
+) {
+    struct ShiftRegisterCursor cursor;
+    initShiftRegisterCursor(&cursor, reg, 0);
+    double start = now();
+    useShiftRegisterOnWords(&cursor, input, output, num_of_bits);
+    double seconds = now() - start;
+    printResult(
+        "useShiftRegisterOnWords", num_of_bits, seconds,
+        !memcmp(expected, output, (num_of_bits + 63) / 64 * sizeof(uint64_t))
+    );
+}
+
+static void benchCompiled(
+    const struct ShiftRegister *reg, const uint64_t *input,
+    const uint64_t *expected, uint64_t *output, uint64_t num_of_bits
+) {
+    struct CompiledShiftRegister compiled;
+    struct ShiftRegisterCursor cursor;
+    initShiftRegisterCursor(&cursor, reg, 0);
+    double start = now();
+    if (compileShiftRegister(&compiled, reg, getCacheBudget())) {
+        printf("K-шаговая таблица: не помещается в кэш\n");
+        return;
+    }
+    double compile_seconds = now() - start;
+    start = now();
+    useCompiledShiftRegisterOnWords(&compiled, &cursor, input, output, num_of_bits);
+    double seconds = now() - start;
+    char name[64];
+    snprintf(name, sizeof(name), "K-шаговая таблица, k=%" PRIu8, compiled.step);
+    printResult(
+        name, num_of_bits, seconds,
+        !memcmp(expected, output, (num_of_bits + 63) / 64 * sizeof(uint64_t))
+    );
+    printf("Построение k-шаговой таблицы: %.3f с\n", compile_seconds);
+    freeCompiledShiftRegister(&compiled);
+}
+
+static void benchLinear(
+    const struct ShiftRegister *reg, const uint64_t *input,
+    const uint64_t *expected, uint64_t *output, uint64_t num_of_bits
+) {
+    struct ShiftRegisterCursor cursor;
+    if (!reg->linear.is_linear) {
+        printf("Линейный движок: функции не аффинны\n");
+        return;
+    }
+    initShiftRegisterCursor(&cursor, reg, 0);
+    double start = now();
+    useLinearShiftRegisterOnWords(&cursor, input, output, num_of_bits);
+    double seconds = now() - start;
+    printResult(
+        "Линейный движок", num_of_bits, seconds,
+        !memcmp(expected, output, (num_of_bits + 63) / 64 * sizeof(uint64_t))
+    );
+    initShiftRegisterCursor(&cursor, reg, 1);
+    start = now();
+    jumpShiftRegister(&cursor, 0, 1000000000000);
+    printf("Переход на 10^12 тактов: %.6f с\n", now() - start);
+}
+
+struct CursorThread {
+    struct ShiftRegisterCursor cursor;
+    const uint64_t *input;
+    uint64_t *output;
+    uint64_t num_of_bits;
+    pthread_t thread;
+};
+
+static void *runCursor(void *arg) {
+    struct CursorThread *thread = arg;
+    useShiftRegisterOnWords(&thread->cursor, thread->input, thread->output, thread->num_of_bits);
+    return NULL;
+}
+
+// Несколько потоков гоняют один и тот же вход каждый через свой курсор над общей таблицей.
+static void benchCursors(
+    const struct ShiftRegister *reg, const uint64_t *input,
+    const uint64_t *expected, uint64_t num_of_bits
+) {
+    long num_of_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (num_of_threads < 2) num_of_threads = 2;
+    uint64_t num_of_words = (num_of_bits + 63) / 64;
+    struct CursorThread *threads = calloc(num_of_threads, sizeof(struct CursorThread));
+    if (!threads) return;
+    long started = 0;
+    double start = now();
+    for (; started < num_of_threads; ++started) {
+        struct CursorThread *thread = &threads[started];
+        initShiftRegisterCursor(&thread->cursor, reg, 0);
+        thread->input = input;
+        thread->num_of_bits = num_of_bits;
+        if (
+            !(thread->output = malloc(num_of_words * sizeof(uint64_t))) ||
+            pthread_create(&thread->thread, NULL, runCursor, thread)
+        ) {
+            free(thread->output);
+            break;
+        }
+    }
+    int matches = 1;
+    for (long i = 0; i < started; ++i) {
+        pthread_join(threads[i].thread, NULL);
+        matches &= !memcmp(expected, threads[i].output, num_of_words * sizeof(uint64_t));
+    }
+    double seconds = now() - start;
+    char name[128];
+    snprintf(name, sizeof(name), "Курсоры над общей таблицей, потоков: %ld", started);
+    printResult(name, started * num_of_bits, seconds, matches);
+    for (long i = 0; i < started; ++i) free(threads[i].output);
+    free(threads);
+}
+
+// Выход экземпляра lane, пересобранный из срезов в слова, как в useShiftRegisterOnWords.
+static void gatherLane(const BitSlice *slices, uint64_t lane, uint64_t *output, uint64_t num_of_bits) {
+    memset(output, 0, (num_of_bits + 63) / 64 * sizeof(uint64_t));
+    for (uint64_t t = 0; t < num_of_bits; ++t)
+        output[t / 64] |= ((slices[t][lane / 64] >> (lane % 64)) & 1) << (t % 64);
+}
+
+// Каждый экземпляр проверяется последовательной симуляцией из того же начального состояния.
+static int checkBitsliced(
+    const struct ShiftRegister *reg, const uint64_t *input,
+    const BitSlice *slices, uint64_t num_of_bits
+) {
+    uint64_t num_of_words = (num_of_bits + 63) / 64;
+    uint64_t *expected = malloc(num_of_words * sizeof(uint64_t));
+    uint64_t *output = malloc(num_of_words * sizeof(uint64_t));
+    int matches = expected && output;
+    for (uint64_t lane = 0; matches && lane < BITSLICE_LANES; ++lane) {
+        struct ShiftRegisterCursor cursor;
+        initShiftRegisterCursor(&cursor, reg, (uint32_t)lane);
+        useShiftRegisterOnWords(&cursor, input, expected, num_of_bits);
+        gatherLane(slices, lane, output, num_of_bits);
+        matches = !memcmp(expected, output, num_of_words * sizeof(uint64_t));
+    }
+    free(expected);
+    free(output);
+    return matches;
+}
+
+static void benchBitsliced(const struct ShiftRegister *reg, const uint64_t *input, uint64_t num_of_bits) {
+    struct BitslicedShiftRegister sliced;
+    if (initBitslicedShiftRegister(&sliced, reg)) {
+        printf("Побитовые срезы: регистр слишком длинный\n");
+        return;
+    }
+    uint64_t steps = num_of_bits / BITSLICE_LANES;
+    if (!steps) steps = 1;
+    BitSlice *output = aligned_alloc(sizeof(BitSlice), steps * sizeof(BitSlice));
+    if (!output) {
+        freeBitslicedShiftRegister(&sliced);
+        return;
+    }
+    setConsecutiveBitslicedStates(&sliced, 0);
+    double start = now();
+    useBitslicedShiftRegisterOnWords(&sliced, input, output, steps);
+    double seconds = now() - start;
+    char name[64];
+    snprintf(name, sizeof(name), "Побитовые срезы, %zu экземпляров", BITSLICE_LANES);
+    printResult(name, steps * BITSLICE_LANES, seconds, checkBitsliced(reg, input, output, steps));
+    free(output);
+    freeBitslicedShiftRegister(&sliced);
+}
+
+int main(int argc, char **argv) {
+    argc = takeAllocOptions(argc, argv);
+    if (argc < 2) {
+        printf("Использование: %s <файл_настроек> [число_битов] [--huge-pages] [--numa-interleave]\n", argv[0]);
+        return 0;
+    }
+    uint64_t num_of_bits = argc > 2 ? strtoull(argv[2], NULL, 10) : (uint64_t)1 << 26;
+    if (!num_of_bits) return -1;
+    struct ShiftRegister reg;
+    if (initShiftRegisterFromFile(&reg, argv[1])) return -2;
+    uint64_t num_of_words = (num_of_bits + 63) / 64;
+    uint64_t *input = malloc(num_of_words * sizeof(uint64_t));
+    uint64_t *expected = malloc(num_of_words * sizeof(uint64_t));
+    uint64_t *output = malloc(num_of_words * sizeof(uint64_t));
+    int rc = 0;
+    if (!input || !expected || !output) {
+        rc = -3;
+        goto end;
+    }
+    if (isShiftRegisterSparse(&reg))
+        printf("Таблица хранится разреженно: %.1f МиБ\n", getSparseBitArraySize(&reg.sparse) / 1048576.0);
+    fillRandom(input, num_of_words);
+    benchSerial(&reg, input, expected, num_of_bits);
+    benchWords(&reg, input, expected, output, num_of_bits);
+    benchCompiled(&reg, input, expected, output, num_of_bits);
+    benchLinear(&reg, input, expected, output, num_of_bits);
+    benchCursors(&reg, input, expected, num_of_bits);
+    benchBitsliced(&reg, input, num_of_bits);
+end:
+    free(input);
+    free(expected);
+    free(output);
+    freeShiftRegister(&reg);
+    return rc;
+}
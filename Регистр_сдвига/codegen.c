@@ -0,0 +1,72 @@
+#include "GeneratedShiftRegister.h"
+#include <inttypes.h>
+#include <stdlib.h>
+
+#define DEFAULT_MAX_MONOMIALS ((uint64_t)1 << 16)
+
+static void printUsage(char *name) {
+    printf(
+        "Использование: %s <файл_настроек> <файл.c> [--max-monomials <число>]\n"
+        "Записывает код phi и psi без ветвлений и таблиц по многочленам Жегалкина регистра.\n"
+        "Собранную библиотеку\n"
+        "    cc -O3 -march=native -shared -fPIC -o <файл.so> <файл.c>\n"
+        "можно указывать вместо файла настроек. --max-monomials ограничивает число\n"
+        "мономов в каждом многочлене (по умолчанию %" PRIu64 ").\n",
+        name, DEFAULT_MAX_MONOMIALS
+    );
+}
+
+static void printStatistics(const char *name, const ANF *constant, const ANF *selected) {
+    printf(
+        "%s: мономов %" PRIu64 " + %" PRIu64 ", степень %" PRIu8 " и %" PRIu8 "\n",
+        name, constant->size, selected->size, getANFDegree(constant), getANFDegree(selected)
+    );
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        printUsage(argv[0]);
+        return 0;
+    }
+    uint64_t max_monomials = DEFAULT_MAX_MONOMIALS;
+    for (int i = 3; i < argc; ++i) {
+        if (!strcmp(argv[i], "--max-monomials") && i + 1 < argc) max_monomials = strtoull(argv[++i], NULL, 10);
+        else {
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+    struct ANFShiftRegister anf;
+    if (isANFShiftRegisterFile(argv[1])) {
+        if (initANFShiftRegisterFromFile(&anf, argv[1])) return -2;
+        if (
+            anf.phi[0].size > max_monomials || anf.phi[1].size > max_monomials ||
+            anf.psi[0].size > max_monomials || anf.psi[1].size > max_monomials
+        ) {
+            printf("В одном из многочленов больше %" PRIu64 " мономов\n", max_monomials);
+            freeANFShiftRegister(&anf);
+            return -3;
+        }
+    } else {
+        struct ShiftRegister reg;
+        if (initShiftRegisterFromFile(&reg, argv[1])) return -2;
+        int rc = shiftRegisterToANF(&anf, &reg, max_monomials);
+        freeShiftRegister(&reg);
+        if (rc == -2) printf("В одном из многочленов больше %" PRIu64 " мономов\n", max_monomials);
+        if (rc) return -3;
+    }
+    printStatistics("phi", &anf.phi[0], &anf.phi[1]);
+    printStatistics("psi", &anf.psi[0], &anf.psi[1]);
+    int rc = 0;
+    FILE *fp = fopen(argv[2], "w");
+    if (!fp) {
+        printf("Не открывается файл %s\n", argv[2]);
+        rc = -4;
+    } else {
+        if (generateShiftRegisterKernel(&anf, argv[1], fp)) rc = -5;
+        if (fclose(fp)) rc = -5;
+        if (rc == -5) printf("Ошибка при записи файла %s\n", argv[2]);
+    }
+    freeANFShiftRegister(&anf);
+    return rc;
+}
@@ -0,0 +1,15 @@
+#include "ShiftRegister.h"
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        printf("Использование: %s <исходный_файл_настроек> <новый_файл_настроек> [--text]\n", argv[0]);
+        printf("По умолчанию сохраняет в двоичном формате, с --text - в текстовом.\n");
+        return 0;
+    }
+    uint8_t binary = !((argc >= 4) && !strcmp(argv[3], "--text"));
+    struct ShiftRegister reg;
+    if (initShiftRegisterFromFile(&reg, argv[1])) return -1;
+    int rc = saveShiftRegisterToFile(&reg, argv[2], binary) ? -2 : 0;
+    freeShiftRegister(&reg);
+    return rc;
+}
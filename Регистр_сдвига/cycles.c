@@ -0,0 +1,124 @@
+#include "CycleStructure.h"
+#include "Alloc.h"
+#include "StateGraph.h"
+#include <errno.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static void printUsage(char *name) {
+    printf(
+        "Использование: %s <файл_настроек> [--input 0|1] [--threads <число>] [--list]\n"
+        "       [--garden-of-eden] [--reaching <состояние>]...\n"
+        "Разбирает граф переходов при постоянном входе на циклы и деревья.\n"
+        "--list выводит каждый цикл: наименьшее состояние, длину, бассейн, хвост.\n"
+        "--garden-of-eden дополнительно считает состояния без прообраза при любом входе.\n"
+        "--reaching считает состояния, из которых при каких-либо входах достижимо\n"
+        "       хотя бы одно из заданных (номер состояния как в --list).\n"
+        "--huge-pages и --numa-interleave - размещение больших массивов (см. Alloc.h).\n",
+        name
+    );
+}
+
+// Номер состояния - десятичное число не больше UINT32_MAX без лишних символов.
+static int parseState(const char *text, uint32_t *state) {
+    char *end;
+    errno = 0;
+    const unsigned long long value = strtoull(text, &end, 10);
+    if (end == text || *end || *text == '-' || errno || value > UINT32_MAX) return -1;
+    *state = (uint32_t)value;
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    argc = takeAllocOptions(argc, argv);
+    if (argc < 2) {
+        printUsage(argv[0]);
+        return 0;
+    }
+    uint8_t x = 0, list_cycles = 0, garden_of_eden = 0;
+    long num_of_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t *targets = malloc(argc * sizeof(uint32_t));
+    uint64_t num_of_targets = 0;
+    if (!targets) return -3;
+    for (int i = 2; i < argc; ++i) {
+        if (!strcmp(argv[i], "--input") && i + 1 < argc && (!strcmp(argv[i + 1], "0") || !strcmp(argv[i + 1], "1")))
+            x = (uint8_t)(argv[++i][0] - '0');
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc) num_of_threads = atol(argv[++i]);
+        else if (!strcmp(argv[i], "--list")) list_cycles = 1;
+        else if (!strcmp(argv[i], "--garden-of-eden")) garden_of_eden = 1;
+        else if (!strcmp(argv[i], "--reaching") && i + 1 < argc && !parseState(argv[++i], &targets[num_of_targets]))
+            ++num_of_targets;
+        else {
+            printUsage(argv[0]);
+            free(targets);
+            return -1;
+        }
+    }
+    if (num_of_threads < 1) num_of_threads = 1;
+    struct ShiftRegister reg;
+    if (initShiftRegisterFromFile(&reg, argv[1])) {
+        free(targets);
+        return -2;
+    }
+    for (uint64_t i = 0; i < num_of_targets; ++i)
+        if (targets[i] > reg.mask) {
+            printf("Состояние %" PRIu32 " не меньше 2^%" PRIu8 "\n", targets[i], reg.length);
+            printUsage(argv[0]);
+            free(targets);
+            freeShiftRegister(&reg);
+            return -1;
+        }
+    struct CycleStructure result;
+    int rc = analyzeCycleStructure(&result, &reg, x, (unsigned)num_of_threads, list_cycles);
+    if (rc) {
+        printf("Не хватает памяти для анализа\n");
+        free(targets);
+        freeShiftRegister(&reg);
+        return -3;
+    }
+    printf("Вход: %" PRIu8 "\n", x);
+    printf("Состояний: %" PRIu64 "\n", (uint64_t)1 << reg.length);
+    printf("Циклов: %" PRIu64 "\n", result.num_of_cycles);
+    printf("Состояний на циклах: %" PRIu64 "\n", result.cyclic_states);
+    printf("Состояний без прообраза: %" PRIu64 "\n", result.leaves);
+    if (garden_of_eden) {
+        BitArray states;
+        uint64_t count;
+        if (getGardenOfEdenStates(&reg, &states, &count)) printf("Не хватает памяти для поиска состояний без прообраза\n");
+        else {
+            printf("Состояний без прообраза при любом входе: %" PRIu64 "\n", count);
+            freeBitArray(&states);
+        }
+    }
+    if (num_of_targets) {
+        BitArray reachable;
+        if (getBackwardReachableStates(&reg, targets, num_of_targets, &reachable))
+            printf("Не хватает памяти для поиска состояний, из которых достижимы заданные\n");
+        else {
+            printf("Состояний, из которых достижимы заданные: %" PRIu64 "\n", countBitArrayOnes(&reachable));
+            freeBitArray(&reachable);
+        }
+    }
+    printf("Наибольшая длина хвоста: %" PRIu64 "\n", result.max_tail);
+    printf("Длина цикла, число циклов, суммарный бассейн, наибольший хвост:\n");
+    for (uint64_t i = 0; i < result.num_of_classes; ++i)
+        printf(
+            "%" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64 "\n",
+            result.classes[i].length, result.classes[i].cycles,
+            result.classes[i].basin, result.classes[i].max_tail
+        );
+    if (list_cycles) {
+        printf("Наименьшее состояние, длина цикла, бассейн, наибольший хвост:\n");
+        for (uint64_t i = 0; i < result.num_of_cycles; ++i)
+            printf(
+                "%" PRIu32 " %" PRIu64 " %" PRIu64 " %" PRIu64 "\n",
+                result.cycles[i].representative, result.cycles[i].length,
+                result.cycles[i].basin, result.cycles[i].max_tail
+            );
+    }
+    freeCycleStructure(&result);
+    free(targets);
+    freeShiftRegister(&reg);
+    return 0;
+}
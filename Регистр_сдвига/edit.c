@@ -0,0 +1,165 @@
+#include "Partition.h"
+#include "Alloc.h"
+#include <stdlib.h>
+#include <inttypes.h>
+#include <time.h>
+#include <unistd.h>
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void printResult(const struct StatePartition *partition) {
+    printf("Приведённый вес: %" PRIu64 "\n", partition->num_of_classes);
+    printf("Степень различимости: %" PRIu64 "\n", getStatePartitionDegree(partition));
+    printf("Минимальный? %s\n", partition->num_of_classes == partition->num_of_states ? "Да" : "Нет");
+}
+
+// Строка "phi <индекс> <значение>" или "psi ...", индекс - (состояние << 1) | x, как в
+// файле настроек. Полубайт состояния берётся из уже внесённых в пачку изменений.
+static int parseChange(
+    const char *line, const struct ShiftRegister *reg, struct TransitionChange *changes, uint64_t *num_of_changes
+) {
+    char function[4];
+    uint64_t index;
+    unsigned value;
+    if (sscanf(line, "%3s %" SCNu64 " %u", function, &index, &value) != 3 || value > 1) return -1;
+    uint8_t shift;
+    if (!strcmp(function, "phi")) shift = 0;
+    else if (!strcmp(function, "psi")) shift = 2;
+    else return -1;
+    if (index >> 1 > reg->mask) return -1;
+    const uint32_t state = (uint32_t)(index >> 1);
+    uint8_t transitions = getShiftRegisterTransitions(reg, state);
+    for (uint64_t i = *num_of_changes; i-- > 0;)
+        if (changes[i].state == state) {
+            transitions = changes[i].transitions;
+            break;
+        }
+    const uint8_t bit = (uint8_t)(1 << (shift + (index & 1)));
+    changes[(*num_of_changes)++] = (struct TransitionChange){
+        .state = state, .transitions = value ? transitions | bit : transitions & ~bit
+    };
+    return 0;
+}
+
+static int applyChanges(
+    struct StatePartition *partition, struct ShiftRegister *reg,
+    const struct TransitionChange *changes, uint64_t num_of_changes
+) {
+    uint64_t num_of_affected;
+    const double start = now();
+    const int rc = updateStatePartition(partition, reg, changes, num_of_changes, &num_of_affected);
+    const double finish = now();
+    if (rc < 0) {
+        printf("Не удалось обновить разбиение\n");
+        return rc;
+    }
+    printf(
+        "Изменений: %" PRIu64 ", затронуто состояний: %s%" PRIu64 "%s, %.3f мс\n",
+        num_of_changes, rc ? "больше " : "", num_of_affected,
+        rc ? " (разбиение построено заново)" : "", (finish - start) * 1e3
+    );
+    printResult(partition);
+    return 0;
+}
+
+static void printUsage(char *name) {
+    printf(
+        "Использование: %s <файл_настроек> <файл_изменений> [--threads <число>] [--save <файл>]\n"
+        "Минимизирует регистр, затем вносит изменения из файла по пачкам и после каждой\n"
+        "пересчитывает только затронутые классы. Строка файла изменений - \"phi <индекс>\n"
+        "<значение>\" или \"psi ...\" (индекс как в файле настроек), пачки разделяются\n"
+        "пустой строкой. --save сохраняет изменённый регистр. Регистр, заданный\n"
+        "разделяемой библиотекой (.so, см. shift_register_codegen), не изменяется.\n",
+        name
+    );
+}
+
+int main(int argc, char **argv) {
+    argc = takeAllocOptions(argc, argv);
+    if (argc < 3) {
+        printUsage(argv[0]);
+        return 0;
+    }
+    long num_of_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    char *save_file = NULL;
+    for (int i = 3; i < argc; ++i) {
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc) num_of_threads = atol(argv[++i]);
+        else if (!strcmp(argv[i], "--save") && i + 1 < argc) save_file = argv[++i];
+        else {
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+    if (num_of_threads < 1) num_of_threads = 1;
+    struct ShiftRegister reg;
+    if (initShiftRegisterFromFile(&reg, argv[1])) return -1;
+    if (!reg.transitions.bucket && !isShiftRegisterSparse(&reg)) {
+        printf("Регистр задан разделяемой библиотекой, изменять его таблицу нельзя\n");
+        freeShiftRegister(&reg);
+        return -2;
+    }
+    if (reg.length > PARTITION_MAX_LENGTH) {
+        printf("Регистр длины %" PRIu8 " в памяти не минимизируется\n", reg.length);
+        freeShiftRegister(&reg);
+        return -2;
+    }
+    FILE *fp = fopen(argv[2], "r");
+    if (!fp) {
+        printf("Не открывается файл %s\n", argv[2]);
+        freeShiftRegister(&reg);
+        return -3;
+    }
+    int rc = 0;
+    struct StatePartition partition;
+    struct TransitionChange *changes = NULL;
+    uint64_t num_of_changes = 0, capacity = 0;
+    if (minimizeStatePartition(&partition, &reg, (unsigned)num_of_threads)) {
+        printf("Не хватает памяти для минимизации\n");
+        rc = -4;
+        goto end;
+    }
+    printResult(&partition);
+    char line[256];
+    uint64_t line_number = 0;
+    while (1) {
+        const uint8_t eof = !fgets(line, sizeof(line), fp);
+        ++line_number;
+        if (eof || line[strspn(line, " \t\r\n")] == '\0') {
+            if (num_of_changes && applyChanges(&partition, &reg, changes, num_of_changes)) {
+                rc = -5;
+                goto end;
+            }
+            num_of_changes = 0;
+            if (eof) break;
+            continue;
+        }
+        if (num_of_changes == capacity) {
+            capacity = capacity ? 2 * capacity : 64;
+            struct TransitionChange *grown = realloc(changes, capacity * sizeof(struct TransitionChange));
+            if (!grown) {
+                rc = -4;
+                goto end;
+            }
+            changes = grown;
+        }
+        if (parseChange(line, &reg, changes, &num_of_changes)) {
+            printf("Строка %" PRIu64 " файла изменений не разобрана\n", line_number);
+            rc = -6;
+            goto end;
+        }
+    }
+    if (save_file && saveShiftRegisterToFile(&reg, save_file, 0)) {
+        printf("Не удалось сохранить регистр в %s\n", save_file);
+        rc = -7;
+    }
+end:
+    freeStatePartition(&partition);
+    free(changes);
+    fclose(fp);
+    freeShiftRegister(&reg);
+    return rc;
+}
@@ -0,0 +1,91 @@
+#include "Exhaustive.h"
+#include <inttypes.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+static void printUsage(char *name) {
+    printf(
+        "Использование: %s <длина> [--threads <число>] [--table <файл>]\n"
+        "Перебирает все пары phi/psi регистров длины от 1 до %d и выводит, сколько пар\n"
+        "имеют каждый набор характеристик: приведённый вес, степень различимости,\n"
+        "сильная связность, связность, память (- если бесконечна).\n"
+        "--table записывает по 2 байта на пару (см. Exhaustive.h), для длины 3 - 8 ГиБ.\n",
+        name, EXHAUSTIVE_MAX_LENGTH
+    );
+}
+
+static void printResult(const struct ExhaustiveResult *result) {
+    printf("Длина: %" PRIu8 "\n", result->length);
+    printf("Пар phi/psi: %" PRIu64 "\n", result->num_of_pairs);
+    printf("Посчитано непосредственно: %" PRIu64 "\n", result->num_of_representatives);
+    printf("Вес, степень, сильно связан, связан, память, число пар:\n");
+    for (uint32_t code = 0; code < EXHAUSTIVE_CODES; ++code) {
+        if (!result->histogram[code]) continue;
+        struct SmallProperties properties;
+        unpackSmallProperties((uint16_t)code, &properties);
+        printf(
+            "%" PRIu8 " %" PRIu8 " %" PRIu8 " %" PRIu8 " ",
+            properties.num_of_classes, properties.degree_of_distinguishability,
+            properties.strongly_connected, properties.connected
+        );
+        if (properties.memory == EXHAUSTIVE_INFINITE_MEMORY) printf("-");
+        else printf("%" PRIu8, properties.memory);
+        printf(" %" PRIu64 "\n", result->histogram[code]);
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        printUsage(argv[0]);
+        return 0;
+    }
+    const int length = atoi(argv[1]);
+    long num_of_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    char *table_file = NULL;
+    for (int i = 2; i < argc; ++i) {
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc) num_of_threads = atol(argv[++i]);
+        else if (!strcmp(argv[i], "--table") && i + 1 < argc) table_file = argv[++i];
+        else {
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+    if (length < 1 || length > EXHAUSTIVE_MAX_LENGTH) {
+        printUsage(argv[0]);
+        return -1;
+    }
+    if (num_of_threads < 1) num_of_threads = 1;
+    uint16_t *table = NULL;
+    const size_t table_size = ((size_t)1 << (4u << length)) * sizeof(uint16_t);
+    int fd = -1;
+    if (table_file) {
+        fd = open(table_file, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0 || ftruncate(fd, (off_t)table_size)) {
+            printf("Не открывается файл %s\n", table_file);
+            if (fd >= 0) close(fd);
+            return -2;
+        }
+        table = mmap(NULL, table_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (table == MAP_FAILED) {
+            printf("Не отображается в память файл %s\n", table_file);
+            close(fd);
+            return -2;
+        }
+    }
+    struct ExhaustiveResult result;
+    int rc = 0;
+    if (sweepShiftRegisters(&result, (uint8_t)length, (unsigned)num_of_threads, table)) {
+        printf("Не хватает памяти для перебора\n");
+        rc = -3;
+    } else {
+        printResult(&result);
+        freeExhaustiveResult(&result);
+    }
+    if (table) {
+        munmap(table, table_size);
+        close(fd);
+    }
+    return rc;
+}
@@ -0,0 +1,108 @@
+#include "ShiftRegister.h"
+#include "Transform.h"
+#include "Alloc.h"
+#include <inttypes.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static void printUsage(char *name) {
+    printf(
+        "Использование: %s <файл_настроек> [--threads <число>]\n"
+        "Спектральные характеристики phi и psi как функций от length + 1 переменных:\n"
+        "точка (s << 1) | b, переменная 0 - b, переменная i + 1 - бит i состояния s.\n"
+        "Спектр Уолша занимает 2^(length + 4) байт, таблица - 2^(length - 2).\n"
+        "--huge-pages и --numa-interleave - размещение больших массивов (см. Alloc.h).\n",
+        name
+    );
+}
+
+// Таблицы истинности phi и psi в формате mobiusTransform.
+static int initTruthTables(const struct ShiftRegister *reg, uint64_t *tables[2], uint8_t kinds[2], size_t size) {
+    tables[0] = allocLarge(size, &kinds[0]);
+    tables[1] = allocLarge(size, &kinds[1]);
+    if (!tables[0] || !tables[1]) {
+        if (tables[0]) freeLarge(tables[0], size, kinds[0]);
+        if (tables[1]) freeLarge(tables[1], size, kinds[1]);
+        return -1;
+    }
+    const uint64_t num_of_states = (uint64_t)1 << reg->length;
+    for (uint64_t state = 0; state < num_of_states; ++state) {
+        const uint64_t transitions = getShiftRegisterTransitions(reg, state);
+        const uint64_t index = state << 1;
+        tables[0][index >> 6] |= (transitions & 3) << (index & 63);
+        tables[1][index >> 6] |= (transitions >> 2) << (index & 63);
+    }
+    return 0;
+}
+
+static int printSpectralProperties(
+    const char *name, uint64_t *table, uint8_t num_of_variables, unsigned num_of_threads
+) {
+    const uint64_t num_of_points = (uint64_t)1 << num_of_variables;
+    const size_t spectrum_size = num_of_points * sizeof(int64_t);
+    uint8_t kind;
+    int64_t *spectrum = allocLarge(spectrum_size, &kind);
+    if (!spectrum) return -1;
+    initWalshSpectrum(spectrum, table, num_of_variables, num_of_threads);
+    // W(0) = 2^n - 2 * wt(f).
+    const uint64_t weight = (uint64_t)(((int64_t)num_of_points - spectrum[0]) / 2);
+    uint64_t max_absolute;
+    uint8_t correlation_immunity;
+    analyzeWalshSpectrum(spectrum, num_of_variables, num_of_threads, &max_absolute, &correlation_immunity);
+    freeLarge(spectrum, spectrum_size, kind);
+    mobiusTransform(table, num_of_variables, num_of_threads);
+    const int degree = getAlgebraicDegree(table, num_of_variables, num_of_threads);
+    printf("%s:\n", name);
+    printf(
+        "    Вес: %" PRIu64 " из %" PRIu64 " (%s)\n",
+        weight, num_of_points, 2 * weight == num_of_points ? "уравновешена" : "не уравновешена"
+    );
+    printf("    Алгебраическая степень: %d\n", degree);
+    printf("    Наибольший модуль коэффициента Уолша: %" PRIu64 "\n", max_absolute);
+    printf("    Нелинейность: %" PRIu64 "\n", num_of_points / 2 - max_absolute / 2);
+    printf("    Порядок корреляционной иммунности: %" PRIu8 "\n", correlation_immunity);
+    if (2 * weight == num_of_points) printf("    Порядок устойчивости: %" PRIu8 "\n", correlation_immunity);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    argc = takeAllocOptions(argc, argv);
+    if (argc < 2) {
+        printUsage(argv[0]);
+        return 0;
+    }
+    long num_of_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    for (int i = 2; i < argc; ++i) {
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc) num_of_threads = atol(argv[++i]);
+        else {
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+    if (num_of_threads < 1) num_of_threads = 1;
+    struct ShiftRegister reg;
+    if (initShiftRegisterFromFile(&reg, argv[1])) return -2;
+    const uint8_t num_of_variables = reg.length + 1;
+    const size_t table_size = (num_of_variables > 6 ? (size_t)1 << (num_of_variables - 6) : 1) * sizeof(uint64_t);
+    uint64_t *tables[2];
+    uint8_t kinds[2];
+    int rc = 0;
+    if (initTruthTables(&reg, tables, kinds, table_size)) {
+        printf("Не хватает памяти для таблиц истинности\n");
+        rc = -3;
+        goto end;
+    }
+    printf("Переменных: %" PRIu8 "\n", num_of_variables);
+    if (
+        printSpectralProperties("phi", tables[0], num_of_variables, (unsigned)num_of_threads) ||
+        printSpectralProperties("psi", tables[1], num_of_variables, (unsigned)num_of_threads)
+    ) {
+        printf("Не хватает памяти для спектра Уолша\n");
+        rc = -4;
+    }
+    freeLarge(tables[0], table_size, kinds[0]);
+    freeLarge(tables[1], table_size, kinds[1]);
+end:
+    freeShiftRegister(&reg);
+    return rc;
+}
@@ -0,0 +1,60 @@
+#include "SymbolicShiftRegister.h"
+#include <inttypes.h>
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        printf(
+            "Использование: %s <файл_настроек>\n"
+            "Связность и минимизация регистра на диаграммах решений, без таблиц и массивов\n"
+            "по состояниям. Файл многочленов (см. ANFShiftRegister.h) может задавать длину\n"
+            "до %d.\n",
+            argv[0], ANF_SHIFT_REGISTER_MAX_LENGTH
+        );
+        return 0;
+    }
+    struct SymbolicShiftRegister sym;
+    if (initSymbolicShiftRegisterFromFile(&sym, argv[1])) return -1;
+    int rc = 0;
+    printf("Длина: %" PRIu8 "\n", sym.length);
+    printf(
+        "Вершин: phi %" PRIu32 ", psi %" PRIu32 ", отношение переходов %" PRIu32 "\n",
+        getBDDSize(&sym.manager, sym.phi), getBDDSize(&sym.manager, sym.psi),
+        getBDDSize(&sym.manager, sym.transition)
+    );
+    BDD reached;
+    uint64_t num_of_steps;
+    const BDD zero = refBDD(&sym.manager, getSymbolicState(&sym, 0));
+    if (getSymbolicReachable(&sym, zero, SYMBOLIC_FORWARD, &reached, &num_of_steps)) {
+        rc = -2;
+        goto end;
+    }
+    printf(
+        "Достижимо из состояния 0: %.0f за %" PRIu64 " шагов\n",
+        countSymbolicStates(&sym, reached), num_of_steps
+    );
+    derefBDD(&sym.manager, reached);
+    uint8_t strongly, weakly;
+    if (getSymbolicConnectivity(&sym, &strongly, &weakly)) {
+        rc = -3;
+        goto end;
+    }
+    printf(strongly ? "Является сильно связаным.\n" : "Не является сильно связаным.\n");
+    printf(weakly ? "Является связаным.\n" : "Не является связаным.\n");
+    struct SymbolicMinimized minimized;
+    if (minimizeSymbolicShiftRegister(&sym, &minimized)) {
+        rc = -4;
+        goto end;
+    }
+    printf("Приведённый вес: %.0f\n", minimized.num_of_classes);
+    printf("Степень различимости: %" PRIu64 "\n", minimized.degree_of_distinguishability);
+    printf("Минимальный? %s\n", minimized.original_is_minimal ? "Да" : "Нет");
+    printf(
+        "Вершин в таблице: %" PRIu32 ", сборок мусора: %" PRIu64 "\n",
+        getBDDNodeCount(&sym.manager), sym.manager.num_of_collections
+    );
+    freeSymbolicMinimized(&sym, &minimized);
+end:
+    if (rc) printf("Не хватает памяти для диаграмм решений\n");
+    freeSymbolicShiftRegister(&sym);
+    return rc;
+}
@@ -1,29 +1,75 @@
 #include "ShiftRegister.h"
+#include "CompiledShiftRegister.h"
+#include "ANFShiftRegister.h"
+#include "LinearShiftRegister.h"
+#include "Alloc.h"
+#include "LinearComplexity.h"
 #include <inttypes.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
 
-int main(int argc, char **argv) {
-    if (argc < 2) {
-        printf("Использование: %s <файл_настроек>\n", argv[0]);
-        return 0;
-    }
-    struct ShiftRegister reg;
-    if (initShiftRegisterFromFile(&reg, argv[1])) return -1;
-    int rc = 0;
-    if (readState(&reg)) {
-        rc = -2;
-        goto end;
-    }
+// Размер блока пакетного режима в 64-битных словах (4 Мбит).
+#define BATCH_WORDS ((uint64_t)1 << 16)
+#define READ_BUFFER_SIZE ((size_t)1 << 22)
+
+struct Batch {
+    struct ShiftRegisterCursor cursor;
+    // Регистр длиннее 32, заданный многочленами; тогда reg не используется.
+    struct ANFShiftRegister *anf;
+    struct CompiledShiftRegister compiled;
+    uint8_t use_compiled;
+    uint8_t binary_input;
+    uint8_t binary_output;
+    int input;
+    FILE *output;
+    FILE *states;
+    // Профиль линейной сложности выхода (--linear-complexity), иначе NULL.
+    LinearComplexity *complexity;
+    FILE *profile;
+    uint64_t *x;
+    uint64_t *y;
+    char *buffer;
+    char *text;
+    uint64_t num_of_bits;
+};
+
+static void printUsage(char *name) {
+    printf(
+        "Использование: %s <файл_настроек>\n"
+        "       %s <файл_настроек> --batch <вход> <выход> [--state <биты>]\n"
+        "          [--binary-input] [--binary-output] [--states <файл_состояний>]\n"
+        "          [--skip <число_тактов>] [--linear-complexity] [--complexity-profile <файл>]\n"
+        "          [--connection-polynomial]\n"
+        "Вместо имени файла можно указать -, тогда используются stdin/stdout.\n"
+        "--skip пропускает заданное число тактов с нулевым входом, для линейных\n"
+        "регистров - сразу. Для регистров длины больше 32, заданных многочленами,\n"
+        "--states и --skip недоступны.\n"
+        "--linear-complexity считает линейную сложность выхода алгоритмом Берлекэмпа-Мэсси\n"
+        "по мере его получения, --complexity-profile дополнительно записывает в файл\n"
+        "строки \"n L\" всякий раз, когда после n битов сложность становится равной L,\n"
+        "--connection-polynomial в конце выводит многочлен связи выхода.\n"
+        "Во всех режимах принимаются --huge-pages и --numa-interleave (см. Alloc.h).\n",
+        name, name
+    );
+}
+
+static int interactive(const struct ShiftRegister *reg) {
+    struct ShiftRegisterCursor cursor;
+    initShiftRegisterCursor(&cursor, reg, 0);
+    if (readState(&cursor)) return -2;
     printf("Введите x: ");
     while(1) {
         switch (fgetc(stdin)) {
             case '1':
-                printf("y = %" PRIu8 " ", useShiftRegister(&reg, 1));
-                printf("state = %" PRIu32 "\n", getState(&reg));
+                printf("y = %" PRIu8 " ", useShiftRegister(&cursor, 1));
+                printf("state = %" PRIu32 "\n", getState(&cursor));
                 printf("Введите x: ");
                 break;
             case '0':
-                printf("y = %" PRIu8 " ", useShiftRegister(&reg, 0));
-                printf("state = %" PRIu32 "\n", getState(&reg));
+                printf("y = %" PRIu8 " ", useShiftRegister(&cursor, 0));
+                printf("state = %" PRIu32 "\n", getState(&cursor));
                 printf("Введите x: ");
                 break;
             case ' ':
@@ -31,10 +77,312 @@ int main(int argc, char **argv) {
             case '\n':
                 break;
             default:
-                goto end;
+                return 0;
         }
     }
+}
+
+static int interactiveANF(struct ANFShiftRegister *reg) {
+    if (readANFState(reg)) return -2;
+    printf("Введите x: ");
+    while(1) {
+        int c = fgetc(stdin);
+        switch (c) {
+            case '1':
+            case '0':
+                printf("y = %" PRIu8 " ", useANFShiftRegister(reg, (uint8_t)(c - '0')));
+                printf("state = %" PRIu64 "\n", reg->state);
+                printf("Введите x: ");
+                break;
+            case ' ':
+            case '\t':
+            case '\n':
+                break;
+            default:
+                return 0;
+        }
+    }
+}
+
+static int parseState(uint8_t length, const char *bits, uint64_t *state) {
+    if (strlen(bits) != length) return -1;
+    *state = 0;
+    for (uint8_t i = 0; i < length; ++i) {
+        if (bits[i] != '0' && bits[i] != '1') return -2;
+        *state = (*state << 1) | (uint64_t)(bits[i] - '0');
+    }
+    return 0;
+}
+
+static char *formatUint32(char *p, uint32_t value) {
+    char digits[10];
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    while (n) *p++ = digits[--n];
+    *p++ = '\n';
+    return p;
+}
+
+static int writeStates(struct Batch *batch, const uint32_t *states, uint64_t count) {
+    if (batch->binary_output)
+        return fwrite(states, sizeof(uint32_t), count, batch->states) == count ? 0 : -1;
+    char buf[1 << 16];
+    char *p = buf;
+    for (uint64_t i = 0; i < count; ++i) {
+        if (p - buf > (long)sizeof(buf) - 11) {
+            if (fwrite(buf, 1, p - buf, batch->states) != (size_t)(p - buf)) return -1;
+            p = buf;
+        }
+        p = formatUint32(p, states[i]);
+    }
+    return fwrite(buf, 1, p - buf, batch->states) == (size_t)(p - buf) ? 0 : -1;
+}
+
+static int simulateWithStates(struct Batch *batch, uint64_t num_of_bits) {
+    uint32_t states[1024];
+    uint64_t count = 0;
+    memset(batch->y, 0, (num_of_bits + 63) / 64 * sizeof(uint64_t));
+    for (uint64_t i = 0; i < num_of_bits; ++i) {
+        batch->y[i / 64] |=
+            (uint64_t)useShiftRegister(&batch->cursor, (batch->x[i / 64] >> (i % 64)) & 1) << (i % 64);
+        states[count++] = getState(&batch->cursor);
+        if (count == sizeof(states) / sizeof(states[0])) {
+            if (writeStates(batch, states, count)) return -1;
+            count = 0;
+        }
+    }
+    return writeStates(batch, states, count);
+}
+
+static int writeOutput(struct Batch *batch, uint64_t num_of_bits) {
+    if (batch->binary_output) {
+        size_t bytes = (num_of_bits + 7) / 8;
+        return fwrite(batch->y, 1, bytes, batch->output) == bytes ? 0 : -1;
+    }
+    for (uint64_t i = 0; i < num_of_bits; ++i)
+        batch->text[i] = (char)('0' + ((batch->y[i / 64] >> (i % 64)) & 1));
+    return fwrite(batch->text, 1, num_of_bits, batch->output) == num_of_bits ? 0 : -1;
+}
+
+static int writeProfile(void *context, const LinearComplexity *lc) {
+    return fprintf(context, "%" PRIu64 " %" PRIu64 "\n", lc->num_of_bits, getLinearComplexity(lc)) < 0;
+}
+
+static int processBlock(struct Batch *batch, uint64_t num_of_bits) {
+    if (!num_of_bits) return 0;
+    if (batch->anf)
+        useANFShiftRegisterOnWords(batch->anf, batch->x, batch->y, num_of_bits);
+    else if (batch->states) {
+        if (simulateWithStates(batch, num_of_bits)) return -1;
+    } else if (batch->use_compiled)
+        useCompiledShiftRegisterOnWords(&batch->compiled, &batch->cursor, batch->x, batch->y, num_of_bits);
+    else useShiftRegisterOnWords(&batch->cursor, batch->x, batch->y, num_of_bits);
+    batch->num_of_bits += num_of_bits;
+    if (
+        batch->complexity &&
+        pushLinearComplexityWords(
+            batch->complexity, batch->y, num_of_bits, batch->profile ? writeProfile : NULL, batch->profile
+        )
+    ) return -2;
+    return writeOutput(batch, num_of_bits);
+}
+
+static int processBinaryInput(struct Batch *batch) {
+    while (1) {
+        size_t filled = 0;
+        ssize_t got;
+        while (
+            filled < BATCH_WORDS * sizeof(uint64_t) &&
+            (got = read(batch->input, (char *)batch->x + filled, BATCH_WORDS * sizeof(uint64_t) - filled)) > 0
+        ) filled += got;
+        if (got < 0) return -1;
+        if (processBlock(batch, (uint64_t)filled * 8)) return -2;
+        if (filled < BATCH_WORDS * sizeof(uint64_t)) return 0;
+    }
+}
+
+static int processTextInput(struct Batch *batch) {
+    uint64_t bit = 0;
+    ssize_t got;
+    memset(batch->x, 0, BATCH_WORDS * sizeof(uint64_t));
+    while ((got = read(batch->input, batch->buffer, READ_BUFFER_SIZE)) > 0)
+        for (ssize_t i = 0; i < got; ++i) {
+            switch (batch->buffer[i]) {
+                case '1':
+                    batch->x[bit / 64] |= (uint64_t)1 << (bit % 64);
+                    // fallthrough
+                case '0':
+                    ++bit;
+                    break;
+                case ' ':
+                case '\t':
+                case '\n':
+                case '\r':
+                    continue;
+                default:
+                    fprintf(stderr, "Ошибка при чтении входа. Получен символ %d.\n", batch->buffer[i]);
+                    return -1;
+            }
+            if (bit == BATCH_WORDS * 64) {
+                if (processBlock(batch, bit)) return -2;
+                bit = 0;
+                memset(batch->x, 0, BATCH_WORDS * sizeof(uint64_t));
+            }
+        }
+    if (got < 0) return -3;
+    return processBlock(batch, bit) ? -4 : 0;
+}
+
+static int openBatchFiles(struct Batch *batch, char *input, char *output, char *states, char *profile) {
+    batch->input = strcmp(input, "-") ? open(input, O_RDONLY) : STDIN_FILENO;
+    if (batch->input < 0) {
+        fprintf(stderr, "Не открывается файл %s\n", input);
+        return -1;
+    }
+    posix_fadvise(batch->input, 0, 0, POSIX_FADV_SEQUENTIAL);
+    batch->output = strcmp(output, "-") ? fopen(output, "wb") : stdout;
+    if (!batch->output) {
+        fprintf(stderr, "Не открывается файл %s\n", output);
+        return -2;
+    }
+    batch->states = NULL;
+    if (states && !(batch->states = fopen(states, "wb"))) {
+        fprintf(stderr, "Не открывается файл %s\n", states);
+        return -3;
+    }
+    batch->profile = NULL;
+    if (profile && !(batch->profile = fopen(profile, "w"))) {
+        fprintf(stderr, "Не открывается файл %s\n", profile);
+        return -4;
+    }
+    return 0;
+}
+
+static void closeBatchFiles(struct Batch *batch) {
+    if (batch->input > STDIN_FILENO) close(batch->input);
+    if (batch->output && batch->output != stdout) fclose(batch->output);
+    else if (batch->output) fflush(batch->output);
+    if (batch->states) fclose(batch->states);
+    if (batch->profile) fclose(batch->profile);
+}
+
+static int batch(const struct ShiftRegister *reg, struct ANFShiftRegister *anf, int argc, char **argv) {
+    struct Batch batch = {.anf = anf, .input = -1};
+    char *states = NULL, *profile = NULL;
+    uint8_t linear_complexity = 0, connection_polynomial = 0;
+    LinearComplexity complexity;
+    uint8_t length = anf ? anf->length : reg->length;
+    uint64_t state = 0, skip = 0;
+    for (int i = 5; i < argc; ++i) {
+        if (!strcmp(argv[i], "--binary-input")) batch.binary_input = 1;
+        else if (!strcmp(argv[i], "--binary-output")) batch.binary_output = 1;
+        else if (!strcmp(argv[i], "--states") && i + 1 < argc) states = argv[++i];
+        else if (!strcmp(argv[i], "--skip") && i + 1 < argc) skip = strtoull(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "--linear-complexity")) linear_complexity = 1;
+        else if (!strcmp(argv[i], "--connection-polynomial")) linear_complexity = connection_polynomial = 1;
+        else if (!strcmp(argv[i], "--complexity-profile") && i + 1 < argc) {
+            profile = argv[++i];
+            linear_complexity = 1;
+        }
+        else if (!strcmp(argv[i], "--state") && i + 1 < argc) {
+            if (parseState(length, argv[++i], &state)) {
+                fprintf(stderr, "Начальное состояние должно состоять из %" PRIu8 " символов 0 и 1.\n", length);
+                return -2;
+            }
+        } else {
+            printUsage(argv[0]);
+            return -2;
+        }
+    }
+    if (anf && (states || skip)) {
+        printUsage(argv[0]);
+        return -2;
+    }
+    if (anf) anf->state = state;
+    else {
+        initShiftRegisterCursor(&batch.cursor, reg, (uint32_t)state);
+        jumpShiftRegister(&batch.cursor, 0, skip);
+    }
+    int rc = 0;
+    batch.x = malloc(BATCH_WORDS * sizeof(uint64_t));
+    batch.y = malloc(BATCH_WORDS * sizeof(uint64_t));
+    batch.buffer = malloc(READ_BUFFER_SIZE);
+    batch.text = malloc(BATCH_WORDS * 64);
+    if (!batch.x || !batch.y || !batch.buffer || !batch.text) {
+        rc = -3;
+        goto end;
+    }
+    if (linear_complexity) {
+        if (initLinearComplexity(&complexity)) {
+            rc = -3;
+            goto end;
+        }
+        batch.complexity = &complexity;
+    }
+    if (openBatchFiles(&batch, argv[3], argv[4], states, profile)) {
+        rc = -4;
+        goto end;
+    }
+    if (!states && !anf) batch.use_compiled = !compileShiftRegister(&batch.compiled, reg, getCacheBudget());
+    struct timespec start, finish;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (batch.binary_input ? processBinaryInput(&batch) : processTextInput(&batch)) {
+        fprintf(stderr, "Ошибка при обработке входа.\n");
+        rc = -5;
+    }
+    if (!batch.binary_output) fputc('\n', batch.output);
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+    double seconds = (finish.tv_sec - start.tv_sec) + (finish.tv_nsec - start.tv_nsec) / 1e9;
+    fprintf(
+        stderr, "Обработано %" PRIu64 " битов за %.3f с (%.1f Мбит/с).\n",
+        batch.num_of_bits, seconds, seconds > 0 ? batch.num_of_bits / seconds / 1e6 : 0.0
+    );
+    if (batch.complexity)
+        fprintf(
+            stderr, "Линейная сложность выхода: %" PRIu64 " (по %" PRIu64 " битам).\n",
+            getLinearComplexity(batch.complexity), batch.complexity->num_of_bits
+        );
+    if (connection_polynomial) {
+        fprintf(stderr, "Многочлен связи: ");
+        printConnectionPolynomial(batch.complexity, stderr);
+        fputc('\n', stderr);
+    }
+    if (batch.use_compiled) freeCompiledShiftRegister(&batch.compiled);
 end:
+    closeBatchFiles(&batch);
+    if (batch.complexity) freeLinearComplexity(batch.complexity);
+    free(batch.x);
+    free(batch.y);
+    free(batch.buffer);
+    free(batch.text);
+    return rc;
+}
+
+int main(int argc, char **argv) {
+    argc = takeAllocOptions(argc, argv);
+    if (argc < 2 || (argc > 2 && (argc < 5 || strcmp(argv[2], "--batch")))) {
+        printUsage(argv[0]);
+        return 0;
+    }
+    struct ShiftRegister reg;
+    struct ANFShiftRegister anf;
+    int rc;
+    // Регистры длины не больше 32 переводятся в таблицы, они быстрее.
+    if (isANFShiftRegisterFile(argv[1])) {
+        if (initANFShiftRegisterFromFile(&anf, argv[1])) return -1;
+        if (anf.length > 32) {
+            rc = argc > 2 ? batch(NULL, &anf, argc, argv) : interactiveANF(&anf);
+            freeANFShiftRegister(&anf);
+            return rc;
+        }
+        rc = anfToShiftRegister(&reg, &anf);
+        freeANFShiftRegister(&anf);
+        if (rc) return -1;
+    } else if (initShiftRegisterFromFile(&reg, argv[1])) return -1;
+    rc = argc > 2 ? batch(&reg, NULL, argc, argv) : interactive(&reg);
     freeShiftRegister(&reg);
     return rc;
-}
\ No newline at end of file
+}
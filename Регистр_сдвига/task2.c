@@ -1,19 +1,82 @@
-#include "ShiftRegister.h"
+#include "ExternalPartition.h"
+#include "Partition.h"
+#include "Alloc.h"
+#include <stdlib.h>
+#include <inttypes.h>
+#include <unistd.h>
+
+static void printUsage(char *name) {
+    printf(
+        "Использование: %s <файл_настроек> [--threads <число>] [--verbose] [--output <файл> [--rounds]]"
+        " [--external <каталог> [--memory <МиБ>]] [--huge-pages] [--numa-interleave]\n"
+        "--verbose печатает классы каждого шага и итоговые классы, --output записывает номера\n"
+        "классов состояний в двоичный файл (с --rounds - и число классов на каждом шаге).\n"
+        "--external минимизирует во внешней памяти: массивы по состояниям лежат в файлах\n"
+        "каталога (24 байта на состояние), в памяти - не больше --memory МиБ на сортировку.\n",
+        name
+    );
+}
 
 int main(int argc, char **argv) {
+    argc = takeAllocOptions(argc, argv);
     if (argc < 2) {
-        printf("Использование: %s <файл_настроек>\n", argv[0]);
+        printUsage(argv[0]);
         return 0;
     }
+    long num_of_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    uint8_t flags = 0, with_rounds = 0, with_memory = 0;
+    const char *output_file = NULL, *directory = NULL;
+    uint64_t memory_limit = 0;
+    for (int i = 2; i < argc; ++i) {
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc) num_of_threads = atol(argv[++i]);
+        else if (!strcmp(argv[i], "--output") && i + 1 < argc) output_file = argv[++i];
+        else if (!strcmp(argv[i], "--external") && i + 1 < argc) directory = argv[++i];
+        else if (!strcmp(argv[i], "--memory") && i + 1 < argc) {
+            memory_limit = strtoull(argv[++i], NULL, 10) << 20;
+            with_memory = 1;
+        } else if (!strcmp(argv[i], "--verbose")) flags |= MINIMIZE_PRINT_ROUNDS | MINIMIZE_CLASS_LIST;
+        else if (!strcmp(argv[i], "--rounds")) with_rounds = 1;
+        else {
+            printUsage(argv[0]);
+            return -4;
+        }
+    }
+    if ((with_rounds && !output_file) || (with_memory && !directory)) {
+        printUsage(argv[0]);
+        return -4;
+    }
+    if (num_of_threads < 1) num_of_threads = 1;
+    if (output_file) flags |= MINIMIZE_CLASS_ARRAY;
+    if (directory && (flags & MINIMIZE_CLASS_LIST)) {
+        printf("--verbose во внешней памяти не поддерживается\n");
+        return -4;
+    }
     struct ShiftRegister reg;
     if (initShiftRegisterFromFile(&reg, argv[1])) return -1;
+    if (!directory && reg.length > PARTITION_MAX_LENGTH) {
+        printf("Регистр длины %" PRIu8 " минимизируется только во внешней памяти (--external)\n", reg.length);
+        freeShiftRegister(&reg);
+        return -4;
+    }
     struct Minimized minimized;
-    if (minimizeShiftRegister(&minimized, &reg))    {
+    if (directory) {
+        const int external_rc = minimizeShiftRegisterExternally(&minimized, &reg, directory, memory_limit, flags);
+        if (external_rc) {
+            if (external_rc == -2) printf("Не удалось создать временные файлы в %s\n", directory);
+            freeShiftRegister(&reg);
+            return -2;
+        }
+    } else if (minimizeShiftRegisterInThreads(&minimized, &reg, (unsigned)num_of_threads, flags)) {
         freeShiftRegister(&reg);
         return -2;
     }
     printMinimized(&minimized);
+    int rc = 0;
+    if (output_file && saveMinimizedToFile(&minimized, output_file, with_rounds)) {
+        printf("Не удалось записать классы в %s\n", output_file);
+        rc = -3;
+    }
     freeShiftRegister(&reg);
     freeMinimized(&minimized);
-    return 0;
-}
\ No newline at end of file
+    return rc;
+}
@@ -1,8 +1,10 @@
-#include "ShiftRegister.h"
+#include "StateGraph.h"
+#include "Alloc.h"
 
 int main(int argc, char **argv) {
+    argc = takeAllocOptions(argc, argv);
     if (argc < 2) {
-        printf("Использование: %s <файл_настроек> [--print-search-log]\n", argv[0]);
+        printf("Использование: %s <файл_настроек> [--print-search-log] [--huge-pages] [--numa-interleave]\n", argv[0]);
         return 0;
     }
     uint8_t print_search_log = 0;
@@ -15,15 +17,10 @@ int main(int argc, char **argv) {
     }
     struct ShiftRegister reg;
     if (initShiftRegisterFromFile(&reg, argv[1])) return -1;
-    struct Graph graph;
-    if (shiftRegisterToGraph(&reg, &graph)) {
-        freeShiftRegister(&reg);
-        return -2;
-    }
-    if (print_search_log) printGraph(&graph);
+    if (print_search_log) printShiftRegisterGraph(&reg);
     int rc = 0;
     List components;
-    if (getStronglyConnectedComponents(&graph, &components)) {
+    if (getShiftRegisterStronglyConnectedComponents(&reg, &components)) {
         rc = -3;
         goto end;
     }
@@ -36,8 +33,7 @@ int main(int argc, char **argv) {
         goto end;
     }
     deepClearList(&components, (FreeValueFunction)clearList);
-    makeUnoriented(&graph);
-    if (getComponents(&graph, &components)) {
+    if (getShiftRegisterComponents(&reg, &components)) {
         rc = -4;
         goto end;
     }
@@ -48,6 +44,5 @@ int main(int argc, char **argv) {
     deepClearList(&components, (FreeValueFunction)clearList);
 end:
     freeShiftRegister(&reg);
-    freeGraph(&graph);
     return rc;
 }
\ No newline at end of file